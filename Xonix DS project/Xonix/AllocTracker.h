@@ -0,0 +1,181 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <dbghelp.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "dbghelp.lib")
+#endif
+#elif defined(__GLIBC__)
+#include <execinfo.h>
+#endif
+
+
+////////////////////////////////  ALLOCATION TRACKER /////////////////////////////////////
+
+// Counts heap allocations per thread, so a frame can be checked for making any.
+// With XONIX_ALLOC_TRACK=1 (the default in debug builds) Xonix.cpp replaces the
+// global operator new with one that calls noteAlloc(). Every allocation bumps
+// the calling thread's counter; while the thread is recording, it is also
+// filed under its call stack (DEPTH frames) in a fixed table, and report()
+// prints the busiest stacks with symbols where the platform can give them.
+// Nothing here allocates through new, so it is safe to call from inside it.
+// Allocations made inside SFML's DLLs go through their own CRT and are not
+// seen; link SFML statically to count those too.
+
+#ifndef XONIX_ALLOC_TRACK
+#ifdef _DEBUG
+#define XONIX_ALLOC_TRACK 1
+#else
+#define XONIX_ALLOC_TRACK 0
+#endif
+#endif
+
+class AllocTracker {
+public:
+    static const int DEPTH = 6;      // stack frames kept per site
+    static const int SITES = 512;    // distinct sites per thread, must be a power of two
+
+    struct Site {
+        uint64_t key;                // 0 = empty slot
+        uint64_t count, bytes;
+        void* frames[DEPTH];
+        int depth;
+    };
+
+private:
+    struct State {
+        uint64_t allocs, bytes, unfiled;
+        bool recording, inside;
+        Site* sites;                 // calloc'd on first use, never freed
+    };
+
+    static State& local() {
+        static thread_local State s;   // plain data: zero-initialized, no constructor
+        return s;
+    }
+
+    static int capture(void** frames) {
+#ifdef _WIN32
+        return CaptureStackBackTrace(2, DEPTH, frames, nullptr);   // skip noteAlloc and operator new
+#elif defined(__GLIBC__)
+        void* all[DEPTH + 2];
+        int n = backtrace(all, DEPTH + 2) - 2;
+        for (int i = 0; i < n; ++i) frames[i] = all[i + 2];
+        return n > 0 ? n : 0;
+#else
+        (void)frames;
+        return 0;
+#endif
+    }
+
+    static void printFrames(FILE* out, void* const* frames, int depth) {
+#ifdef _WIN32
+        static bool symbolsReady = SymInitialize(GetCurrentProcess(), nullptr, TRUE) != FALSE;
+        for (int i = 0; i < depth; ++i) {
+            char buf[sizeof(SYMBOL_INFO) + 256];
+            SYMBOL_INFO* sym = (SYMBOL_INFO*)buf;
+            sym->SizeOfStruct = sizeof(SYMBOL_INFO);
+            sym->MaxNameLen = 255;
+            IMAGEHLP_LINE64 line = { sizeof(IMAGEHLP_LINE64) };
+            DWORD lineOffset = 0;
+            DWORD64 addr = (DWORD64)frames[i];
+            bool named = symbolsReady && SymFromAddr(GetCurrentProcess(), addr, nullptr, sym);
+            if (named && SymGetLineFromAddr64(GetCurrentProcess(), addr, &lineOffset, &line))
+                std::fprintf(out, "      %s  %s:%lu\n", sym->Name, line.FileName, line.LineNumber);
+            else if (named) std::fprintf(out, "      %s\n", sym->Name);
+            else std::fprintf(out, "      %p\n", frames[i]);
+        }
+#elif defined(__GLIBC__)
+        std::fflush(out);
+        backtrace_symbols_fd(frames, depth, fileno(out));
+#else
+        for (int i = 0; i < depth; ++i) std::fprintf(out, "      %p\n", frames[i]);
+#endif
+    }
+
+public:
+    // Called by the replaced operator new for every allocation.
+    static void noteAlloc(size_t size) {
+        State& s = local();
+        ++s.allocs;
+        s.bytes += size;
+        if (!s.recording || s.inside) return;
+        s.inside = true;   // the stack walk may allocate the first time; don't recurse
+        if (!s.sites) s.sites = (Site*)std::calloc(SITES, sizeof(Site));
+        void* frames[DEPTH];
+        int depth = s.sites ? capture(frames) : 0;
+        uint64_t key = 1469598103934665603ull;
+        for (int i = 0; i < depth; ++i) key = (key ^ (uint64_t)(uintptr_t)frames[i]) * 1099511628211ull;
+        key |= 1;
+        bool filed = false;
+        for (int probe = 0; depth > 0 && probe < SITES; ++probe) {
+            Site& site = s.sites[(key + probe) & (SITES - 1)];
+            if (site.key == 0) {
+                site.key = key;
+                site.depth = depth;
+                for (int i = 0; i < depth; ++i) site.frames[i] = frames[i];
+            }
+            if (site.key != key) continue;
+            ++site.count;
+            site.bytes += size;
+            filed = true;
+            break;
+        }
+        if (!filed) ++s.unfiled;
+        s.inside = false;
+    }
+
+    // Allocations the calling thread has made so far; the difference across a
+    // frame is that frame's count. Always 0 without XONIX_ALLOC_TRACK.
+    static uint64_t count() { return local().allocs; }
+    static uint64_t bytes() { return local().bytes; }
+
+    // Start or stop filing this thread's allocations by call stack.
+    static void record(bool on) { local().recording = on; }
+
+    static void clearSites() {
+        State& s = local();
+        if (s.sites) for (int i = 0; i < SITES; ++i) s.sites[i].key = 0;
+        s.unfiled = 0;
+    }
+
+    // The top call stacks filed on this thread while recording, busiest first.
+    static void report(FILE* out, int top) {
+        State& s = local();
+        bool wasRecording = s.recording;
+        s.recording = false;
+        if (s.sites) {
+            uint64_t ceiling = UINT64_MAX;
+            const Site* last = nullptr;
+            for (int n = 0; n < top; ++n) {
+                // next busiest site below the one just printed (ties go by table order)
+                const Site* best = nullptr;
+                bool passedLast = last == nullptr;
+                for (int i = 0; i < SITES; ++i) {
+                    const Site& site = s.sites[i];
+                    if (&site == last) { passedLast = true; continue; }
+                    if (!site.key || site.count > ceiling || (site.count == ceiling && !passedLast)) continue;
+                    if (!best || site.count > best->count) best = &site;
+                }
+                if (!best) break;
+                std::fprintf(out, "  %llu allocations, %llu bytes from:\n",
+                    (unsigned long long)best->count, (unsigned long long)best->bytes);
+                printFrames(out, best->frames, best->depth);
+                ceiling = best->count;
+                last = best;
+            }
+        }
+        if (s.unfiled) std::fprintf(out, "  %llu allocations without a stack\n", (unsigned long long)s.unfiled);
+        s.recording = wasRecording;
+    }
+};
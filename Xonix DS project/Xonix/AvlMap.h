@@ -0,0 +1,296 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+////////////////////////////////  AVL MAP /////////////////////////////////////
+
+// Ordered key -> value map backed by an AVL tree.
+//  - Nodes live in one contiguous vector and are linked by 32-bit indices;
+//    erased slots go on a free list and are reused by the next insert.
+//  - find / insert / erase are iterative (parent links, no recursion).
+//  - assignSorted builds a perfectly balanced tree from sorted input in O(n).
+// Inserting may grow the pool, which invalidates references into the map
+// (iterators stay valid since they hold indices). Erasing a node with two
+// children moves its in-order successor's entry into its slot.
+
+template<typename K, typename V, typename Compare = std::less<K>>
+class AvlMap {
+public:
+    typedef std::pair<K, V> value_type;   // key must not be modified through an iterator
+
+private:
+    static const int32_t NIL = -1;
+
+    struct Node {
+        value_type kv;
+        int32_t left, right, parent;
+        int32_t height;   // 0 marks a slot on the free list
+    };
+
+    std::vector<Node> pool;
+    int32_t root = NIL;
+    int32_t freeHead = NIL;   // free slots chained through Node::left
+    size_t count = 0;
+    Compare less;
+
+    int32_t heightOf(int32_t n) const { return n == NIL ? 0 : pool[n].height; }
+
+    void updateHeight(int32_t n) {
+        int32_t lh = heightOf(pool[n].left), rh = heightOf(pool[n].right);
+        pool[n].height = 1 + (lh > rh ? lh : rh);
+    }
+
+    int32_t balanceOf(int32_t n) const { return heightOf(pool[n].left) - heightOf(pool[n].right); }
+
+    int32_t allocNode(value_type&& kv, int32_t parent) {
+        int32_t n;
+        if (freeHead != NIL) {
+            n = freeHead;
+            freeHead = pool[n].left;
+            pool[n].kv = std::move(kv);
+        }
+        else {
+            n = (int32_t)pool.size();
+            pool.push_back(Node{ std::move(kv), NIL, NIL, NIL, 0 });
+        }
+        Node& node = pool[n];
+        node.left = node.right = NIL;
+        node.parent = parent;
+        node.height = 1;
+        return n;
+    }
+
+    void freeNode(int32_t n) {
+        pool[n].kv = value_type();   // release whatever the entry owned
+        pool[n].height = 0;
+        pool[n].parent = pool[n].right = NIL;
+        pool[n].left = freeHead;
+        freeHead = n;
+    }
+
+    // Points whatever referenced oldChild (parent link or root) at newChild.
+    void replaceChild(int32_t parent, int32_t oldChild, int32_t newChild) {
+        if (parent == NIL) root = newChild;
+        else if (pool[parent].left == oldChild) pool[parent].left = newChild;
+        else pool[parent].right = newChild;
+        if (newChild != NIL) pool[newChild].parent = parent;
+    }
+
+    int32_t rotateLeft(int32_t x) {
+        int32_t y = pool[x].right;
+        int32_t t2 = pool[y].left;
+        replaceChild(pool[x].parent, x, y);
+        pool[y].left = x; pool[x].parent = y;
+        pool[x].right = t2; if (t2 != NIL) pool[t2].parent = x;
+        updateHeight(x);
+        updateHeight(y);
+        return y;
+    }
+
+    int32_t rotateRight(int32_t y) {
+        int32_t x = pool[y].left;
+        int32_t t2 = pool[x].right;
+        replaceChild(pool[y].parent, y, x);
+        pool[x].right = y; pool[y].parent = x;
+        pool[y].left = t2; if (t2 != NIL) pool[t2].parent = y;
+        updateHeight(y);
+        updateHeight(x);
+        return x;
+    }
+
+    // Walks from n towards the root fixing heights and rotating where unbalanced.
+    // Stops as soon as a subtree comes out with its old height, since nothing
+    // above it can have changed.
+    void rebalanceFrom(int32_t n) {
+        while (n != NIL) {
+            int32_t oldHeight = pool[n].height;
+            updateHeight(n);
+            int32_t bal = balanceOf(n);
+            if (bal > 1) {
+                if (balanceOf(pool[n].left) < 0) rotateLeft(pool[n].left);
+                n = rotateRight(n);
+            }
+            else if (bal < -1) {
+                if (balanceOf(pool[n].right) > 0) rotateRight(pool[n].right);
+                n = rotateLeft(n);
+            }
+            if (pool[n].height == oldHeight) return;
+            n = pool[n].parent;
+        }
+    }
+
+    int32_t minNode(int32_t n) const {
+        if (n == NIL) return NIL;
+        while (pool[n].left != NIL) n = pool[n].left;
+        return n;
+    }
+
+    int32_t successor(int32_t n) const {
+        if (pool[n].right != NIL) return minNode(pool[n].right);
+        int32_t p = pool[n].parent;
+        while (p != NIL && pool[p].right == n) { n = p; p = pool[p].parent; }
+        return p;
+    }
+
+    int32_t findNode(const K& key) const {
+        int32_t n = root;
+        while (n != NIL) {
+            const K& nk = pool[n].kv.first;
+            if (less(key, nk)) n = pool[n].left;
+            else if (less(nk, key)) n = pool[n].right;
+            else return n;
+        }
+        return NIL;
+    }
+
+    // Builds a balanced subtree over sorted[lo, hi); depth of recursion is log2(n).
+    template<typename It>
+    int32_t buildRange(It first, size_t lo, size_t hi, int32_t parent) {
+        if (lo >= hi) return NIL;
+        size_t mid = lo + (hi - lo) / 2;
+        It at = first;
+        std::advance(at, mid);
+        int32_t n = allocNode(value_type(*at), parent);
+        int32_t l = buildRange(first, lo, mid, n);
+        int32_t r = buildRange(first, mid + 1, hi, n);
+        pool[n].left = l;
+        pool[n].right = r;
+        updateHeight(n);
+        return n;
+    }
+
+public:
+    template<bool IsConst>
+    class Iter {
+        friend class AvlMap;
+        friend class Iter<!IsConst>;
+        typedef typename std::conditional<IsConst, const AvlMap*, AvlMap*>::type Owner;
+        Owner map;
+        int32_t n;
+        Iter(Owner m, int32_t idx) : map(m), n(idx) {}
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename AvlMap::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef typename std::conditional<IsConst, const value_type&, value_type&>::type reference;
+        typedef typename std::conditional<IsConst, const value_type*, value_type*>::type pointer;
+
+        Iter() : map(nullptr), n(NIL) {}
+        // iterator -> const_iterator
+        template<bool C, typename = typename std::enable_if<IsConst && !C>::type>
+        Iter(const Iter<C>& o) : map(o.map), n(o.n) {}
+        reference operator*() const { return map->pool[n].kv; }
+        pointer operator->() const { return &map->pool[n].kv; }
+        Iter& operator++() { n = map->successor(n); return *this; }
+        Iter operator++(int) { Iter t = *this; ++*this; return t; }
+        bool operator==(const Iter& o) const { return n == o.n; }
+        bool operator!=(const Iter& o) const { return n != o.n; }
+    };
+    typedef Iter<false> iterator;
+    typedef Iter<true> const_iterator;
+
+    AvlMap() {}
+    explicit AvlMap(const Compare& cmp) : less(cmp) {}
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    int height() const { return heightOf(root); }
+
+    // Pre-sizes the node pool so n entries fit without reallocating.
+    void reserve(size_t n) { pool.reserve(n); }
+
+    void clear() {
+        pool.clear();
+        root = freeHead = NIL;
+        count = 0;
+    }
+
+    iterator begin() { return iterator(this, minNode(root)); }
+    iterator end() { return iterator(this, NIL); }
+    const_iterator begin() const { return const_iterator(this, minNode(root)); }
+    const_iterator end() const { return const_iterator(this, NIL); }
+
+    iterator find(const K& key) { return iterator(this, findNode(key)); }
+    const_iterator find(const K& key) const { return const_iterator(this, findNode(key)); }
+    bool contains(const K& key) const { return findNode(key) != NIL; }
+
+    // Returns the value for key, or nullptr. The pointer is invalidated by insert.
+    V* get(const K& key) { int32_t n = findNode(key); return n == NIL ? nullptr : &pool[n].kv.second; }
+    const V* get(const K& key) const { int32_t n = findNode(key); return n == NIL ? nullptr : &pool[n].kv.second; }
+
+    // First entry whose key is not less than key.
+    const_iterator lowerBound(const K& key) const {
+        int32_t n = root, best = NIL;
+        while (n != NIL) {
+            if (less(pool[n].kv.first, key)) n = pool[n].right;
+            else { best = n; n = pool[n].left; }
+        }
+        return const_iterator(this, best);
+    }
+
+    // Inserts (key, value) unless key is present; .second is false for duplicates.
+    std::pair<iterator, bool> insert(const K& key, V value) {
+        int32_t parent = NIL, n = root;
+        bool goLeft = false;
+        while (n != NIL) {
+            parent = n;
+            const K& nk = pool[n].kv.first;
+            if (less(key, nk)) { n = pool[n].left; goLeft = true; }
+            else if (less(nk, key)) { n = pool[n].right; goLeft = false; }
+            else return std::make_pair(iterator(this, n), false);
+        }
+        int32_t fresh = allocNode(value_type(key, std::move(value)), parent);
+        if (parent == NIL) root = fresh;
+        else if (goLeft) pool[parent].left = fresh;
+        else pool[parent].right = fresh;
+        ++count;
+        rebalanceFrom(parent);
+        return std::make_pair(iterator(this, fresh), true);
+    }
+
+    // Removes key if present; returns whether anything was removed.
+    bool erase(const K& key) {
+        int32_t z = findNode(key);
+        if (z == NIL) return false;
+        if (pool[z].left != NIL && pool[z].right != NIL) {
+            // two children: pull the in-order successor's entry up, unlink the successor
+            int32_t s = minNode(pool[z].right);
+            pool[z].kv = std::move(pool[s].kv);
+            z = s;
+        }
+        int32_t child = pool[z].left != NIL ? pool[z].left : pool[z].right;
+        int32_t parent = pool[z].parent;
+        replaceChild(parent, z, child);
+        freeNode(z);
+        --count;
+        rebalanceFrom(parent);
+        return true;
+    }
+
+    // Replaces the contents with [first, last) of (key, value) pairs, which
+    // should be sorted by key with no duplicates. O(n) for random-access
+    // input; unsorted input falls back to one-by-one inserts.
+    template<typename It>
+    void assignSorted(It first, It last) {
+        clear();
+        size_t n = (size_t)std::distance(first, last);
+        bool sorted = true;
+        for (It a = first, b = first; a != last; a = b) {
+            if (++b == last) break;
+            if (!less((*a).first, (*b).first)) { sorted = false; break; }
+        }
+        pool.reserve(n);
+        if (!sorted) {
+            for (It it = first; it != last; ++it)
+                insert((*it).first, (*it).second);
+            return;
+        }
+        root = buildRange(first, 0, n, NIL);
+        count = n;
+    }
+};
@@ -0,0 +1,345 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "Board.h"
+#include "ChunkedBoard.h"
+#include "InputQueue.h"
+#include "RoomWorld.h"
+#include "TimerWheel.h"
+
+
+////////////////////////////////  BIG MAP WORLD /////////////////////////////////////
+
+// Single-player Xonix on a ChunkedBoard of any size, for event maps far larger
+// than the screen. Rules are the single-player ones: one step per press on a
+// wall, sliding off it, and a capture fills every open region no enemy is in.
+//
+// Only the active chunks (the viewport plus ACTIVE_MARGIN chunks around it,
+// see setViewport()) are simulated: enemies elsewhere sleep where they are.
+// Enemies are kept in a list per chunk, so a tick touches the active chunks
+// and nothing else, whatever the map holds.
+//
+// A capture only looks at the region the trail cut in two. Every open region
+// holds an enemy (a capture fills the ones that don't), so after the cut the
+// pieces of that region are flooded side by side, a batch of cells at a time:
+// a piece stops as soon as it reaches an enemy, and once every piece but one
+// is enclosed and enemy-free the last one must hold the region's enemies and
+// is never flooded at all. The work follows the enclosed area, not the map.
+
+struct BigMapWorld {
+    static const int STEP_TICKS = 5;       // player moves every 5th tick, as in RoomWorld
+    static const int FREEZE_TICKS = 180;   // 3 s
+    static const int ACTIVE_MARGIN = 1;    // chunks simulated past each edge of the viewport
+    static const int8_t TRAIL = 2;
+
+    enum TimerKind : uint8_t { THAW = 1 };
+
+    struct Enemy {
+        int x, y, dx, dy;       // pixels, as Enemy in Xonix.cpp
+        int chunk;              // chunk list it is on
+        int prev, next;         // neighbours on that list, -1 at the ends
+        uint32_t movedOn;       // tick it last moved, so a chunk change can't move it twice
+    };
+    struct Cell { int r, c; };
+    struct CaptureStats {
+        int regions;            // pieces the flood started from
+        int filled;             // open cells captured
+        int visited;            // open cells the flood touched
+        int chunks;             // chunks the flood touched
+    };
+
+    ChunkedBoard board;
+    std::vector<Enemy> enemies;
+    std::vector<int> chunkHead;   // first enemy on each chunk's list, -1 for none
+    int px, py, dx, dy;
+    bool alive, drawing, frozen;
+    uint32_t tickNo;
+    TimerWheel<8> timers;   // timed effects, due on tickNo
+    int stepTimer;
+    uint32_t rng;
+    InputQueue turns;
+    ScoreCounter points;
+    std::vector<Cell> trail;
+    int activeR0, activeC0, activeR1, activeC1;   // active chunks, inclusive
+    CaptureStats lastCapture;
+
+private:
+    // Capture scratch, kept between captures so a long game stops allocating.
+    struct Region {
+        std::vector<Cell> cells;      // every cell flooded so far
+        std::vector<Cell> frontier;   // cells still to expand, from head on
+        size_t head;
+        int parent;                   // union-find: pieces that meet are one region
+        bool alive;                   // holds an enemy
+    };
+    struct MarkChunk { uint32_t id[ChunkedBoard::SIZE * ChunkedBoard::SIZE]; };
+    std::vector<Region> regions;
+    int regionCount = 0;
+    std::vector<uint32_t*> marks;                  // region id + 1 per cell, per chunk; null if untouched
+    std::vector<std::unique_ptr<MarkChunk>> markPool;
+    size_t markPoolUsed = 0;
+    std::vector<int> touched;                      // chunks with marks
+    std::vector<int> moving;
+
+public:
+    uint32_t nextRand() {   // xorshift32, as RoomWorld
+        rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+        return rng;
+    }
+
+    // A fresh rows x cols map with enemyCount enemies scattered over it.
+    void reset(int rows, int cols, int enemyCount, uint32_t seed) {
+        board.reset(rows, cols);
+        const size_t chunkCount = (size_t)board.chunkRows() * board.chunkCols();
+        chunkHead.assign(chunkCount, -1);
+        marks.assign(chunkCount, nullptr);
+        rng = seed ? seed : 0x9e3779b9u;
+        enemies.resize(enemyCount < 1 ? 1 : enemyCount);
+        for (size_t k = 0; k < enemies.size(); ++k) {
+            Enemy& e = enemies[k];
+            e.x = (1 + (int)(nextRand() % (cols - 2))) * ts + ts / 2;
+            e.y = (1 + (int)(nextRand() % (rows - 2))) * ts + ts / 2;
+            e.dx = 4 - (int)(nextRand() % 8);
+            e.dy = 4 - (int)(nextRand() % 8);
+            if (e.dx == 0 && e.dy == 0) e.dx = 1;
+            e.movedOn = 0;
+            link((int)k, board.chunkIndex(e.y / ts, e.x / ts));
+        }
+        px = 10; py = 0; dx = dy = 0;
+        alive = true; drawing = frozen = false;
+        tickNo = 0;
+        timers.reset(0);
+        stepTimer = 0;
+        turns.clear();
+        points = ScoreCounter();
+        trail.clear();
+        lastCapture = CaptureStats();
+        setViewport(0, 0, rows - 1, cols - 1);
+    }
+
+    // The cells on screen, inclusive; the active chunks are these plus the margin.
+    void setViewport(int r0, int c0, int r1, int c1) {
+        const int S = ChunkedBoard::SHIFT;
+        activeR0 = clampTo((r0 >> S) - ACTIVE_MARGIN, 0, board.chunkRows() - 1);
+        activeC0 = clampTo((c0 >> S) - ACTIVE_MARGIN, 0, board.chunkCols() - 1);
+        activeR1 = clampTo((r1 >> S) + ACTIVE_MARGIN, 0, board.chunkRows() - 1);
+        activeC1 = clampTo((c1 >> S) + ACTIVE_MARGIN, 0, board.chunkCols() - 1);
+    }
+
+    void press(int8_t tx, int8_t ty, uint64_t stampNs) { if (alive) turns.push(tx, ty, stampNs); }
+
+    bool freeze() {
+        if (!alive || frozen || !points.use()) return false;
+        frozen = true;
+        timers.schedule(tickNo + FREEZE_TICKS, THAW);
+        return true;
+    }
+
+    // One 60 Hz frame.
+    void tick() {
+        ++tickNo;
+        timers.advance(tickNo, [this](uint8_t kind, uint8_t) { if (kind == THAW) frozen = false; });
+        if (!alive) return;
+        if (++stepTimer >= STEP_TICKS) {
+            stepTimer = 0;
+            stepPlayer();
+        }
+        if (alive && drawing && board.get(py, px) == 1) capture();
+        if (alive && !frozen) moveEnemies();
+    }
+
+private:
+    static int clampTo(int v, int lo, int hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+    void link(int k, int chunk) {
+        Enemy& e = enemies[k];
+        e.chunk = chunk;
+        e.prev = -1;
+        e.next = chunkHead[chunk];
+        if (e.next >= 0) enemies[e.next].prev = k;
+        chunkHead[chunk] = k;
+    }
+
+    void unlink(int k) {
+        Enemy& e = enemies[k];
+        if (e.prev >= 0) enemies[e.prev].next = e.next; else chunkHead[e.chunk] = e.next;
+        if (e.next >= 0) enemies[e.next].prev = e.prev;
+    }
+
+    void stepPlayer() {
+        TimedTurn turn;
+        bool turned = turns.pop(turn);
+        if (turned) { dx = turn.dx; dy = turn.dy; }
+        if (board.get(py, px) != 1 || turned) {
+            px = clampTo(px + dx, 0, board.cols() - 1);
+            py = clampTo(py + dy, 0, board.rows() - 1);
+        }
+        int8_t v = board.get(py, px);
+        if (v == 0) {
+            board.set(py, px, TRAIL);
+            trail.push_back(Cell{ py, px });
+            drawing = true;
+        }
+        else if (v == TRAIL && drawing) alive = false;
+    }
+
+    // Enemies bounce off walls as RoomWorld::moveEnemy; touching the trail ends the game.
+    void moveEnemies() {
+        moving.clear();
+        for (int cr = activeR0; cr <= activeR1; ++cr)
+            for (int cc = activeC0; cc <= activeC1; ++cc)
+                for (int k = chunkHead[cr * board.chunkCols() + cc]; k >= 0; k = enemies[k].next)
+                    moving.push_back(k);
+        const int rows = board.rows(), cols = board.cols();
+        for (int k : moving) {
+            Enemy& e = enemies[k];
+            if (e.movedOn == tickNo) continue;
+            e.movedOn = tickNo;
+            e.x += e.dx;
+            int gy = e.y / ts, gx = e.x / ts;
+            if (gx <= 0 || gx >= cols - 1 || board.get(gy, gx) == 1) { e.dx = -e.dx; e.x += e.dx; }
+            e.y += e.dy;
+            gy = e.y / ts; gx = e.x / ts;
+            if (gy <= 0 || gy >= rows - 1 || board.get(gy, gx) == 1) { e.dy = -e.dy; e.y += e.dy; }
+            gy = e.y / ts; gx = e.x / ts;
+            int chunk = board.chunkIndex(gy, gx);
+            if (chunk != e.chunk) { unlink(k); link(k, chunk); }
+            if (board.get(gy, gx) == TRAIL) { alive = false; return; }
+        }
+    }
+
+    bool enemyAt(int r, int c) const {
+        for (int k = chunkHead[board.chunkIndex(r, c)]; k >= 0; k = enemies[k].next)
+            if (enemies[k].y / ts == r && enemies[k].x / ts == c) return true;
+        return false;
+    }
+
+    uint32_t& mark(int r, int c) {
+        int chunk = board.chunkIndex(r, c);
+        uint32_t*& m = marks[chunk];
+        if (!m) {
+            if (markPoolUsed == markPool.size()) markPool.emplace_back(new MarkChunk);
+            m = markPool[markPoolUsed++]->id;
+            memset(m, 0, sizeof(MarkChunk));
+            touched.push_back(chunk);
+        }
+        return m[(r & ChunkedBoard::MASK) * ChunkedBoard::SIZE + (c & ChunkedBoard::MASK)];
+    }
+
+    int find(int id) {
+        while (regions[id].parent != id) id = regions[id].parent = regions[regions[id].parent].parent;
+        return id;
+    }
+
+    // Seeds a piece at open cell (r, c), or adds it to the piece of an open
+    // neighbour that is already seeded, so a run of seeds along one side of
+    // the trail starts as one piece.
+    void seed(int r, int c) {
+        const Cell next[4] = { { r - 1, c }, { r + 1, c }, { r, c - 1 }, { r, c + 1 } };
+        int id = -1;
+        for (const Cell& n : next)
+            if (board.get(n.r, n.c) == 0 && mark(n.r, n.c)) { id = find((int)mark(n.r, n.c) - 1); break; }
+        if (id < 0) {
+            if (regionCount == (int)regions.size()) regions.emplace_back();
+            id = regionCount++;
+            Region& g = regions[id];
+            g.cells.clear(); g.frontier.clear(); g.head = 0;
+            g.parent = id;
+            g.alive = false;
+        }
+        Region& g = regions[id];
+        g.alive = g.alive || enemyAt(r, c);
+        g.cells.push_back(Cell{ r, c });
+        g.frontier.push_back(Cell{ r, c });
+        mark(r, c) = (uint32_t)id + 1;
+    }
+
+    // other's cells and unexpanded frontier move into id.
+    void merge(int id, int other) {
+        Region& g = regions[id];
+        Region& o = regions[other];
+        g.cells.insert(g.cells.end(), o.cells.begin(), o.cells.end());
+        g.frontier.insert(g.frontier.end(), o.frontier.begin() + o.head, o.frontier.end());
+        g.alive = g.alive || o.alive;
+        o.parent = id;
+        o.cells.clear(); o.frontier.clear(); o.head = 0;
+    }
+
+    // Expands region id by up to budget cells; stops early once it holds an enemy.
+    void expand(int id, int budget) {
+        Region* g = &regions[id];
+        while (budget-- > 0 && !g->alive && g->head < g->frontier.size()) {
+            const Cell c = g->frontier[g->head++];
+            const Cell next[4] = { { c.r - 1, c.c }, { c.r + 1, c.c }, { c.r, c.c - 1 }, { c.r, c.c + 1 } };
+            for (const Cell& n : next) {
+                if (board.get(n.r, n.c) != 0) continue;   // open cells never touch the map's edge
+                uint32_t& m = mark(n.r, n.c);
+                if (!m) {
+                    m = (uint32_t)id + 1;
+                    g->cells.push_back(n);
+                    g->frontier.push_back(n);
+                    if (enemyAt(n.r, n.c)) g->alive = true;
+                }
+                else {
+                    int other = find((int)m - 1);
+                    if (other != id) merge(id, other);
+                }
+            }
+        }
+    }
+
+    void capture() {
+        const int BATCH = 64;   // cells per piece per round
+        for (const Cell& t : trail) board.set(t.r, t.c, 1);
+
+        regionCount = 0;
+        for (const Cell& t : trail) {
+            const Cell next[4] = { { t.r - 1, t.c }, { t.r + 1, t.c }, { t.r, t.c - 1 }, { t.r, t.c + 1 } };
+            for (const Cell& n : next)
+                if (board.get(n.r, n.c) == 0 && !mark(n.r, n.c)) seed(n.r, n.c);
+        }
+
+        for (;;) {
+            int undecided = 0, lastUndecided = -1;
+            bool anyAlive = false;
+            for (int id = 0; id < regionCount; ++id) {
+                if (regions[id].parent != id) continue;
+                expand(id, BATCH);
+                if (regions[id].parent != id) continue;
+                if (regions[id].alive) anyAlive = true;
+                else if (regions[id].head < regions[id].frontier.size()) { ++undecided; lastUndecided = id; }
+            }
+            if (undecided == 0) break;
+            if (undecided == 1 && !anyAlive) { regions[lastUndecided].alive = true; break; }
+        }
+
+        int filled = 0, visited = 0;
+        for (int id = 0; id < regionCount; ++id) {
+            const Region& g = regions[id];
+            if (g.parent != id) continue;
+            visited += (int)g.cells.size();
+            if (g.alive) continue;
+            for (const Cell& c : g.cells) board.set(c.r, c.c, 1);
+            filled += (int)g.cells.size();
+        }
+
+        for (int chunk : touched) {
+            board.compact(chunk / board.chunkCols(), chunk % board.chunkCols());
+            marks[chunk] = nullptr;
+        }
+        for (const Cell& t : trail) board.compact(t.r >> ChunkedBoard::SHIFT, t.c >> ChunkedBoard::SHIFT);
+        lastCapture.regions = regionCount;
+        lastCapture.filled = filled;
+        lastCapture.visited = visited;
+        lastCapture.chunks = (int)touched.size();
+        touched.clear();
+        markPoolUsed = 0;
+
+        points.add((int)trail.size() + filled);
+        trail.clear();
+        drawing = false;
+        dx = dy = 0;
+    }
+};
@@ -0,0 +1,9 @@
+#pragma once
+
+
+////////////////////////////////  BOARD /////////////////////////////////////
+
+// Playfield size in cells (M rows, N columns) and cell size in pixels.
+// Shared by the windowed game and the headless room worlds.
+
+const int M = 25, N = 40, ts = 18;
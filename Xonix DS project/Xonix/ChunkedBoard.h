@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+
+////////////////////////////////  CHUNKED BOARD /////////////////////////////////////
+
+// A rows x cols playfield (same cell values as grid: 0 open, 1 wall, 2+ trail)
+// stored as SIZE x SIZE chunks. A chunk whose cells are all open or all wall
+// is just a flag in the directory; cells are only allocated for chunks that
+// mix the two, so memory follows the edges of the captured area rather than
+// the area of the map. set() allocates a chunk the first time it changes,
+// and compact() folds a chunk back into a flag once it is uniform again.
+// Freed chunks are kept for reuse, so a long game settles with no allocation.
+// The border is wall, as on the stock board.
+
+class ChunkedBoard {
+public:
+    static const int SHIFT = 6, SIZE = 1 << SHIFT, MASK = SIZE - 1;
+    enum Fill : uint8_t { OPEN_FILL = 0, WALL_FILL = 1, MIXED = 2 };
+
+private:
+    struct Chunk { int8_t cells[SIZE * SIZE]; };
+    struct Slot {
+        uint8_t fill = OPEN_FILL;
+        Chunk* chunk = nullptr;
+    };
+
+    int nRows = 0, nCols = 0, cRows = 0, cCols = 0;
+    std::vector<Slot> dir;                       // cRows x cCols, row-major
+    std::vector<std::unique_ptr<Chunk>> owned;   // every chunk ever allocated
+    std::vector<Chunk*> spare;                   // owned but not in use
+    size_t inUse = 0;
+
+    Chunk* takeChunk() {
+        ++inUse;
+        if (!spare.empty()) { Chunk* c = spare.back(); spare.pop_back(); return c; }
+        owned.emplace_back(new Chunk);
+        return owned.back().get();
+    }
+
+    // Cells of chunk (cr, cc) that lie on the map.
+    int chunkHeight(int cr) const { return cr == cRows - 1 ? nRows - (cr << SHIFT) : SIZE; }
+    int chunkWidth(int cc) const { return cc == cCols - 1 ? nCols - (cc << SHIFT) : SIZE; }
+
+public:
+    ChunkedBoard() {}
+    ChunkedBoard(int rows, int cols) { reset(rows, cols); }
+    ChunkedBoard(const ChunkedBoard&) = delete;
+    ChunkedBoard& operator=(const ChunkedBoard&) = delete;
+
+    // An open rows x cols map with a wall border. Keeps allocated chunks for reuse.
+    void reset(int rows, int cols) {
+        for (Slot& s : dir) if (s.chunk) spare.push_back(s.chunk);
+        inUse = 0;
+        nRows = rows; nCols = cols;
+        cRows = (rows + MASK) >> SHIFT; cCols = (cols + MASK) >> SHIFT;
+        dir.assign((size_t)cRows * cCols, Slot());
+        for (int j = 0; j < cols; ++j) { set(0, j, 1); set(rows - 1, j, 1); }
+        for (int i = 1; i < rows - 1; ++i) { set(i, 0, 1); set(i, cols - 1, 1); }
+    }
+
+    int rows() const { return nRows; }
+    int cols() const { return nCols; }
+    int chunkRows() const { return cRows; }
+    int chunkCols() const { return cCols; }
+    int chunkIndex(int r, int c) const { return (r >> SHIFT) * cCols + (c >> SHIFT); }
+
+    int8_t get(int r, int c) const {
+        const Slot& s = dir[chunkIndex(r, c)];
+        return s.chunk ? s.chunk->cells[(r & MASK) * SIZE + (c & MASK)] : (int8_t)s.fill;
+    }
+
+    void set(int r, int c, int8_t v) {
+        Slot& s = dir[chunkIndex(r, c)];
+        if (!s.chunk) {
+            if (v == (int8_t)s.fill) return;
+            s.chunk = takeChunk();
+            memset(s.chunk->cells, s.fill, sizeof(s.chunk->cells));
+            s.fill = MIXED;
+        }
+        s.chunk->cells[(r & MASK) * SIZE + (c & MASK)] = v;
+    }
+
+    Fill fill(int cr, int cc) const { return (Fill)dir[cr * cCols + cc].fill; }
+
+    // Cells of a MIXED chunk, SIZE per row; null for a uniform one.
+    const int8_t* chunkCells(int cr, int cc) const {
+        const Chunk* c = dir[cr * cCols + cc].chunk;
+        return c ? c->cells : nullptr;
+    }
+
+    // Folds chunk (cr, cc) back into a flag if its on-map cells are all open or all wall.
+    void compact(int cr, int cc) {
+        Slot& s = dir[cr * cCols + cc];
+        if (!s.chunk) return;
+        const int8_t first = s.chunk->cells[0];
+        if (first != 0 && first != 1) return;
+        const int h = chunkHeight(cr), w = chunkWidth(cc);
+        for (int i = 0; i < h; ++i) {
+            const int8_t* row = s.chunk->cells + i * SIZE;
+            for (int j = 0; j < w; ++j) if (row[j] != first) return;
+        }
+        spare.push_back(s.chunk);
+        s.chunk = nullptr;
+        s.fill = (uint8_t)first;
+        --inUse;
+    }
+
+    size_t chunksInUse() const { return inUse; }
+    size_t bytesUsed() const { return owned.size() * sizeof(Chunk) + dir.size() * sizeof(Slot); }
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+#include "GridKernels.h"
+
+
+////////////////////////////////  FLOW FIELD /////////////////////////////////////
+
+// Breadth-first distance field over the single-player grid toward the
+// player's trail and the player. Every open or trail cell stores the
+// direction of its next step toward the nearest target, so any number of
+// hunters share one search and each step is a single lookup.
+// update() only searches again when the target cell or the grid version
+// has changed; the caller bumps its version whenever it writes the grid.
+// The board's shape is a FixedDims (see GridKernels.h), so the field's arrays
+// are sized at compile time like the grid it follows.
+
+template<typename Dims>
+class FlowField {
+public:
+    static const uint16_t UNREACHED = 0xFFFF;
+    static const int ROWS = Dims::ROWS, COLS = Dims::COLS;
+
+private:
+    static_assert(ROWS * COLS <= 0x7FFF, "cell indices are int16_t");
+
+    uint16_t dist[ROWS][COLS];
+    int8_t next[ROWS][COLS];       // 0..3 = left, right, up, down; -1 at a target or where nothing is reachable
+    int16_t queue[ROWS * COLS];    // cell indices, r * COLS + c
+    int lastRow = -1, lastCol = -1;
+    uint32_t lastVersion = 0;
+    bool built = false;
+    uint64_t rebuilds = 0;
+
+    static bool passable(int v) { return v != 1; }   // open (0) or trail (2)
+
+public:
+    // Targets are the trail cells and the player's cell; while the player
+    // stands on a wall the open cells next to it stand in for it.
+    // Returns true if the field was rebuilt.
+    bool update(const int (&grid)[ROWS][COLS], int targetRow, int targetCol, uint32_t gridVersion) {
+        if (built && targetRow == lastRow && targetCol == lastCol && gridVersion == lastVersion) return false;
+        lastRow = targetRow; lastCol = targetCol; lastVersion = gridVersion;
+        built = true;
+        ++rebuilds;
+
+        int head = 0, tail = 0;
+        for (int i = 0; i < ROWS; ++i)
+            for (int j = 0; j < COLS; ++j) {
+                dist[i][j] = UNREACHED;
+                next[i][j] = -1;
+                if (grid[i][j] == 2) { dist[i][j] = 0; queue[tail++] = (int16_t)(i * COLS + j); }
+            }
+        const int dr[4] = { 0, 0, -1, 1 }, dc[4] = { -1, 1, 0, 0 };
+        if (passable(grid[targetRow][targetCol])) {
+            if (dist[targetRow][targetCol]) { dist[targetRow][targetCol] = 0; queue[tail++] = (int16_t)(targetRow * COLS + targetCol); }
+        }
+        else {
+            for (int d = 0; d < 4; ++d) {
+                int r = targetRow + dr[d], c = targetCol + dc[d];
+                if (r < 0 || r >= ROWS || c < 0 || c >= COLS || !passable(grid[r][c]) || !dist[r][c]) continue;
+                dist[r][c] = 0;
+                queue[tail++] = (int16_t)(r * COLS + c);
+            }
+        }
+
+        while (head < tail) {
+            int cell = queue[head++];
+            int r = cell / COLS, c = cell % COLS;
+            for (int d = 0; d < 4; ++d) {
+                int nr = r + dr[d], nc = c + dc[d];
+                if (nr < 0 || nr >= ROWS || nc < 0 || nc >= COLS) continue;
+                if (dist[nr][nc] != UNREACHED || !passable(grid[nr][nc])) continue;
+                dist[nr][nc] = (uint16_t)(dist[r][c] + 1);
+                next[nr][nc] = (int8_t)(d ^ 1);   // back the way the search came
+                queue[tail++] = (int16_t)(nr * COLS + nc);
+            }
+        }
+        return true;
+    }
+
+    // Step direction from a cell toward the nearest target, -1 for none.
+    int direction(int r, int c) const {
+        if (!built || r < 0 || r >= ROWS || c < 0 || c >= COLS) return -1;
+        return next[r][c];
+    }
+
+    uint16_t distance(int r, int c) const { return built ? dist[r][c] : UNREACHED; }
+    uint64_t rebuildCount() const { return rebuilds; }
+};
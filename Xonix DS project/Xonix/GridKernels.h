@@ -0,0 +1,100 @@
+#pragma once
+#include "Board.h"
+
+
+////////////////////////////////  GRID KERNELS /////////////////////////////////////
+
+// The loops that run over a whole board, written once for any board shape.
+// A board is rows x cols ints, row-major, with the grid's values (0 open,
+// 1 wall, 2 trail) and a wall border. The shape comes in as a Dims:
+//  - FixedDims<R, C> has it as compile-time constants, so the row stride folds
+//    into the addressing and the loop bounds are known to the optimizer.
+//    StockDims is the shipped M x N board.
+//  - RuntimeDims carries it in two ints for boards sized at run time.
+// withBoardDims() picks the fixed instantiation when a runtime size matches
+// a shipped one, so callers with a runtime size still get the tuned code.
+
+template<int R, int C>
+struct FixedDims {
+    static const int ROWS = R, COLS = C;
+    int rows() const { return R; }
+    int cols() const { return C; }
+};
+
+struct RuntimeDims {
+    int r, c;
+    int rows() const { return r; }
+    int cols() const { return c; }
+};
+
+typedef FixedDims<M, N> StockDims;
+
+// Calls f(dims) with StockDims for the shipped size and RuntimeDims otherwise.
+template<typename F>
+auto withBoardDims(int rows, int cols, F f) -> decltype(f(StockDims())) {
+    if (rows == M && cols == N) return f(StockDims());
+    return f(RuntimeDims{ rows, cols });
+}
+
+// Open board with a wall border.
+template<typename Dims>
+void resetBoard(int* g, Dims d) {
+    const int R = d.rows(), C = d.cols();
+    for (int i = 0; i < R; i++)
+        for (int j = 0; j < C; j++)
+            g[i * C + j] = (i == 0 || j == 0 || i == R - 1 || j == C - 1) ? 1 : 0;
+}
+
+template<typename Dims>
+int countCells(const int* g, Dims d, int value) {
+    int n = 0;
+    for (int i = 0; i < d.rows() * d.cols(); i++) n += g[i] == value;
+    return n;
+}
+
+// One frame of an enemy (anything with pixel x, y, dx, dy) bouncing off walls.
+template<typename Dims, typename E>
+void bounceEnemy(const int* g, Dims d, E& e) {
+    e.x += e.dx;
+    if (g[(e.y / ts) * d.cols() + e.x / ts] == 1) { e.dx = -e.dx; e.x += e.dx; }
+    e.y += e.dy;
+    if (g[(e.y / ts) * d.cols() + e.x / ts] == 1) { e.dy = -e.dy; e.y += e.dy; }
+}
+
+// Closes a trail: every open cell no enemy can reach and every trail cell
+// become wall, and the number of them is returned (the tiles to score).
+// Same result as flooding from each enemy with drop() and counting before
+// and after, in one flood and one pass. Cells may be any integer type that
+// holds 0, 1 and 2 (the game's ints, the training env's bytes); reached cells
+// are marked with Cell(-1) while it runs. stack needs rows * cols + 1 entries
+// of an index type that can hold rows * cols.
+template<typename Dims, typename Cell, typename E, typename Index>
+int captureBoard(Cell* g, Dims d, const E* enemies, int count, Index* stack) {
+    const int R = d.rows(), C = d.cols();
+    const Cell REACHED = (Cell)-1;
+    for (int k = 0; k < count; k++) {
+        const int r = enemies[k].y / ts, c = enemies[k].x / ts;
+        if (r < 0 || r >= R || c < 0 || c >= C) continue;
+        const int at = r * C + c;
+        if (g[at] == 0) g[at] = REACHED;
+        if (r == 0 || c == 0 || r == R - 1 || c == C - 1) continue;
+        // the enemy's own cell is expanded even if it is wall, as drop() does;
+        // every other cell on the stack is open, so off the border
+        int top = 0;
+        stack[top++] = (Index)at;
+        while (top) {
+            const int p = stack[--top];
+            if (g[p - C] == 0) { g[p - C] = REACHED; stack[top++] = (Index)(p - C); }
+            if (g[p + C] == 0) { g[p + C] = REACHED; stack[top++] = (Index)(p + C); }
+            if (g[p - 1] == 0) { g[p - 1] = REACHED; stack[top++] = (Index)(p - 1); }
+            if (g[p + 1] == 0) { g[p + 1] = REACHED; stack[top++] = (Index)(p + 1); }
+        }
+    }
+    int gained = 0;
+    for (int i = 0; i < R * C; i++) {
+        const Cell v = g[i];
+        gained += (v == 0) | (v == 2);
+        g[i] = v == REACHED ? 0 : 1;
+    }
+    return gained;
+}
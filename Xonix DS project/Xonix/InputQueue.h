@@ -0,0 +1,117 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+
+////////////////////////////////  INPUT QUEUE /////////////////////////////////////
+
+// One player's direction presses, stamped when the game loop read them and
+// consumed one per simulation tick, so two taps inside one tick turn on two
+// consecutive ticks instead of the second overwriting the first.
+// A press equal to the one queued just before it is dropped, which keeps key
+// auto-repeat from building a backlog; a full queue drops the newest press.
+
+struct TimedTurn {
+    int8_t dx, dy;
+    uint64_t stampNs;   // when the key event was read
+};
+
+class InputQueue {
+public:
+    static const int CAPACITY = 8;
+
+private:
+    TimedTurn items[CAPACITY];
+    int head = 0, count = 0;
+
+public:
+    bool push(int8_t dx, int8_t dy, uint64_t stampNs) {
+        if (count == CAPACITY) return false;
+        if (count) {
+            const TimedTurn& last = items[(head + count - 1) % CAPACITY];
+            if (last.dx == dx && last.dy == dy) return false;
+        }
+        // stored field by field: copying in a temporary would copy its
+        // indeterminate padding, and worlds holding a queue compare as bytes
+        TimedTurn& t = items[(head + count) % CAPACITY];
+        t.dx = dx; t.dy = dy; t.stampNs = stampNs;
+        ++count;
+        return true;
+    }
+
+    bool pop(TimedTurn& out) {
+        if (!count) return false;
+        out = items[head];
+        head = (head + 1) % CAPACITY;
+        --count;
+        return true;
+    }
+
+    // Zeroes the slots too, padding included, so two cleared queues compare
+    // equal as bytes.
+    void clear() {
+        std::memset(items, 0, sizeof(items));
+        head = count = 0;
+    }
+    int size() const { return count; }
+};
+
+
+////////////////////////////////  LATENCY HISTOGRAM /////////////////////////////////////
+
+// Latencies in 1 ms buckets up to BUCKETS ms, plus one bucket for anything
+// slower. Adding is a single increment; percentiles are read off the buckets
+// (to the bucket's upper edge), so they are exact to the millisecond.
+
+class LatencyHistogram {
+public:
+    static const int BUCKETS = 250;
+
+private:
+    uint32_t bins[BUCKETS + 1] = {};
+    uint64_t samples = 0, maxNs = 0;
+
+public:
+    void add(uint64_t ns) {
+        uint64_t ms = ns / 1000000;
+        ++bins[ms < (uint64_t)BUCKETS ? ms : BUCKETS];
+        ++samples;
+        if (ns > maxNs) maxNs = ns;
+    }
+
+    void clear() { *this = LatencyHistogram(); }
+    uint64_t count() const { return samples; }
+    double maxMs() const { return maxNs / 1e6; }
+
+    double percentileMs(double q) const {
+        if (!samples) return 0;
+        uint64_t rank = (uint64_t)(q * (samples - 1)) + 1, seen = 0;
+        for (int b = 0; b < BUCKETS; ++b)
+            if ((seen += bins[b]) >= rank) return b + 1;
+        return maxMs();
+    }
+
+    // Rows of 10 ms with a bar scaled to the fullest row.
+    void print(FILE* out, const char* title) const {
+        std::fprintf(out, "%s: %llu samples, p50 %.0f ms, p99 %.0f ms, max %.1f ms\n", title,
+            (unsigned long long)samples, percentileMs(0.5), percentileMs(0.99), maxMs());
+        if (!samples) return;
+        const int ROW = 10, ROWS = BUCKETS / ROW;
+        uint64_t rows[ROWS + 1] = {}, fullest = 1;
+        for (int b = 0; b <= BUCKETS; ++b) rows[b < BUCKETS ? b / ROW : ROWS] += bins[b];
+        int lastRow = 0;
+        for (int r = 0; r <= ROWS; ++r) {
+            if (rows[r]) lastRow = r;
+            if (rows[r] > fullest) fullest = rows[r];
+        }
+        for (int r = 0; r <= lastRow; ++r) {
+            char bar[41];
+            int len = (int)(rows[r] * 40 / fullest);
+            for (int i = 0; i < len; ++i) bar[i] = '#';
+            bar[len] = '\0';
+            if (r < ROWS) std::fprintf(out, "  %3d-%3d ms %8llu %s\n", r * ROW, (r + 1) * ROW, (unsigned long long)rows[r], bar);
+            else std::fprintf(out, "   >=%3d ms %8llu %s\n", BUCKETS, (unsigned long long)rows[r], bar);
+        }
+    }
+};
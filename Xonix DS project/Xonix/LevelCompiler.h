@@ -0,0 +1,272 @@
+#pragma once
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "LevelPack.h"
+
+
+////////////////////////////////  LEVEL COMPILER /////////////////////////////////////
+
+// Turns level source text into a pack for LevelPack.h. Run offline, as
+//   Xonix --compile-levels levels.txt levels.xlp
+// so the game never parses a level. The source is a list of levels, one
+// directive per line, '#' to the end of a line is a comment:
+//
+//   level Name               starts a level (name up to 31 characters)
+//   size ROWS COLS           default M x N; must come before anything below
+//   start ROW COL            the player's first cell, on wall; default the top edge
+//   wall R0 C0 R1 C1         fills the rectangle (corners included) with wall
+//   open R0 C0 R1 C1         carves it open again
+//   map ... end              ROWS lines of COLS cells, '#' wall and '.' open
+//   bouncer ROW COL          bounces off walls on a random heading (stock speed 4)
+//   bouncer ROW COL S        ... on a random heading of up to S px per tick
+//   bouncer ROW COL DX DY    ... on a fixed heading
+//   hunter ROW COL [S]       chases the trail at S px per tick (default 2)
+//   powerup SECONDS [COUNT]  hands the player COUNT (default 1) freeze power-ups
+//
+// The border is always wall. Cells are (row, column) from the top left of the
+// level, enemies start on open cells, and there are 1 to LEVEL_MAX_ENEMIES.
+
+namespace levelc {
+
+struct Source {
+    std::string name;
+    int rows = M, cols = N, startRow = 0, startCol = 10;
+    bool startSet = false, shaped = false;   // shaped: walls or spawns given, so size is fixed
+    std::vector<uint8_t> wall;               // rows x cols
+    std::vector<LevelSpawn> spawns;
+    std::vector<LevelDrop> drops;
+    int line = 0;
+
+    void resize(int r, int c) {
+        rows = r; cols = c;
+        wall.assign((size_t)r * c, 0);
+    }
+    void fill(int r0, int c0, int r1, int c1, uint8_t v) {
+        for (int r = std::min(r0, r1); r <= std::max(r0, r1); ++r)
+            for (int c = std::min(c0, c1); c <= std::max(c0, c1); ++c) wall[r * cols + c] = v;
+    }
+};
+
+inline bool toInt(const std::string& s, int& out) {
+    if (s.empty()) return false;
+    char* end;
+    long v = strtol(s.c_str(), &end, 10);
+    if (*end || v < -1000000 || v > 1000000) return false;
+    out = (int)v;
+    return true;
+}
+
+inline std::string at(int line, const std::string& msg) {
+    return "line " + std::to_string(line) + ": " + msg;
+}
+
+// Checks a finished level and appends its index entry and body.
+inline bool emit(Source& s, std::vector<LevelIndexEntry>& index, std::vector<uint8_t>& bodies, std::string& err) {
+    for (int c = 0; c < s.cols; ++c) s.wall[c] = s.wall[(s.rows - 1) * s.cols + c] = 1;
+    for (int r = 0; r < s.rows; ++r) s.wall[r * s.cols] = s.wall[r * s.cols + s.cols - 1] = 1;
+    if (!s.startSet) s.startCol = std::min(10, s.cols - 1);
+    if (s.startRow >= s.rows || s.startCol >= s.cols) { err = at(s.line, "level '" + s.name + "': the start is outside it"); return false; }
+    if (!s.wall[s.startRow * s.cols + s.startCol]) { err = at(s.line, "level '" + s.name + "': the start is not on wall"); return false; }
+    if (s.spawns.empty() || (int)s.spawns.size() > LEVEL_MAX_ENEMIES) {
+        err = at(s.line, "level '" + s.name + "': needs 1 to " + std::to_string(LEVEL_MAX_ENEMIES) + " enemies");
+        return false;
+    }
+    for (const LevelSpawn& sp : s.spawns)
+        if (s.wall[sp.row * s.cols + sp.col]) {
+            err = at(s.line, "level '" + s.name + "': enemy at " + std::to_string(sp.row) + " " + std::to_string(sp.col) + " starts in wall");
+            return false;
+        }
+    std::stable_sort(s.spawns.begin(), s.spawns.end(), [](const LevelSpawn& a, const LevelSpawn& b) { return a.kind < b.kind; });
+    std::stable_sort(s.drops.begin(), s.drops.end(), [](const LevelDrop& a, const LevelDrop& b) { return a.tick < b.tick; });
+    if (s.drops.size() > 255) { err = at(s.line, "level '" + s.name + "': more than 255 power-ups"); return false; }
+
+    LevelIndexEntry e;
+    memset(&e, 0, sizeof(e));
+    memcpy(e.name, s.name.c_str(), s.name.size());
+    e.rows = (uint8_t)s.rows; e.cols = (uint8_t)s.cols;
+    for (const LevelSpawn& sp : s.spawns) (sp.kind == LEVEL_HUNTER ? e.hunters : e.bouncers)++;
+    e.drops = (uint8_t)s.drops.size();
+    int open = 0;
+    for (uint8_t w : s.wall) open += !w;
+    e.openPercent = (uint8_t)(open * 100 / ((s.rows - 2) * (s.cols - 2)));
+
+    LevelRecord rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.rows = e.rows; rec.cols = e.cols;
+    rec.startRow = (uint8_t)s.startRow; rec.startCol = (uint8_t)s.startCol;
+    rec.enemies = (uint8_t)s.spawns.size(); rec.drops = e.drops;
+
+    const size_t size = LevelView::bodyBytes(s.rows, s.cols, rec.enemies, rec.drops);
+    e.offset = (uint32_t)bodies.size();   // from the first body until the pack is assembled
+    e.bytes = (uint32_t)size;
+    std::vector<uint8_t> body(size, 0);
+    uint8_t* p = body.data();
+    memcpy(p, &rec, sizeof(rec)); p += sizeof(rec);
+    if (!s.spawns.empty()) memcpy(p, s.spawns.data(), s.spawns.size() * sizeof(LevelSpawn));
+    p += s.spawns.size() * sizeof(LevelSpawn);
+    if (!s.drops.empty()) memcpy(p, s.drops.data(), s.drops.size() * sizeof(LevelDrop));
+    p += s.drops.size() * sizeof(LevelDrop);
+    const int stride = LevelView::wallStride(s.cols);
+    for (int r = 0; r < s.rows; ++r)
+        for (int c = 0; c < s.cols; ++c)
+            if (s.wall[r * s.cols + c]) p[r * stride + (c >> 3)] |= (uint8_t)(1 << (c & 7));
+    bodies.insert(bodies.end(), body.begin(), body.end());
+    index.push_back(e);
+    return true;
+}
+
+} // namespace levelc
+
+// Compiles level source into a pack. On failure err says which line and why.
+inline bool compileLevels(const std::string& source, std::vector<uint8_t>& pack, std::string& err) {
+    using namespace levelc;
+    std::vector<LevelIndexEntry> index;
+    std::vector<uint8_t> bodies;
+    Source s;
+    bool inLevel = false;
+    std::istringstream in(source);
+    std::string text;
+    int lineNo = 0;
+    while (std::getline(in, text)) {
+        ++lineNo;
+        size_t hash = text.find('#');
+        std::string raw = text;
+        if (hash != std::string::npos) text.erase(hash);
+        std::istringstream words(text);
+        std::string cmd;
+        if (!(words >> cmd)) continue;
+        std::vector<std::string> args;
+        for (std::string w; words >> w;) args.push_back(w);
+        std::vector<int> v(args.size());
+        bool numeric = true;
+        for (size_t i = 0; i < args.size(); ++i) numeric = numeric && toInt(args[i], v[i]);
+
+        if (cmd == "level") {
+            if (inLevel && !emit(s, index, bodies, err)) return false;
+            s = Source();
+            s.line = lineNo;
+            inLevel = true;
+            size_t from = raw.find("level") + 5, to = hash == std::string::npos ? raw.size() : hash;
+            std::string name = raw.substr(from, to - from);
+            name.erase(0, name.find_first_not_of(" \t"));
+            name.erase(name.find_last_not_of(" \t\r") + 1);
+            if (name.empty() || name.size() >= (size_t)LEVEL_NAME_BYTES) { err = at(lineNo, "level names are 1 to 31 characters"); return false; }
+            s.name = name;
+            s.resize(M, N);
+            continue;
+        }
+        if (!inLevel) { err = at(lineNo, "'" + cmd + "' before the first level"); return false; }
+        auto cell = [&](int r, int c) { return r >= 0 && r < s.rows && c >= 0 && c < s.cols; };
+
+        if (cmd == "map") {
+            if (!args.empty()) { err = at(lineNo, "map takes no arguments"); return false; }
+            int r = 0;
+            for (;;) {
+                if (!std::getline(in, text)) { err = at(lineNo, "map without end"); return false; }
+                ++lineNo;
+                if (!text.empty() && text.back() == '\r') text.pop_back();
+                if (text.find_first_not_of(" \t") != std::string::npos && text.substr(text.find_first_not_of(" \t"), 3) == "end") break;
+                if (r >= s.rows || (int)text.size() != s.cols || text.find_first_not_of("#.") != std::string::npos) {
+                    err = at(lineNo, "map rows are " + std::to_string(s.cols) + " of '#' and '.', " + std::to_string(s.rows) + " of them");
+                    return false;
+                }
+                for (int c = 0; c < s.cols; ++c) s.wall[r * s.cols + c] = text[c] == '#';
+                ++r;
+            }
+            if (r != s.rows) { err = at(lineNo, "map has " + std::to_string(r) + " rows, the level " + std::to_string(s.rows)); return false; }
+            s.shaped = true;
+            continue;
+        }
+        if (!numeric) { err = at(lineNo, "'" + cmd + "' takes numbers"); return false; }
+
+        if (cmd == "size") {
+            if (v.size() != 2) { err = at(lineNo, "size ROWS COLS"); return false; }
+            if (s.shaped) { err = at(lineNo, "size must come before walls and enemies"); return false; }
+            if (v[0] < 3 || v[0] > M || v[1] < 3 || v[1] > N) {
+                err = at(lineNo, "levels are 3 x 3 to " + std::to_string(M) + " x " + std::to_string(N));
+                return false;
+            }
+            s.resize(v[0], v[1]);
+        }
+        else if (cmd == "start") {
+            if (v.size() != 2 || !cell(v[0], v[1])) { err = at(lineNo, "start ROW COL, inside the level"); return false; }
+            s.startRow = v[0]; s.startCol = v[1]; s.startSet = true;
+        }
+        else if (cmd == "wall" || cmd == "open") {
+            if (v.size() != 4 || !cell(v[0], v[1]) || !cell(v[2], v[3])) { err = at(lineNo, cmd + " R0 C0 R1 C1, inside the level"); return false; }
+            s.fill(v[0], v[1], v[2], v[3], cmd == "wall");
+            s.shaped = true;
+        }
+        else if (cmd == "bouncer" || cmd == "hunter") {
+            const bool hunter = cmd == "hunter";
+            if (v.size() < 2 || v.size() > (hunter ? 3u : 4u) || !cell(v[0], v[1])) {
+                err = at(lineNo, hunter ? "hunter ROW COL [SPEED]" : "bouncer ROW COL [SPEED | DX DY]");
+                return false;
+            }
+            LevelSpawn sp;
+            memset(&sp, 0, sizeof(sp));
+            sp.row = (uint8_t)v[0]; sp.col = (uint8_t)v[1];
+            sp.kind = hunter ? LEVEL_HUNTER : LEVEL_BOUNCER;
+            sp.speed = hunter ? 2 : 4;
+            if (v.size() == 3) {
+                if (v[2] < 1 || v[2] > 8) { err = at(lineNo, "speeds are 1 to 8 px per tick"); return false; }
+                sp.speed = (uint8_t)v[2];
+            }
+            else if (v.size() == 4) {
+                if (v[2] < -8 || v[2] > 8 || v[3] < -8 || v[3] > 8 || (!v[2] && !v[3])) { err = at(lineNo, "DX and DY are -8 to 8, not both 0"); return false; }
+                sp.dx = (int8_t)v[2]; sp.dy = (int8_t)v[3];
+                sp.speed = (uint8_t)std::max(std::abs(v[2]), std::abs(v[3]));
+            }
+            s.spawns.push_back(sp);
+            s.shaped = true;
+        }
+        else if (cmd == "powerup") {
+            if (v.empty() || v.size() > 2 || v[0] < 0 || (v.size() == 2 && (v[1] < 1 || v[1] > 255))) {
+                err = at(lineNo, "powerup SECONDS [COUNT], COUNT 1 to 255");
+                return false;
+            }
+            LevelDrop d;
+            memset(&d, 0, sizeof(d));
+            d.tick = (uint32_t)v[0] * LEVEL_TICK_HZ;
+            d.kind = LEVEL_DROP_FREEZE;
+            d.count = (uint8_t)(v.size() == 2 ? v[1] : 1);
+            s.drops.push_back(d);
+        }
+        else { err = at(lineNo, "unknown directive '" + cmd + "'"); return false; }
+    }
+    if (inLevel && !emit(s, index, bodies, err)) return false;
+    if (index.empty()) { err = "no levels"; return false; }
+
+    LevelPackHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, "XLVP", 4);
+    h.version = LEVEL_PACK_VERSION;
+    h.count = (uint32_t)index.size();
+    const uint32_t first = (uint32_t)(sizeof(h) + index.size() * sizeof(LevelIndexEntry));
+    for (LevelIndexEntry& e : index) e.offset += first;
+    pack.assign(first + bodies.size(), 0);
+    memcpy(pack.data(), &h, sizeof(h));
+    memcpy(pack.data() + sizeof(h), index.data(), index.size() * sizeof(LevelIndexEntry));
+    memcpy(pack.data() + first, bodies.data(), bodies.size());
+    return true;
+}
+
+inline bool compileLevelFile(const char* sourcePath, const char* packPath, std::string& err, int* levels = nullptr) {
+    std::ifstream in(sourcePath, std::ios::binary);
+    if (!in) { err = std::string("cannot read ") + sourcePath; return false; }
+    std::string source((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<uint8_t> pack;
+    if (!compileLevels(source, pack, err)) { err = std::string(sourcePath) + ": " + err; return false; }
+    std::ofstream out(packPath, std::ios::binary | std::ios::trunc);
+    if (!out || !out.write((const char*)pack.data(), (std::streamsize)pack.size())) {
+        err = std::string("cannot write ") + packPath;
+        return false;
+    }
+    if (levels) *levels = (int)((const LevelPackHeader*)pack.data())->count;
+    return true;
+}
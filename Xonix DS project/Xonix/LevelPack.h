@@ -0,0 +1,251 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "Board.h"
+
+
+////////////////////////////////  LEVEL PACK /////////////////////////////////////
+
+// Single-player levels, compiled offline from text (see LevelCompiler.h) into
+// one binary pack that the game maps into memory and reads in place:
+//
+//   LevelPackHeader | LevelIndexEntry x count | level bodies
+//   body = LevelRecord | LevelSpawn x enemies | LevelDrop x drops | wall bitmap
+//
+// The index carries everything the level select screen lists, so opening a
+// pack checks the header and index and nothing else; a level's body is only
+// touched (and paged in by the OS) when it is previewed or started, and
+// starting one copies its walls straight out of the mapping. Bodies are
+// 8-byte aligned and every field is a fixed-width integer, written little-endian
+// as on every machine the game ships for.
+//
+// A level is at most M x N cells and is played centred on the stock board,
+// with wall around it. Enemies are bouncers or hunters, bouncers first; the
+// drops are power-ups handed to the player on a schedule.
+
+const uint32_t LEVEL_PACK_VERSION = 1;
+const int LEVEL_TICK_HZ = 60;        // drop ticks count at the single-player sim's rate
+const int LEVEL_MAX_ENEMIES = 10;
+const int LEVEL_NAME_BYTES = 32;
+
+struct LevelPackHeader {
+    char magic[4];                   // "XLVP"
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct LevelIndexEntry {
+    char name[LEVEL_NAME_BYTES];     // zero-terminated
+    uint32_t offset, bytes;          // the body, from the start of the pack
+    uint8_t rows, cols, bouncers, hunters;
+    uint8_t drops, openPercent;      // share of the interior left open at the start
+    uint16_t reserved;
+};
+
+struct LevelRecord {
+    uint8_t rows, cols, startRow, startCol;
+    uint8_t enemies, drops;
+    uint16_t reserved;
+};
+
+enum LevelEnemyKind : uint8_t { LEVEL_BOUNCER = 0, LEVEL_HUNTER = 1 };
+
+struct LevelSpawn {
+    uint8_t row, col, kind;
+    uint8_t speed;                   // px per tick; a bouncer's largest random step if dx = dy = 0
+    int8_t dx, dy;                   // a bouncer's fixed heading, or 0, 0 for a random one
+    uint16_t reserved;
+};
+
+enum LevelDropKind : uint8_t { LEVEL_DROP_FREEZE = 0 };
+
+struct LevelDrop {
+    uint32_t tick;                   // after the level starts
+    uint8_t kind, count;
+    uint16_t reserved;
+};
+
+static_assert(sizeof(LevelPackHeader) == 16 && sizeof(LevelIndexEntry) == 48 && sizeof(LevelRecord) == 8 &&
+    sizeof(LevelSpawn) == 8 && sizeof(LevelDrop) == 8, "the pack layout is fixed");
+
+// One level's body, pointing into its pack.
+struct LevelView {
+    const LevelRecord* rec = nullptr;
+    const LevelSpawn* spawns = nullptr;
+    const LevelDrop* drops = nullptr;
+    const uint8_t* walls = nullptr;  // rows x wallStride(), bit c & 7 of byte c >> 3
+
+    static int wallStride(int cols) { return (cols + 7) >> 3; }
+    static size_t bodyBytes(int rows, int cols, int enemies, int drops) {
+        size_t n = sizeof(LevelRecord) + enemies * sizeof(LevelSpawn) + drops * sizeof(LevelDrop)
+            + (size_t)rows * wallStride(cols);
+        return (n + 7) & ~(size_t)7;
+    }
+
+    int rows() const { return rec->rows; }
+    int cols() const { return rec->cols; }
+    int enemyCount() const { return rec->enemies; }
+    int dropCount() const { return rec->drops; }
+    bool wall(int r, int c) const { return walls[r * wallStride(rec->cols) + (c >> 3)] >> (c & 7) & 1; }
+
+    // Lays the level out on a rows x cols board (0 open, 1 wall), centred,
+    // with wall around it; top and left are where its cell (0, 0) lands.
+    void place(int* g, int boardRows, int boardCols, int& top, int& left) const {
+        top = (boardRows - rows()) / 2;
+        left = (boardCols - cols()) / 2;
+        for (int i = 0; i < boardRows * boardCols; i++) g[i] = 1;
+        const int stride = wallStride(cols());
+        for (int r = 0; r < rows(); r++) {
+            const uint8_t* bits = walls + r * stride;
+            int* row = g + (top + r) * boardCols + left;
+            for (int c = 0; c < cols(); c++) row[c] = bits[c >> 3] >> (c & 7) & 1;
+        }
+    }
+};
+
+// A read-only view of a whole file, unmapped on close().
+class MappedFile {
+    const uint8_t* ptr = nullptr;
+    size_t len = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE, mapping = nullptr;
+#endif
+
+public:
+    MappedFile() {}
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const char* path) {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) { close(); return false; }
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) { close(); return false; }
+        ptr = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!ptr) { close(); return false; }
+        len = (size_t)size.QuadPart;
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) { ::close(fd); return false; }
+        void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        ptr = (const uint8_t*)p;
+        len = (size_t)st.st_size;
+#endif
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (ptr) UnmapViewOfFile(ptr);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = nullptr;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (ptr) munmap((void*)ptr, len);
+#endif
+        ptr = nullptr;
+        len = 0;
+    }
+
+    const uint8_t* data() const { return ptr; }
+    size_t size() const { return len; }
+};
+
+class LevelPack {
+    MappedFile file;
+    std::vector<uint8_t> owned;      // a pack built in memory instead of mapped
+    const uint8_t* base = nullptr;
+    size_t bytes = 0;
+    const LevelIndexEntry* index = nullptr;
+    int count = 0;
+
+    // Header and index only; bodies are checked as they are opened.
+    bool attach(const uint8_t* data, size_t size) {
+        base = nullptr; bytes = 0; index = nullptr; count = 0;
+        if (size < sizeof(LevelPackHeader)) return false;
+        const LevelPackHeader* h = (const LevelPackHeader*)data;
+        if (memcmp(h->magic, "XLVP", 4) != 0 || h->version != LEVEL_PACK_VERSION) return false;
+        if (h->count > (size - sizeof(LevelPackHeader)) / sizeof(LevelIndexEntry)) return false;
+        const LevelIndexEntry* e = (const LevelIndexEntry*)(data + sizeof(LevelPackHeader));
+        for (uint32_t i = 0; i < h->count; ++i) {
+            if (e[i].offset & 7 || e[i].offset > size || e[i].bytes > size - e[i].offset) return false;
+            if (e[i].name[LEVEL_NAME_BYTES - 1] != 0) return false;
+        }
+        base = data; bytes = size; index = e; count = (int)h->count;
+        return true;
+    }
+
+public:
+    LevelPack() {}
+    LevelPack(const LevelPack&) = delete;
+    LevelPack& operator=(const LevelPack&) = delete;
+
+    // Maps a compiled pack; false if it is missing or not a pack of this version.
+    bool open(const char* path) {
+        owned.clear();
+        if (!file.open(path)) { attach(nullptr, 0); return false; }
+        if (attach(file.data(), file.size())) return true;
+        file.close();
+        return false;
+    }
+
+    // Takes a pack compiled in memory.
+    bool openMemory(std::vector<uint8_t> pack) {
+        file.close();
+        owned = std::move(pack);
+        return attach(owned.data(), owned.size());
+    }
+
+    int size() const { return count; }
+    const LevelIndexEntry& info(int i) const { return index[i]; }
+
+    // False if level i's body is damaged or does not fit the stock board.
+    bool level(int i, LevelView& out) const {
+        if (i < 0 || i >= count) return false;
+        const LevelIndexEntry& e = index[i];
+        if (e.bytes < sizeof(LevelRecord)) return false;
+        const uint8_t* p = base + e.offset;
+        const LevelRecord* r = (const LevelRecord*)p;
+        if (r->rows < 3 || r->cols < 3 || r->rows > M || r->cols > N) return false;
+        if (r->enemies > LEVEL_MAX_ENEMIES || r->startRow >= r->rows || r->startCol >= r->cols) return false;
+        if (LevelView::bodyBytes(r->rows, r->cols, r->enemies, r->drops) > e.bytes) return false;
+        out.rec = r;
+        out.spawns = (const LevelSpawn*)(p + sizeof(LevelRecord));
+        out.drops = (const LevelDrop*)(out.spawns + r->enemies);
+        out.walls = (const uint8_t*)(out.drops + r->drops);
+        for (int k = 0; k < r->enemies; ++k) {
+            const LevelSpawn& s = out.spawns[k];
+            if (s.row >= r->rows || s.col >= r->cols || s.kind > LEVEL_HUNTER) return false;
+            if (k && s.kind < out.spawns[k - 1].kind) return false;   // bouncers first
+        }
+        return true;
+    }
+};
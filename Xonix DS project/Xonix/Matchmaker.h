@@ -0,0 +1,140 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AvlMap.h"
+
+
+////////////////////////////////  MATCHMAKER /////////////////////////////////////
+
+// In-memory matchmaking queue. Waiting players sit in an AvlMap ordered by
+// skill; each tick() walks that order once and pairs neighbours whose skill gap
+// fits both players' search windows. A window starts at baseWindow and widens
+// with time spent waiting, so outliers still get a match eventually.
+// Cost per tick is O(n) for the walk plus O(log n) per matched player, or an
+// O(n) rebuild when most of the queue matched at once.
+
+struct MatchPlayer {
+    std::string name;
+    int score;
+};
+
+struct MatchConfig {
+    int baseWindow = 50;         // skill gap accepted immediately
+    double widenPerSec = 25.0;   // extra gap accepted per second waited
+    int maxWindow = 2000;        // cap on the widened gap
+};
+
+struct MatchResult {
+    MatchPlayer a, b;
+    double waitA, waitB;   // seconds each player spent queued
+};
+
+class MatchmakingEngine {
+    struct SkillKey {
+        int skill;
+        uint64_t ticket;   // arrival order, breaks ties between equal skills
+        bool operator<(const SkillKey& o) const {
+            return skill != o.skill ? skill < o.skill : ticket < o.ticket;
+        }
+    };
+    struct Waiting {
+        std::string name;
+        double enqueuedAt;
+    };
+
+    MatchConfig cfg;
+    AvlMap<SkillKey, Waiting> bySkill;
+    std::unordered_map<std::string, SkillKey> byName;   // for duplicates and cancel
+    uint64_t nextTicket = 0;
+    std::vector<SkillKey> matched;   // scratch, reused between ticks
+    std::vector<std::pair<SkillKey, Waiting>> survivors;
+
+    double windowFor(double waited) const {
+        double w = cfg.baseWindow + cfg.widenPerSec * (waited > 0 ? waited : 0);
+        return w < cfg.maxWindow ? w : cfg.maxWindow;
+    }
+
+public:
+    explicit MatchmakingEngine(const MatchConfig& config = MatchConfig()) : cfg(config) {}
+
+    const MatchConfig& config() const { return cfg; }
+    size_t queued() const { return bySkill.size(); }
+
+    void reserve(size_t n) {
+        bySkill.reserve(n);
+        byName.reserve(n);
+    }
+
+    // Adds a player; false if the name is already queued.
+    bool enqueue(const std::string& name, int skill, double now) {
+        if (byName.count(name)) return false;
+        SkillKey key = { skill, nextTicket++ };
+        bySkill.insert(key, Waiting{ name, now });
+        byName.emplace(name, key);
+        return true;
+    }
+
+    bool cancel(const std::string& name) {
+        auto it = byName.find(name);
+        if (it == byName.end()) return false;
+        bySkill.erase(it->second);
+        byName.erase(it);
+        return true;
+    }
+
+    // One batch matching pass. Appends every pair formed to out and removes
+    // those players from the queue; returns the number of matches made.
+    size_t tick(double now, std::vector<MatchResult>& out) {
+        matched.clear();
+        size_t made = 0;
+        auto it = bySkill.begin(), end = bySkill.end();
+        while (it != end) {
+            auto next = it;
+            ++next;
+            if (next == end) break;
+            double waitA = now - it->second.enqueuedAt;
+            double waitB = now - next->second.enqueuedAt;
+            double gap = (double)next->first.skill - it->first.skill;
+            double wa = windowFor(waitA), wb = windowFor(waitB);
+            if (gap <= (wa < wb ? wa : wb)) {
+                out.push_back(MatchResult{
+                    MatchPlayer{ it->second.name, it->first.skill },
+                    MatchPlayer{ next->second.name, next->first.skill },
+                    waitA, waitB });
+                matched.push_back(it->first);
+                matched.push_back(next->first);
+                ++made;
+                it = ++next;
+            }
+            else {
+                it = next;
+            }
+        }
+        if (matched.size() * 4 < bySkill.size()) {
+            for (const SkillKey& key : matched) {
+                const Waiting* w = bySkill.get(key);
+                byName.erase(w->name);
+                bySkill.erase(key);
+            }
+        }
+        else {
+            // most of the queue matched: rebuilding from the survivors in O(n)
+            // beats erasing one key at a time. matched is in skill order.
+            survivors.clear();
+            size_t m = 0;
+            for (auto& kv : bySkill) {
+                if (m < matched.size() && !(kv.first < matched[m]) && !(matched[m] < kv.first)) {
+                    byName.erase(kv.second.name);
+                    ++m;
+                }
+                else {
+                    survivors.push_back(std::move(kv));
+                }
+            }
+            bySkill.assignSorted(survivors.begin(), survivors.end());
+        }
+        return made;
+    }
+};
@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+
+////////////////////////////////  MPMC QUEUE /////////////////////////////////////
+
+// Bounded lock-free multi-producer / multi-consumer FIFO (Vyukov's ring).
+// All slots are allocated up front; a slot is recycled as soon as its value is
+// dequeued, so enqueue/dequeue never allocate. Each slot carries a sequence
+// number telling producers and consumers whose turn it is, and the two cursors
+// are claimed with a single compare-exchange each.
+// tryEnqueue fails when full and tryDequeue fails when empty; neither blocks.
+// T should be cheap to copy (e.g. fixed-size PODs) to keep the hot path allocation-free.
+
+template<typename T>
+class MpmcQueue {
+    struct Cell {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+    // keep the two cursors on separate cache lines so producers and consumers don't contend
+    char pad0[64];
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    char pad1[64];
+    std::atomic<size_t> enqueuePos;
+    char pad2[64];
+    std::atomic<size_t> dequeuePos;
+    char pad3[64];
+
+    static size_t roundUpPow2(size_t n) {
+        size_t p = 2;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+public:
+    // capacity is rounded up to a power of two (minimum 2).
+    explicit MpmcQueue(size_t capacity)
+        : cells(new Cell[roundUpPow2(capacity)]), mask(roundUpPow2(capacity) - 1),
+        enqueuePos(0), dequeuePos(0) {
+        for (size_t i = 0; i <= mask; ++i) cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    bool tryEnqueue(const T& value) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                // slot is free for this lap; claim it
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = value;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;   // a full lap behind: queue is full
+            }
+            else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryDequeue(T& out) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = cell.data;
+                    // hand the slot back to producers for the next lap
+                    cell.seq.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false;   // nothing published yet: queue is empty
+            }
+            else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+    // Only a snapshot when other threads are active.
+    size_t sizeApprox() const {
+        size_t e = enqueuePos.load(std::memory_order_relaxed);
+        size_t d = dequeuePos.load(std::memory_order_relaxed);
+        return e > d ? e - d : 0;
+    }
+};
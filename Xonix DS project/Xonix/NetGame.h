@@ -0,0 +1,418 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+#include "NetProtocol.h"
+#include "NetSocket.h"
+#include "RoomWorld.h"
+
+
+////////////////////////////////  NET GAME /////////////////////////////////////
+
+// Client/server room match over UDP.
+// NetServer owns the authoritative RoomWorld and ticks it at tickHz once every
+// seat is taken. Each tick it applies the next input frame from every seat
+// and sends each client a snapshot delta-coded against the last one that
+// client acked. A finished round restarts after ROUND_PAUSE seconds.
+// NetClient turns local keys into numbered input frames at the same rate and
+// predicts its own player: on every snapshot it starts from the
+// authoritative world and replays the frames the server hasn't applied yet.
+// Both sides are driven by update(now) from the caller's loop, and each side
+// sends through a LossyLink, so loss and latency can be dialled in on
+// 127.0.0.1.
+
+static_assert(std::is_trivially_copyable<RoomWorld>::value, "snapshots copy RoomWorld as raw bytes");
+
+struct NetConfig {
+    uint16_t port = 47000;
+    int players = 2;
+    double tickHz = 60;
+    uint32_t seed = 1;
+    LinkConditions link;   // applied to this side's outgoing packets
+};
+
+// Same starting world on both ends, padding included, so it can serve as delta base 0.
+inline void resetNetWorld(RoomWorld& w, uint32_t seed, int players) {
+    std::memset((void*)&w, 0, sizeof(w));
+    w.reset(seed, players);
+}
+
+// The room inputs one frame produces for a seat; out needs room for 3.
+inline int frameInputs(const InputFrame& f, uint8_t seat, RoomInput* out) {
+    int n = 0;
+    if (f.pressDx || f.pressDy) out[n++] = RoomInput{ seat, f.pressDx, f.pressDy, RoomInput::PRESS };
+    out[n++] = RoomInput{ seat, f.heldDx, f.heldDy, RoomInput::HELD };
+    if (f.freeze) out[n++] = RoomInput{ seat, 0, 0, RoomInput::FREEZE };
+    return n;
+}
+
+struct NetServerStats {
+    uint64_t ticks = 0;
+    uint64_t snapshots = 0, snapshotBytes = 0, fullSnapshots = 0;
+    uint64_t inputPackets = 0, inputBytes = 0;
+};
+
+class NetServer {
+    static const int HISTORY = 64;         // snapshots kept as delta bases
+    static const int FRAME_WINDOW = 64;    // buffered input frames per seat
+    static const int CATCH_UP_AFTER = 2;   // frames queued beyond this are applied two per tick
+    static constexpr double ROUND_PAUSE = 3.0;
+
+    struct Seat {
+        bool taken = false;
+        NetAddress addr;
+        uint32_t lastApplied = 0;   // newest input frame already simulated
+        uint32_t newest = 0;        // newest input frame received
+        uint32_t ackTick = 0;       // newest snapshot the client has
+        InputFrame frames[FRAME_WINDOW];
+    };
+
+    NetConfig cfg;
+    UdpSocket sock;
+    LossyLink link;
+    RoomWorld world, baseline;
+    std::vector<RoomWorld> history;   // history[tick % HISTORY]
+    Seat seats[RoomWorld::MAX_PLAYERS];
+    int seatsTaken = 0;
+    bool started = false;
+    double nextTick = 0, roundOverAt = -1;
+    uint32_t round = 0;
+    std::vector<uint8_t> out;
+    uint8_t in[NET_MAX_PACKET];
+    NetServerStats st;
+
+    void send(double now, const NetAddress& to) { link.send(now, to, out.data(), out.size()); }
+
+    void sendWelcome(double now, int s) {
+        ByteWriter w(out);
+        writeHeader(w, MSG_WELCOME);
+        w.u8((uint8_t)s);
+        w.u8((uint8_t)cfg.players);
+        w.u32(cfg.seed);
+        w.u32((uint32_t)cfg.tickHz);
+        w.u8((uint8_t)seatsTaken);
+        send(now, seats[s].addr);
+    }
+
+    int seatOf(const NetAddress& a) const {
+        for (int s = 0; s < cfg.players; ++s)
+            if (seats[s].taken && seats[s].addr == a) return s;
+        return -1;
+    }
+
+    void onConnect(double now, const NetAddress& from) {
+        int s = seatOf(from);
+        if (s < 0) {
+            for (int i = 0; i < cfg.players && s < 0; ++i)
+                if (!seats[i].taken) s = i;
+            if (s < 0) return;   // full
+            seats[s].taken = true;
+            seats[s].addr = from;
+            ++seatsTaken;
+            // everyone already seated hears the new head count
+            for (int i = 0; i < cfg.players; ++i)
+                if (seats[i].taken && i != s) sendWelcome(now, i);
+            if (seatsTaken == cfg.players && !started) {
+                started = true;
+                nextTick = now + 1.0 / cfg.tickHz;
+            }
+        }
+        sendWelcome(now, s);
+    }
+
+    void onInput(const NetAddress& from, ByteReader& r) {
+        int s = seatOf(from);
+        if (s < 0) return;
+        Seat& seat = seats[s];
+        uint32_t ack = r.u32();
+        uint32_t count = r.varint();
+        if (!r.ok() || count > MAX_INPUT_FRAMES) return;
+        if (ack > seat.ackTick && ack <= world.tickNo) seat.ackTick = ack;
+        for (uint32_t i = 0; i < count; ++i) {
+            InputFrame f = readFrame(r);
+            if (!r.ok()) return;
+            if (f.frame <= seat.lastApplied || f.frame > seat.lastApplied + FRAME_WINDOW) continue;
+            seat.frames[f.frame % FRAME_WINDOW] = f;
+            if (f.frame > seat.newest) seat.newest = f.frame;
+        }
+    }
+
+    void tickOnce(double now) {
+        RoomInput inputs[RoomWorld::MAX_PLAYERS * 6];
+        int n = 0;
+        for (int s = 0; s < cfg.players; ++s) {
+            Seat& seat = seats[s];
+            int budget = seat.newest - seat.lastApplied > CATCH_UP_AFTER ? 2 : 1;
+            for (uint32_t f = seat.lastApplied + 1; budget > 0 && f <= seat.newest; ++f) {
+                const InputFrame& fr = seat.frames[f % FRAME_WINDOW];
+                if (fr.frame != f) continue;   // lost for good; later frames still apply
+                n += frameInputs(fr, (uint8_t)s, inputs + n);
+                seat.lastApplied = f;
+                --budget;
+            }
+        }
+        world.tick(inputs, n);
+        ++st.ticks;
+
+        if (world.finished()) {
+            if (roundOverAt < 0) roundOverAt = now;
+            else if (now - roundOverAt >= ROUND_PAUSE) {
+                // tick numbers keep counting across rounds; clients ack by tick
+                world.reset(cfg.seed + ++round, cfg.players, world.tickNo);
+                roundOverAt = -1;
+            }
+        }
+
+        std::memcpy(&history[world.tickNo % HISTORY], &world, sizeof(RoomWorld));
+        for (int s = 0; s < cfg.players; ++s) {
+            Seat& seat = seats[s];
+            const RoomWorld* base = &baseline;
+            uint32_t baseTick = 0;
+            const RoomWorld& acked = history[seat.ackTick % HISTORY];
+            if (seat.ackTick && world.tickNo - seat.ackTick < HISTORY && acked.tickNo == seat.ackTick) {
+                base = &acked;
+                baseTick = seat.ackTick;
+            }
+            ByteWriter w(out);
+            writeHeader(w, MSG_SNAPSHOT);
+            w.u32(world.tickNo);
+            w.u32(baseTick);
+            w.u32(seat.lastApplied);
+            encodeDelta((const uint8_t*)base, (const uint8_t*)&world, sizeof(RoomWorld), w);
+            send(now, seat.addr);
+            ++st.snapshots;
+            st.snapshotBytes += out.size();
+            if (!baseTick) ++st.fullSnapshots;
+        }
+    }
+
+public:
+    explicit NetServer(const NetConfig& config)
+        : cfg(config), link(sock, config.link, config.seed * 7 + 1), history(HISTORY) {
+        if (cfg.players < 2) cfg.players = 2;
+        if (cfg.players > RoomWorld::MAX_PLAYERS) cfg.players = RoomWorld::MAX_PLAYERS;
+        if (cfg.tickHz <= 0) cfg.tickHz = 60;
+        resetNetWorld(baseline, cfg.seed, cfg.players);
+        std::memcpy(&world, &baseline, sizeof(RoomWorld));
+        for (auto& h : history) std::memcpy(&h, &baseline, sizeof(RoomWorld));
+        for (auto& s : seats) std::memset(s.frames, 0, sizeof(s.frames));
+    }
+
+    // Binds the configured port (0 picks one); false if that fails.
+    bool open() { return sock.open(cfg.port); }
+    uint16_t port() const { return sock.localPort(); }
+
+    bool isStarted() const { return started; }
+    int seated() const { return seatsTaken; }
+    const RoomWorld& state() const { return world; }
+    const NetServerStats& stats() const { return st; }
+    uint64_t bytesSent() const { return link.bytesSent(); }
+
+    // Handles everything that has arrived, runs any ticks that are due and
+    // releases delayed packets. now is in seconds on a steady clock.
+    void update(double now) {
+        NetAddress from;
+        int len;
+        while ((len = sock.receive(from, in, sizeof(in))) >= 0) {
+            ByteReader r(in, (size_t)len);
+            uint8_t type = readHeader(r);
+            if (type == MSG_CONNECT) onConnect(now, from);
+            else if (type == MSG_INPUT) {
+                ++st.inputPackets;
+                st.inputBytes += (uint64_t)len;
+                onInput(from, r);
+            }
+        }
+        if (started) {
+            const double period = 1.0 / cfg.tickHz;
+            while (now >= nextTick) {
+                tickOnce(now);
+                nextTick += period;
+                if (now - nextTick > 5 * period) nextTick = now + period;   // stalled: don't burst
+            }
+        }
+        link.flush(now);
+    }
+};
+
+struct NetClientStats {
+    uint64_t snapshots = 0, snapshotBytes = 0, undecodable = 0;
+    uint64_t framesSent = 0, inputBytes = 0;
+    uint64_t corrections = 0;          // own predicted position moved when a snapshot landed
+    std::vector<float> inputLatency;   // seconds from frame creation to a snapshot that includes it
+};
+
+class NetClient {
+public:
+    enum State { CONNECTING, WAITING, PLAYING };
+
+private:
+    static const int HISTORY = 64;
+    static const int FRAME_RING = 256;
+
+    NetConfig cfg;
+    NetAddress server;
+    UdpSocket sock;
+    LossyLink link;
+    State state = CONNECTING;
+    int seat = -1, players = 2, seatsTaken = 0;
+    uint32_t seed = 0;
+    double tickHz = 60, nextFrameAt = 0, lastConnect = -1;
+
+    RoomWorld baseline, authoritative, predicted;
+    std::vector<RoomWorld> history;   // received snapshots, history[tick % HISTORY]
+    uint32_t latestTick = 0, authFrame = 0;
+
+    InputFrame frames[FRAME_RING];
+    double createdAt[FRAME_RING];
+    uint32_t nextFrame = 1;
+    int8_t heldDx = 0, heldDy = 0, pressDx = 0, pressDy = 0;
+    bool freezeQueued = false;
+
+    std::vector<uint8_t> out;
+    uint8_t in[NET_MAX_PACKET];
+    NetClientStats st;
+
+    void send(double now) { link.send(now, server, out.data(), out.size()); }
+
+    void onWelcome(ByteReader& r) {
+        int s = r.u8(), p = r.u8();
+        uint32_t sd = r.u32(), hz = r.u32();
+        int taken = r.u8();
+        if (!r.ok()) return;
+        seatsTaken = taken;
+        if (state != CONNECTING) return;
+        seat = s;
+        players = p;
+        seed = sd;
+        tickHz = hz ? hz : 60;
+        resetNetWorld(baseline, seed, players);
+        std::memcpy(&authoritative, &baseline, sizeof(RoomWorld));
+        std::memcpy(&predicted, &baseline, sizeof(RoomWorld));
+        for (auto& h : history) std::memcpy(&h, &baseline, sizeof(RoomWorld));
+        state = WAITING;
+    }
+
+    void onSnapshot(double now, ByteReader& r, size_t len) {
+        uint32_t tick = r.u32(), baseTick = r.u32(), lastFrame = r.u32();
+        if (!r.ok() || state == CONNECTING || tick <= latestTick) return;   // stale or reordered
+        const RoomWorld* base = &baseline;
+        if (baseTick) {
+            base = &history[baseTick % HISTORY];
+            if (base->tickNo != baseTick) { ++st.undecodable; return; }
+        }
+        RoomWorld& slot = history[tick % HISTORY];
+        RoomWorld decoded;
+        if (!decodeDelta((const uint8_t*)base, r, (uint8_t*)&decoded, sizeof(RoomWorld)) || decoded.tickNo != tick) {
+            ++st.undecodable;
+            return;
+        }
+        std::memcpy(&slot, &decoded, sizeof(RoomWorld));
+        std::memcpy(&authoritative, &decoded, sizeof(RoomWorld));
+        latestTick = tick;
+        ++st.snapshots;
+        st.snapshotBytes += len;
+
+        if (state == WAITING) {
+            state = PLAYING;
+            nextFrameAt = now;
+        }
+        for (uint32_t f = authFrame + 1; f <= lastFrame && f < nextFrame; ++f)
+            st.inputLatency.push_back((float)(now - createdAt[f % FRAME_RING]));
+        if (lastFrame > authFrame) authFrame = lastFrame;
+        repredict();
+    }
+
+    // Authoritative world plus every own frame the server hasn't applied yet.
+    void repredict() {
+        int oldX = predicted.players[seat].x, oldY = predicted.players[seat].y;
+        std::memcpy(&predicted, &authoritative, sizeof(RoomWorld));
+        uint32_t first = authFrame + 1;
+        if (nextFrame - first > FRAME_RING) first = nextFrame - FRAME_RING;
+        for (uint32_t f = first; f < nextFrame; ++f) predictFrame(frames[f % FRAME_RING]);
+        if (predicted.players[seat].x != oldX || predicted.players[seat].y != oldY) ++st.corrections;
+    }
+
+    void predictFrame(const InputFrame& f) {
+        RoomInput inputs[3];
+        predicted.tick(inputs, frameInputs(f, (uint8_t)seat, inputs));
+    }
+
+    void sendInputs(double now) {
+        uint32_t first = authFrame + 1;
+        if (nextFrame - first > (uint32_t)MAX_INPUT_FRAMES) first = nextFrame - MAX_INPUT_FRAMES;
+        ByteWriter w(out);
+        writeHeader(w, MSG_INPUT);
+        w.u32(latestTick);
+        w.varint(nextFrame - first);
+        for (uint32_t f = first; f < nextFrame; ++f) writeFrame(w, frames[f % FRAME_RING]);
+        send(now);
+        st.inputBytes += out.size();
+    }
+
+public:
+    explicit NetClient(const NetConfig& config)
+        : cfg(config), link(sock, config.link, config.seed * 13 + 5), history(HISTORY) {}
+
+    // Opens a local socket and starts knocking on server.
+    bool connect(const NetAddress& to) {
+        server = to;
+        state = CONNECTING;
+        lastConnect = -1;
+        return sock.open(0);
+    }
+
+    State getState() const { return state; }
+    int getSeat() const { return seat; }
+    int getPlayers() const { return players; }
+    int getSeatsTaken() const { return seatsTaken; }
+    const RoomWorld& view() const { return predicted; }
+    const NetClientStats& stats() const { return st; }
+    NetClientStats& stats() { return st; }
+
+    // Local controls, folded into the next input frame.
+    void setHeld(int8_t dx, int8_t dy) { heldDx = dx; heldDy = dy; }
+    void press(int8_t dx, int8_t dy) { if (!pressDx && !pressDy) { pressDx = dx; pressDy = dy; } }
+    void freeze() { freezeQueued = true; }
+
+    void update(double now) {
+        int len;
+        NetAddress from;
+        while ((len = sock.receive(from, in, sizeof(in))) >= 0) {
+            if (from != server) continue;
+            ByteReader r(in, (size_t)len);
+            uint8_t type = readHeader(r);
+            if (type == MSG_WELCOME) onWelcome(r);
+            else if (type == MSG_SNAPSHOT) onSnapshot(now, r, (size_t)len);
+        }
+
+        if (state == CONNECTING && (lastConnect < 0 || now - lastConnect >= 0.25)) {
+            ByteWriter w(out);
+            writeHeader(w, MSG_CONNECT);
+            send(now);
+            lastConnect = now;
+        }
+
+        if (state == PLAYING) {
+            const double period = 1.0 / tickHz;
+            if (now - nextFrameAt > 5 * period) nextFrameAt = now;   // stalled: don't burst
+            while (now >= nextFrameAt) {
+                InputFrame& f = frames[nextFrame % FRAME_RING];
+                f.frame = nextFrame;
+                f.heldDx = heldDx; f.heldDy = heldDy;
+                f.pressDx = pressDx; f.pressDy = pressDy;
+                f.freeze = freezeQueued ? 1 : 0;
+                pressDx = pressDy = 0;
+                freezeQueued = false;
+                createdAt[nextFrame % FRAME_RING] = now;
+                ++nextFrame;
+                ++st.framesSent;
+                predictFrame(f);
+                sendInputs(now);
+                nextFrameAt += period;
+            }
+        }
+        link.flush(now);
+    }
+};
@@ -0,0 +1,160 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+
+////////////////////////////////  NET PROTOCOL /////////////////////////////////////
+
+// Wire format for the networked room mode. Every datagram starts with
+// NET_MAGIC and a message type; integers are little-endian, counts varints.
+//
+//  client -> server  CONNECT
+//                    INPUT     ackTick, count, count x InputFrame (oldest first)
+//  server -> client  WELCOME   seat, players, seed, tickHz, seatsTaken
+//                    SNAPSHOT  tick, baseTick, lastFrame, delta bytes
+//  peer <-> peer     HELLO     seat, seed (rollback mode, see Rollback.h)
+//                    PINPUT    ackFrame, advantage, count, count x InputFrame
+//
+// Inputs carry every frame the server hasn't acknowledged yet (up to
+// MAX_INPUT_FRAMES), so a lost INPUT packet costs nothing. A SNAPSHOT is the
+// world's bytes delta-coded against the snapshot the client last acked
+// (baseTick), or against the freshly reset world when baseTick is 0.
+
+const uint32_t NET_MAGIC = 0x31584E58u;   // "XNX1"
+const int MAX_INPUT_FRAMES = 16;
+const size_t NET_MAX_PACKET = 8192;
+
+enum NetMessage : uint8_t {
+    MSG_CONNECT = 1,
+    MSG_WELCOME = 2,
+    MSG_INPUT = 3,
+    MSG_SNAPSHOT = 4,
+    MSG_HELLO = 5,
+    MSG_PEER_INPUT = 6
+};
+
+// One client frame of input for its own player.
+struct InputFrame {
+    uint32_t frame;
+    int8_t heldDx, heldDy;     // direction held this frame, (0,0) for none
+    int8_t pressDx, pressDy;   // key-down this frame, (0,0) for none
+    uint8_t freeze;
+};
+
+class ByteWriter {
+    std::vector<uint8_t>& out;
+public:
+    explicit ByteWriter(std::vector<uint8_t>& buffer) : out(buffer) { out.clear(); }
+    void u8(uint8_t v) { out.push_back(v); }
+    void i8(int8_t v) { out.push_back((uint8_t)v); }
+    void u32(uint32_t v) { for (int i = 0; i < 4; ++i) out.push_back((uint8_t)(v >> (8 * i))); }
+    void varint(uint32_t v) {
+        while (v >= 0x80) { out.push_back((uint8_t)(v | 0x80)); v >>= 7; }
+        out.push_back((uint8_t)v);
+    }
+    void bytes(const uint8_t* p, size_t n) { out.insert(out.end(), p, p + n); }
+    size_t size() const { return out.size(); }
+};
+
+// Every read fails softly: once ok() is false the packet is discarded.
+class ByteReader {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool good = true;
+public:
+    ByteReader(const uint8_t* data, size_t len) : p(data), end(data + len) {}
+    bool ok() const { return good; }
+    bool atEnd() const { return p == end; }
+    uint8_t u8() {
+        if (p >= end) { good = false; return 0; }
+        return *p++;
+    }
+    int8_t i8() { return (int8_t)u8(); }
+    uint32_t u32() {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) v |= (uint32_t)u8() << (8 * i);
+        return v;
+    }
+    uint32_t varint() {
+        uint32_t v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            uint8_t b = u8();
+            v |= (uint32_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        good = false;
+        return 0;
+    }
+    const uint8_t* bytes(size_t n) {
+        if ((size_t)(end - p) < n) { good = false; return nullptr; }
+        const uint8_t* at = p;
+        p += n;
+        return at;
+    }
+};
+
+inline void writeHeader(ByteWriter& w, NetMessage type) {
+    w.u32(NET_MAGIC);
+    w.u8(type);
+}
+
+// Checks the magic and returns the message type, or 0.
+inline uint8_t readHeader(ByteReader& r) {
+    if (r.u32() != NET_MAGIC) return 0;
+    uint8_t type = r.u8();
+    return r.ok() ? type : 0;
+}
+
+inline void writeFrame(ByteWriter& w, const InputFrame& f) {
+    w.u32(f.frame);
+    w.i8(f.heldDx); w.i8(f.heldDy);
+    w.i8(f.pressDx); w.i8(f.pressDy);
+    w.u8(f.freeze);
+}
+
+inline InputFrame readFrame(ByteReader& r) {
+    InputFrame f;
+    f.frame = r.u32();
+    f.heldDx = r.i8(); f.heldDy = r.i8();
+    f.pressDx = r.i8(); f.pressDy = r.i8();
+    f.freeze = r.u8();
+    return f;
+}
+
+// Delta coding of two equal-sized byte images: a sequence of
+// (varint unchanged-run, varint changed-run, changed bytes). A changed run
+// only ends at two equal bytes in a row, so isolated matches don't cost a
+// fresh pair of lengths.
+inline void encodeDelta(const uint8_t* base, const uint8_t* cur, size_t n, ByteWriter& w) {
+    size_t i = 0;
+    while (i < n) {
+        size_t same = i;
+        while (same < n && base[same] == cur[same]) ++same;
+        if (same == n) break;
+        size_t diff = same;
+        while (diff < n && !(base[diff] == cur[diff] && (diff + 1 == n || base[diff + 1] == cur[diff + 1]))) ++diff;
+        w.varint((uint32_t)(same - i));
+        w.varint((uint32_t)(diff - same));
+        w.bytes(cur + same, diff - same);
+        i = diff;
+    }
+}
+
+// Rebuilds cur from base and the rest of r; false if the delta is malformed.
+inline bool decodeDelta(const uint8_t* base, ByteReader& r, uint8_t* cur, size_t n) {
+    std::memcpy(cur, base, n);
+    size_t i = 0;
+    while (!r.atEnd()) {
+        size_t same = r.varint();
+        size_t diff = r.varint();
+        if (!r.ok() || same > n - i || diff > n - i - same) return false;
+        i += same;
+        const uint8_t* src = r.bytes(diff);
+        if (!src) return false;
+        std::memcpy(cur + i, src, diff);
+        i += diff;
+    }
+    return true;
+}
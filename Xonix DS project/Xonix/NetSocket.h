@@ -0,0 +1,207 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+
+////////////////////////////////  UDP SOCKET /////////////////////////////////////
+
+// Minimal non-blocking IPv4 UDP socket over Winsock or BSD sockets, plus a
+// LossyLink that sits in front of send() to drop and delay datagrams on
+// purpose, so the networked mode can be exercised on 127.0.0.1.
+
+struct NetAddress {
+    uint32_t ip = 0;     // host byte order
+    uint16_t port = 0;
+
+    static NetAddress loopback(uint16_t port) {
+        NetAddress a;
+        a.ip = 0x7f000001u;
+        a.port = port;
+        return a;
+    }
+    // Dotted quad only ("127.0.0.1"); false if it doesn't parse.
+    static bool parse(const char* text, uint16_t port, NetAddress& out) {
+        unsigned b[4];
+        char tail;
+#ifdef _MSC_VER
+        if (sscanf_s(text, "%u.%u.%u.%u%c", &b[0], &b[1], &b[2], &b[3], &tail, 1u) != 4) return false;   // sscanf is an error under /sdl
+#else
+        if (std::sscanf(text, "%u.%u.%u.%u%c", &b[0], &b[1], &b[2], &b[3], &tail) != 4) return false;
+#endif
+        if (b[0] > 255 || b[1] > 255 || b[2] > 255 || b[3] > 255) return false;
+        out.ip = (b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+        out.port = port;
+        return true;
+    }
+    bool operator==(const NetAddress& o) const { return ip == o.ip && port == o.port; }
+    bool operator!=(const NetAddress& o) const { return !(*this == o); }
+};
+
+class UdpSocket {
+#ifdef _WIN32
+    typedef SOCKET Handle;
+    static Handle invalid() { return INVALID_SOCKET; }
+#else
+    typedef int Handle;
+    static Handle invalid() { return -1; }
+#endif
+    Handle sock = invalid();
+
+    static void startup() {
+#ifdef _WIN32
+        static bool started = false;   // sockets are only opened from the main thread
+        if (!started) {
+            WSADATA data;
+            started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+        }
+#endif
+    }
+
+public:
+    UdpSocket() {}
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+    ~UdpSocket() { close(); }
+
+    // Binds to port on all interfaces (0 picks a free port).
+    bool open(uint16_t port) {
+        close();
+        startup();
+        sock = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+        if (sock == invalid()) return false;
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        addr.sin_port = htons(port);
+        bool ok = ::bind(sock, (const sockaddr*)&addr, sizeof(addr)) == 0;
+#ifdef _WIN32
+        u_long nonBlocking = 1;
+        ok = ok && ioctlsocket(sock, FIONBIO, &nonBlocking) == 0;
+#else
+        ok = ok && fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK) == 0;
+#endif
+        if (!ok) close();
+        return ok;
+    }
+
+    void close() {
+        if (sock == invalid()) return;
+#ifdef _WIN32
+        closesocket(sock);
+#else
+        ::close(sock);
+#endif
+        sock = invalid();
+    }
+
+    bool isOpen() const { return sock != invalid(); }
+
+    uint16_t localPort() const {
+        sockaddr_in addr;
+#ifdef _WIN32
+        int len = sizeof(addr);
+#else
+        socklen_t len = sizeof(addr);
+#endif
+        if (::getsockname(sock, (sockaddr*)&addr, &len) != 0) return 0;
+        return ntohs(addr.sin_port);
+    }
+
+    bool sendTo(const NetAddress& to, const void* data, size_t len) {
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(to.ip);
+        addr.sin_port = htons(to.port);
+        return ::sendto(sock, (const char*)data, (int)len, 0, (const sockaddr*)&addr, sizeof(addr)) == (int)len;
+    }
+
+    // Returns the datagram size, or -1 when nothing is waiting.
+    int receive(NetAddress& from, void* buf, size_t cap) {
+        sockaddr_in addr;
+#ifdef _WIN32
+        int len = sizeof(addr);
+#else
+        socklen_t len = sizeof(addr);
+#endif
+        int n = (int)::recvfrom(sock, (char*)buf, (int)cap, 0, (sockaddr*)&addr, &len);
+        if (n < 0) return -1;
+        from.ip = ntohl(addr.sin_addr.s_addr);
+        from.port = ntohs(addr.sin_port);
+        return n;
+    }
+};
+
+// Outgoing side of a simulated bad link: each datagram is dropped with
+// probability loss, otherwise held for latency +- jitter seconds before it
+// really goes out. flush(now) sends whatever has come due. With loss and
+// latency at zero it is a plain pass-through.
+struct LinkConditions {
+    double loss = 0;        // 0..1
+    double latency = 0;     // one-way, seconds
+    double jitter = 0;      // uniform +-, seconds
+};
+
+class LossyLink {
+    struct Held {
+        double due;
+        NetAddress to;
+        std::vector<uint8_t> bytes;
+    };
+    UdpSocket& sock;
+    LinkConditions cond;
+    std::mt19937 rng;
+    std::deque<Held> held;   // kept in due order
+    uint64_t sentBytes = 0, sentPackets = 0, dropped = 0;
+
+public:
+    LossyLink(UdpSocket& s, const LinkConditions& c, unsigned seed) : sock(s), cond(c), rng(seed) {}
+
+    void send(double now, const NetAddress& to, const uint8_t* data, size_t len) {
+        sentBytes += len;
+        ++sentPackets;
+        std::uniform_real_distribution<double> u(0.0, 1.0);
+        if (cond.loss > 0 && u(rng) < cond.loss) { ++dropped; return; }
+        if (cond.latency <= 0 && cond.jitter <= 0) { sock.sendTo(to, data, len); return; }
+        double delay = cond.latency + cond.jitter * (2 * u(rng) - 1);
+        Held h{ now + (delay > 0 ? delay : 0), to, std::vector<uint8_t>(data, data + len) };
+        auto it = held.end();
+        while (it != held.begin() && (it - 1)->due > h.due) --it;   // jitter may reorder
+        held.insert(it, std::move(h));
+    }
+
+    void flush(double now) {
+        while (!held.empty() && held.front().due <= now) {
+            sock.sendTo(held.front().to, held.front().bytes.data(), held.front().bytes.size());
+            held.pop_front();
+        }
+    }
+
+    uint64_t bytesSent() const { return sentBytes; }
+    uint64_t packetsSent() const { return sentPackets; }
+    uint64_t packetsDropped() const { return dropped; }
+};
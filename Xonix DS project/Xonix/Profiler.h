@@ -0,0 +1,218 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+
+////////////////////////////////  PROFILER /////////////////////////////////////
+
+// Scoped timing zones:  { PROFILE_ZONE("drop"); ... }
+// Each thread appends (zone, start, duration) events to its own ring buffer,
+// so recording takes no lock and shares no cache line with other threads.
+// A zone costs two clock reads and a 16-byte store. The rings keep the last
+// RING events per thread and are never freed, so a trace can still be written
+// after a worker has exited.
+// summarize() gives per-zone p50/p99 over a recent window of the calling
+// thread, or of every thread (the game loop's overlay uses that, so zones of
+// the simulation thread show next to the render loop's), and writeChromeTrace() dumps every
+// ring as Chrome trace-event JSON for chrome://tracing or Perfetto.
+// Build with XONIX_PROFILE=0 to compile the zones out entirely.
+
+#ifndef XONIX_PROFILE
+#define XONIX_PROFILE 1
+#endif
+
+class Profiler {
+public:
+    static const int RING = 1 << 15;       // events kept per thread, must be a power of two
+    static const int MAX_ZONES = 128;
+
+    struct Event {
+        uint64_t start;   // ns since the profiler's epoch
+        uint32_t dur;     // ns
+        uint16_t zone;
+    };
+
+    struct ZoneStats {
+        const char* name;
+        size_t count;
+        double p50, p99, max;   // microseconds
+    };
+
+private:
+    struct Ring {
+        Event ev[RING];
+        std::atomic<uint64_t> head;   // events ever written; slot = head & (RING - 1)
+        uint32_t tid;
+        Ring() : head(0), tid(0) {}
+    };
+
+    struct Registry {
+        std::mutex mtx;
+        std::vector<Ring*> rings;
+        const char* zones[MAX_ZONES];
+        std::atomic<int> zoneCount;
+        std::chrono::steady_clock::time_point epoch;
+        Registry() : zoneCount(0), epoch(std::chrono::steady_clock::now()) {}
+    };
+
+    static Registry& registry() {
+        static Registry r;
+        return r;
+    }
+
+    static Ring* newRing() {
+        Registry& reg = registry();
+        Ring* r = new Ring();   // deliberately leaked: outlives its thread for export
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        r->tid = (uint32_t)reg.rings.size() + 1;
+        reg.rings.push_back(r);
+        return r;
+    }
+
+    static Ring& localRing() {
+        static thread_local Ring* r = newRing();
+        return *r;
+    }
+
+    // Events of one ring, oldest first. A thread other than the owner skips
+    // the oldest slack events, which the owner may be overwriting right now.
+    static void copyRing(Ring& r, bool owner, std::vector<Event>& out) {
+        uint64_t head = r.head.load(std::memory_order_acquire);
+        const uint64_t slack = owner ? 0 : RING / 8;
+        uint64_t keep = std::min<uint64_t>(head, RING - slack);
+        for (uint64_t i = head - keep; i < head; ++i) out.push_back(r.ev[i & (RING - 1)]);
+    }
+
+public:
+    // Registers a zone name (a string literal) once per call site; see PROFILE_ZONE.
+    static uint16_t zone(const char* name) {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mtx);
+        int n = reg.zoneCount.load(std::memory_order_relaxed);
+        for (int i = 0; i < n; ++i)
+            if (!std::strcmp(reg.zones[i], name)) return (uint16_t)i;
+        if (n == MAX_ZONES) return (uint16_t)(MAX_ZONES - 1);   // shares the last slot rather than fail
+        reg.zones[n] = name;
+        reg.zoneCount.store(n + 1, std::memory_order_release);
+        return (uint16_t)n;
+    }
+
+    static const char* zoneName(uint16_t id) { return registry().zones[id]; }
+
+    static uint64_t now() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - registry().epoch).count();
+    }
+
+    static void record(uint16_t zone, uint64_t start, uint64_t end) {
+        Ring& r = localRing();
+        uint64_t h = r.head.load(std::memory_order_relaxed);
+        Event& e = r.ev[h & (RING - 1)];
+        e.start = start;
+        e.dur = (uint32_t)std::min<uint64_t>(end - start, 0xFFFFFFFFu);
+        e.zone = zone;
+        r.head.store(h + 1, std::memory_order_release);
+    }
+
+    // p50/p99/max per zone over the events that started in the last windowNs,
+    // in order of first appearance: the calling thread's, or with allThreads
+    // every thread's (a zone timed on several threads is pooled).
+    static void summarize(uint64_t windowNs, std::vector<ZoneStats>& out, bool allThreads = false) {
+        out.clear();
+        std::vector<Event> ev;
+        Ring* mine = &localRing();
+        copyRing(*mine, true, ev);
+        if (allThreads) {
+            Registry& reg = registry();
+            std::vector<Ring*> rings;
+            {
+                std::lock_guard<std::mutex> lock(reg.mtx);
+                rings = reg.rings;
+            }
+            for (Ring* r : rings)
+                if (r != mine) copyRing(*r, false, ev);
+        }
+        uint64_t cutoff = now();
+        cutoff = cutoff > windowNs ? cutoff - windowNs : 0;
+        std::vector<std::vector<uint32_t>> samples(MAX_ZONES);
+        std::vector<uint16_t> order;
+        for (const Event& e : ev) {
+            if (e.start < cutoff) continue;
+            if (samples[e.zone].empty()) order.push_back(e.zone);
+            samples[e.zone].push_back(e.dur);
+        }
+        for (uint16_t z : order) {
+            std::vector<uint32_t>& s = samples[z];
+            ZoneStats st;
+            st.name = zoneName(z);
+            st.count = s.size();
+            size_t k50 = (s.size() - 1) / 2, k99 = (s.size() - 1) * 99 / 100;
+            std::nth_element(s.begin(), s.begin() + k99, s.end());
+            st.p99 = s[k99] / 1000.0;
+            st.max = *std::max_element(s.begin() + k99, s.end()) / 1000.0;
+            std::nth_element(s.begin(), s.begin() + k50, s.begin() + k99);
+            st.p50 = s[k50] / 1000.0;
+            out.push_back(st);
+        }
+    }
+
+    // Complete ("X") events for every thread's ring; returns false if the file can't be written.
+    static bool writeChromeTrace(const char* path) {
+#ifdef _MSC_VER
+        FILE* f = nullptr;
+        if (fopen_s(&f, path, "w") != 0) return false;   // fopen is an error under /sdl
+#else
+        FILE* f = std::fopen(path, "w");
+#endif
+        if (!f) return false;
+        Registry& reg = registry();
+        std::vector<Ring*> rings;
+        {
+            std::lock_guard<std::mutex> lock(reg.mtx);
+            rings = reg.rings;
+        }
+        Ring* mine = &localRing();
+        std::fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+        bool first = true;
+        std::vector<Event> ev;
+        for (Ring* r : rings) {
+            ev.clear();
+            copyRing(*r, r == mine, ev);
+            std::fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", r->tid, r == mine ? "game loop" : "worker");
+            first = false;
+            for (const Event& e : ev)
+                std::fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    zoneName(e.zone), r->tid, e.start / 1000.0, e.dur / 1000.0);
+        }
+        std::fprintf(f, "\n]}\n");
+        return std::fclose(f) == 0;
+    }
+};
+
+// Times the enclosing scope under a zone.
+class ProfileZone {
+    uint16_t zone;
+    uint64_t start;
+public:
+    explicit ProfileZone(uint16_t zoneId) : zone(zoneId), start(Profiler::now()) {}
+    ~ProfileZone() { Profiler::record(zone, start, Profiler::now()); }
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+};
+
+#define PROFILE_CONCAT2(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT2(a, b)
+#if XONIX_PROFILE
+#define PROFILE_ZONE(name) \
+    static const uint16_t PROFILE_CONCAT(profileZoneId_, __LINE__) = Profiler::zone(name); \
+    ProfileZone PROFILE_CONCAT(profileZone_, __LINE__)(PROFILE_CONCAT(profileZoneId_, __LINE__))
+#else
+#define PROFILE_ZONE(name) do {} while (0)
+#endif
@@ -0,0 +1,311 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "NetGame.h"
+
+
+////////////////////////////////  ROLLBACK /////////////////////////////////////
+
+// Two-player peer-to-peer match with rollback. Both peers run the whole
+// simulation and only exchange input frames. Every tick the state is saved
+// into a RING of snapshots, and the remote player's input is predicted (the
+// direction it last held, no key-downs) when it hasn't arrived yet. When a
+// remote frame turns up that differs from what was predicted, the state
+// before that frame is restored and every tick since is re-simulated with the
+// corrected input, all within the same update.
+//
+// The host (seat 0) listens on cfg.port and picks the seed; the joiner
+// (seat 1) knocks with HELLO until the host answers. A peer stops advancing
+// when it is maxPrediction frames ahead of the last confirmed remote input,
+// and the peer that runs ahead of the other gives up a frame now and then,
+// so neither side has to roll back further than it must.
+
+struct RollbackConfig {
+    bool host = true;
+    uint16_t port = 47000;
+    uint32_t seed = 1;       // used by the host; the joiner adopts the host's
+    double tickHz = 60;
+    int maxPrediction = 16;  // frames; at most RING / 2 - 1
+    LinkConditions link;     // applied to this peer's outgoing packets
+};
+
+// State saved every tick: the world plus the round bookkeeping, which must
+// roll back with it.
+struct RollbackState {
+    RoomWorld world;
+    uint32_t overAt;   // tick the round ended at, 0 while it is running
+    uint32_t round;
+};
+
+struct RollbackStats {
+    uint64_t frames = 0;         // ticks simulated the first time
+    uint64_t rollbacks = 0;
+    uint64_t resimTicks = 0;
+    uint64_t predictionStalls = 0, syncStalls = 0;
+    uint64_t packetsSent = 0, bytesSent = 0;
+    std::vector<float> resimMicros;    // restore + re-simulation, one entry per update that rolled back
+    std::vector<uint16_t> resimDepth;  // ticks re-simulated in that update
+};
+
+class RollbackSession {
+public:
+    enum State { CONNECTING, RUNNING };
+    static const int RING = 64;
+    static const int ROUND_PAUSE_TICKS = 180;   // 3 s on the results before the next round
+
+private:
+    static const int SYNC_EVERY = 30;   // frames between time-sync checks
+
+    RollbackConfig cfg;
+    UdpSocket sock;
+    LossyLink link;
+    NetAddress peer;
+    State state = CONNECTING;
+    int seat = 0;
+    uint32_t seed = 0;
+    double nextFrameAt = 0, lastSend = -1;
+
+    RollbackState cur;
+    std::vector<RollbackState> saved;   // saved[f % RING]: state before frame f was simulated
+    InputFrame local[RING], remote[RING], used[RING];   // used: remote input frame f was simulated with
+    uint32_t frame = 1;          // next frame to simulate
+    uint32_t remoteContig = 0;   // every remote frame up to here has arrived
+    uint32_t remoteNewest = 0;
+    uint32_t ackedByPeer = 0;
+    uint32_t rollbackFrom = 0;   // earliest mispredicted frame, 0 for none
+    uint32_t frameLimit = 0;
+    uint32_t lastSyncFrame = 0;
+    int remoteAdvantage = 0;
+    int8_t heldDx = 0, heldDy = 0, pressDx = 0, pressDy = 0;
+    bool freezeQueued = false;
+
+    std::vector<uint8_t> out;
+    uint8_t in[NET_MAX_PACKET];
+    RollbackStats st;
+
+    static bool sameInput(const InputFrame& a, const InputFrame& b) {
+        return a.heldDx == b.heldDx && a.heldDy == b.heldDy && a.pressDx == b.pressDx &&
+            a.pressDy == b.pressDy && a.freeze == b.freeze;
+    }
+
+    void send(double now) {
+        link.send(now, peer, out.data(), out.size());
+        lastSend = now;
+        ++st.packetsSent;
+        st.bytesSent += out.size();
+    }
+
+    void sendHello(double now) {
+        ByteWriter w(out);
+        writeHeader(w, MSG_HELLO);
+        w.u8((uint8_t)seat);
+        w.u32(seed);
+        send(now);
+    }
+
+    void sendInputs(double now) {
+        // oldest unacked first: the peer can't move on until it has those
+        uint32_t first = ackedByPeer + 1, end = frame;
+        if (end - first > (uint32_t)MAX_INPUT_FRAMES) end = first + MAX_INPUT_FRAMES;
+        ByteWriter w(out);
+        writeHeader(w, MSG_PEER_INPUT);
+        w.u32(remoteContig);
+        w.i8((int8_t)advantage());
+        w.varint(end - first);
+        for (uint32_t f = first; f < end; ++f) writeFrame(w, local[f % RING]);
+        send(now);
+    }
+
+    // How many frames this peer runs ahead of the newest one heard from the other.
+    int advantage() const {
+        int a = (int)(frame - 1) - (int)remoteNewest;
+        return a > 127 ? 127 : (a < -127 ? -127 : a);
+    }
+
+    void onHello(double now, const NetAddress& from, ByteReader& r) {
+        int s = r.u8();
+        uint32_t sd = r.u32();
+        if (!r.ok()) return;
+        if (cfg.host) {
+            if (s != 1) return;
+            if (state == CONNECTING) { peer = from; start(now); }
+            if (from == peer) sendHello(now);   // answer every knock; ours may have been lost
+        }
+        else if (state == CONNECTING && s == 0 && from == peer) {
+            seed = sd;
+            start(now);
+        }
+    }
+
+    void onInput(const NetAddress& from, ByteReader& r) {
+        if (state != RUNNING || from != peer) return;
+        uint32_t ack = r.u32();
+        int adv = r.i8();
+        uint32_t count = r.varint();
+        if (!r.ok() || count > MAX_INPUT_FRAMES) return;
+        if (ack > ackedByPeer && ack < frame) ackedByPeer = ack;
+        remoteAdvantage = adv;
+        for (uint32_t i = 0; i < count; ++i) {
+            InputFrame f = readFrame(r);
+            if (!r.ok()) return;
+            if (f.frame <= remoteContig || f.frame >= remoteContig + RING) continue;
+            InputFrame& slot = remote[f.frame % RING];
+            if (slot.frame == f.frame) continue;   // already have it
+            slot = f;
+            if (f.frame > remoteNewest) remoteNewest = f.frame;
+            // already simulated with a guess that turned out wrong
+            if (f.frame < frame && !sameInput(used[f.frame % RING], f) && (!rollbackFrom || f.frame < rollbackFrom))
+                rollbackFrom = f.frame;
+        }
+        while (remote[(remoteContig + 1) % RING].frame == remoteContig + 1) ++remoteContig;
+    }
+
+    void start(double now) {
+        state = RUNNING;
+        std::memset((void*)&cur, 0, sizeof(cur));
+        cur.world.reset(seed, 2);
+        frame = 1;
+        nextFrameAt = now;
+    }
+
+    // The remote player keeps holding what it last held and presses nothing.
+    InputFrame predictRemote() const {
+        InputFrame p{};
+        if (remoteContig) {
+            const InputFrame& last = remote[remoteContig % RING];
+            p.heldDx = last.heldDx;
+            p.heldDy = last.heldDy;
+        }
+        return p;
+    }
+
+    void simulate(uint32_t f) {
+        std::memcpy((void*)&saved[f % RING], &cur, sizeof(RollbackState));
+        InputFrame& r = used[f % RING];
+        r = remote[f % RING].frame == f ? remote[f % RING] : predictRemote();
+        const InputFrame* bySeat[2];
+        bySeat[seat] = &local[f % RING];
+        bySeat[1 - seat] = &r;
+        RoomInput inputs[6];
+        int n = frameInputs(*bySeat[0], 0, inputs);   // seat order, so both peers apply them alike
+        n += frameInputs(*bySeat[1], 1, inputs + n);
+        cur.world.tick(inputs, n);
+
+        if (cur.world.finished()) {
+            if (!cur.overAt) cur.overAt = cur.world.tickNo;
+            else if (cur.world.tickNo - cur.overAt >= ROUND_PAUSE_TICKS) {
+                cur.world.reset(seed + ++cur.round, 2, cur.world.tickNo);   // ticks keep counting across rounds
+                cur.overAt = 0;
+            }
+        }
+    }
+
+    void rollBack() {
+        auto t0 = std::chrono::steady_clock::now();
+        uint32_t from = rollbackFrom;
+        rollbackFrom = 0;
+        std::memcpy((void*)&cur, &saved[from % RING], sizeof(RollbackState));
+        for (uint32_t f = from; f < frame; ++f) simulate(f);
+        auto t1 = std::chrono::steady_clock::now();
+        ++st.rollbacks;
+        st.resimTicks += frame - from;
+        st.resimMicros.push_back(std::chrono::duration<float, std::micro>(t1 - t0).count());
+        st.resimDepth.push_back((uint16_t)(frame - from));
+    }
+
+public:
+    explicit RollbackSession(const RollbackConfig& config)
+        : cfg(config), link(sock, config.link, config.seed * 31 + (config.host ? 1 : 2)), saved(RING) {
+        if (cfg.maxPrediction < 1) cfg.maxPrediction = 1;
+        if (cfg.maxPrediction > RING / 2 - 1) cfg.maxPrediction = RING / 2 - 1;
+        if (cfg.tickHz <= 0) cfg.tickHz = 60;
+        seat = cfg.host ? 0 : 1;
+        seed = cfg.host ? cfg.seed : 0;
+        std::memset(local, 0, sizeof(local));
+        std::memset(remote, 0, sizeof(remote));
+        std::memset(used, 0, sizeof(used));
+        std::memset((void*)&cur, 0, sizeof(cur));
+        cur.world.reset(seed, 2);
+    }
+
+    // Host: binds cfg.port and waits. Joiner: binds any port and knocks on host.
+    bool open(const NetAddress& host) {
+        peer = host;
+        return sock.open(cfg.host ? cfg.port : 0);
+    }
+
+    uint16_t port() const { return sock.localPort(); }
+    State getState() const { return state; }
+    int getSeat() const { return seat; }
+    const RoomWorld& view() const { return cur.world; }
+    const RollbackState& current() const { return cur; }
+    uint32_t currentFrame() const { return frame - 1; }
+    uint32_t confirmedFrame() const { return remoteContig; }
+    const RollbackStats& stats() const { return st; }
+    RollbackStats& stats() { return st; }
+
+    // Stops advancing after frame f (for tests); 0 for no limit.
+    void setFrameLimit(uint32_t f) { frameLimit = f; }
+    // Every frame up to the limit is simulated with real inputs from both sides.
+    bool settled() const { return frameLimit && frame > frameLimit && remoteContig >= frameLimit && !rollbackFrom; }
+
+    // Local controls, folded into the next input frame.
+    void setHeld(int8_t dx, int8_t dy) { heldDx = dx; heldDy = dy; }
+    void press(int8_t dx, int8_t dy) { if (!pressDx && !pressDy) { pressDx = dx; pressDy = dy; } }
+    void freeze() { freezeQueued = true; }
+
+    void update(double now) {
+        NetAddress from;
+        int len;
+        while ((len = sock.receive(from, in, sizeof(in))) >= 0) {
+            ByteReader r(in, (size_t)len);
+            uint8_t type = readHeader(r);
+            if (type == MSG_HELLO) onHello(now, from, r);
+            else if (type == MSG_PEER_INPUT) onInput(from, r);
+        }
+
+        if (state == CONNECTING) {
+            if (!cfg.host && (lastSend < 0 || now - lastSend >= 0.25)) sendHello(now);
+            link.flush(now);
+            return;
+        }
+
+        if (rollbackFrom) rollBack();
+
+        const double period = 1.0 / cfg.tickHz;
+        if (now - nextFrameAt > 5 * period) nextFrameAt = now;   // stalled: don't burst
+        bool produced = false;
+        while (now >= nextFrameAt) {
+            if (frameLimit && frame > frameLimit) { nextFrameAt = now + period; break; }
+            nextFrameAt += period;
+            if (frame - remoteContig > (uint32_t)cfg.maxPrediction) { ++st.predictionStalls; continue; }
+            // the peer that is ahead sits out half the difference
+            if (frame % SYNC_EVERY == 0 && frame != lastSyncFrame) {
+                lastSyncFrame = frame;
+                int ahead = (advantage() - remoteAdvantage) / 2;
+                if (ahead > 0) {
+                    if (ahead > 3) ahead = 3;
+                    st.syncStalls += ahead;
+                    nextFrameAt += (ahead - 1) * period;
+                    continue;
+                }
+            }
+            InputFrame& f = local[frame % RING];
+            f.frame = frame;
+            f.heldDx = heldDx; f.heldDy = heldDy;
+            f.pressDx = pressDx; f.pressDy = pressDy;
+            f.freeze = freezeQueued ? 1 : 0;
+            pressDx = pressDy = 0;
+            freezeQueued = false;
+            simulate(frame);
+            ++frame;
+            ++st.frames;
+            produced = true;
+        }
+        // keep acks flowing while stalled
+        if (produced || now - lastSend >= 0.05) sendInputs(now);
+        link.flush(now);
+    }
+};
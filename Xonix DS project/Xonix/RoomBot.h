@@ -0,0 +1,333 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include "RoomWorld.h"
+
+
+////////////////////////////////  ROOM BOT /////////////////////////////////////
+
+// Computer player for a RoomWorld seat. It needs nothing but the world, so it
+// runs inside a room on the server's worker thread (or in any headless loop)
+// and produces the same RoomInputs a keyboard would.
+//
+// On a wall it plans a rectangular excursion: out a cells, across b cells,
+// and back until it meets a wall again. Enemies only bounce off walls, so
+// their paths for the next few steps can be played forward once per
+// decision on a copy; every cell an enemy will touch (plus a one-cell
+// margin) is tagged with the player steps during which that happens. A plan
+// is safe when none of its trail cells is touched between the step it is
+// laid and the step the trail closes. The safe plans with the largest
+// rectangles are then flood-filled to count what they would actually
+// capture, and the biggest wins. With no safe plan the bot edges along the
+// wall and tries again next step; knocked off a plan mid-trail it takes the
+// quickest way back to a wall and freezes the enemies if that way isn't safe.
+//
+// depth (1..MAX_DEPTH) is the difficulty: it bounds how far out (depth + 1)
+// and across (2 * depth) a plan may go and how many plans get flood-filled.
+
+class RoomBot {
+public:
+    static const int MAX_DEPTH = 8;
+    static const int MAX_PATH = 60;   // steps; safety is tracked per step in a 64-bit mask
+
+    struct Stats {
+        uint64_t decisions = 0;
+        double totalMicros = 0, maxMicros = 0;
+    };
+
+private:
+    struct Cell { int8_t x, y; };
+    struct Scratch {
+        uint64_t threat[M][N];   // bit s: an enemy is at (or next to) the cell during player step s
+        uint16_t visit[M][N];    // stamp of the candidate walking over the cell
+        uint16_t seen[M][N];     // stamp of the flood fill
+        uint16_t stamp, floodStamp;
+        int16_t stack[M * N][2];
+    };
+    struct Candidate {
+        Cell path[MAX_PATH];
+        int len;
+        int estimate;
+    };
+
+    // directions 0..3: left, right, up, down; d ^ 1 is the opposite one
+    static int dirX(int d) { return d == 0 ? -1 : (d == 1 ? 1 : 0); }
+    static int dirY(int d) { return d == 2 ? -1 : (d == 3 ? 1 : 0); }
+
+    uint8_t seat;
+    int depth;
+    uint32_t rng;
+    Cell path[MAX_PATH];
+    int planLen = 0, planPos = 0;
+    Cell from{ 0, 0 };       // where the player should be standing while the plan runs
+    int retryIn = 0;         // ticks before trying to plan again from a wall
+    int idleDir = -1;
+    bool freezeNow = false;
+    Stats st;
+
+    static Scratch& scratch() {
+        static thread_local Scratch s;   // rooms tick on worker threads; one per thread is plenty
+        return s;
+    }
+
+    uint32_t nextRand() {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    }
+
+    static uint64_t steps(int first, int last) {   // bits first..last
+        if (last < first) return 0;
+        uint64_t hi = last >= 63 ? ~0ull : ((1ull << (last + 1)) - 1);
+        return hi & ~((1ull << first) - 1);
+    }
+
+    // Plays the enemies forward and tags the cells they pass through by the
+    // player step they're in; step 0 is the time before the next step.
+    // Opponents out drawing are assumed to carry straight on, and the trail
+    // they'd leave is tagged from the step it would be laid.
+    void buildThreat(const RoomWorld& w, Scratch& s, int firstStepTick, int stepCount) const {
+        std::memset(s.threat, 0, sizeof(s.threat));
+        RoomWorld::Enemy e[RoomWorld::ENEMIES];
+        std::memcpy(e, w.enemies, sizeof(e));
+        int horizon = firstStepTick + stepCount * RoomWorld::STEP_TICKS;
+        for (int t = 1; t <= horizon; ++t) {
+            if (w.freezeEnemies && w.tickNo + t < w.freezeEnd) continue;
+            int step = t < firstStepTick ? 0 : (t - firstStepTick) / RoomWorld::STEP_TICKS + 1;
+            if (step > 63) break;
+            uint64_t bit = 1ull << step;
+            for (int k = 0; k < RoomWorld::ENEMIES; ++k) {
+                w.moveEnemy(e[k]);
+                int r = e[k].y / ts, c = e[k].x / ts;
+                for (int d = -1; d < 4; ++d) {
+                    int rr = d < 0 ? r : r + dirY(d), cc = d < 0 ? c : c + dirX(d);
+                    if (rr >= 0 && rr < M && cc >= 0 && cc < N) s.threat[rr][cc] |= bit;
+                }
+            }
+        }
+        for (int p = 0; p < w.playerCount; ++p) {
+            const RoomWorld::Player& o = w.players[p];
+            if (p == seat || !o.alive || !o.drawing || (!o.dx && !o.dy)) continue;
+            int x = o.x, y = o.y;
+            for (int step = 1; step < 64; ++step) {
+                x += o.dx;
+                y += o.dy;
+                if (x < 0 || x >= N || y < 0 || y >= M || w.G[y][x] == 1) break;
+                s.threat[y][x] |= steps(step, 63);
+            }
+        }
+    }
+
+    // Walks legs of (direction, length) from (x, y); length 0 runs until a
+    // wall. Returns the path length if it ends on a wall, 0 if it crosses a
+    // trail, leaves the board or never gets back to a wall.
+    int walk(const RoomWorld& w, Scratch& s, int x, int y, const int (*legs)[2], int legCount, Cell* out) const {
+        if (++s.stamp == 0) { std::memset(s.visit, 0, sizeof(s.visit)); s.stamp = 1; }
+        int len = 0;
+        for (int l = 0; l < legCount; ++l) {
+            int dir = legs[l][0], want = legs[l][1] ? legs[l][1] : MAX_PATH;
+            for (int k = 0; k < want; ++k) {
+                x += dirX(dir);
+                y += dirY(dir);
+                if (x < 0 || x >= N || y < 0 || y >= M || len >= MAX_PATH) return 0;
+                int8_t v = w.G[y][x];
+                if (v >= RoomWorld::TRAIL || s.visit[y][x] == s.stamp) return 0;
+                out[len++] = Cell{ (int8_t)x, (int8_t)y };
+                if (v == 1) return len;
+                s.visit[y][x] = s.stamp;
+            }
+        }
+        return 0;
+    }
+
+    // Number of (step, cell) pairs on the plan an enemy may reach while the trail is open.
+    static int risk(const Scratch& s, const Cell* p, int len, uint64_t existing) {
+        int hits = (existing & steps(0, len - 1)) ? 1 : 0;
+        for (int i = 0; i + 1 < len; ++i)
+            if (s.threat[p[i].y][p[i].x] & steps(i + 1, len - 1)) ++hits;
+        return hits;
+    }
+
+    // Open cells the plan would enclose, plus its trail.
+    int captured(const RoomWorld& w, Scratch& s, const Candidate& c) const {
+        const int8_t mine = (int8_t)(RoomWorld::TRAIL + seat);
+        if (++s.floodStamp == 0) { std::memset(s.seen, 0, sizeof(s.seen)); s.floodStamp = 1; }
+        const uint16_t mark = s.floodStamp;
+        for (int i = 0; i < c.len; ++i) s.seen[c.path[i].y][c.path[i].x] = mark;   // the new trail blocks
+        int reachedOpen = 0, openTotal = 0;
+        for (int i = 1; i < M - 1; ++i)
+            for (int j = 1; j < N - 1; ++j) openTotal += w.G[i][j] == 0;
+        for (int k = 0; k < RoomWorld::ENEMIES; ++k) {
+            int r = w.enemies[k].y / ts, col = w.enemies[k].x / ts;
+            if (r <= 0 || r >= M - 1 || col <= 0 || col >= N - 1) continue;
+            if (s.seen[r][col] == mark || w.G[r][col] == 1 || w.G[r][col] == mine) continue;
+            int top = 0;
+            s.seen[r][col] = mark;
+            s.stack[top][0] = (int16_t)r; s.stack[top][1] = (int16_t)col; ++top;
+            while (top > 0) {
+                --top;
+                int cr = s.stack[top][0], cc = s.stack[top][1];
+                reachedOpen += w.G[cr][cc] == 0;
+                for (int d = 0; d < 4; ++d) {
+                    int nr = cr + dirY(d), nc = cc + dirX(d);
+                    int8_t v = w.G[nr][nc];
+                    if (s.seen[nr][nc] == mark || v == 1 || v == mine) continue;
+                    s.seen[nr][nc] = mark;
+                    s.stack[top][0] = (int16_t)nr; s.stack[top][1] = (int16_t)nc; ++top;
+                }
+            }
+        }
+        // path cells were never reached, so they're in openTotal - reachedOpen already
+        return openTotal - reachedOpen + w.players[seat].trailLen;
+    }
+
+    void adopt(const Cell* p, int len, const RoomWorld::Player& me) {
+        std::memcpy(path, p, len * sizeof(Cell));
+        planLen = len;
+        planPos = 0;
+        from = Cell{ (int8_t)me.x, (int8_t)me.y };
+    }
+
+    void planFromWall(const RoomWorld& w, Scratch& s, const RoomWorld::Player& me) {
+        const int outMax = depth + 1, acrossMax = 2 * depth;
+        buildThreat(w, s, RoomWorld::STEP_TICKS - w.stepTimer, MAX_PATH);
+
+        // best few safe plans by rectangle size, kept sorted largest first
+        const int keep = 2 + depth;
+        static thread_local Candidate best[2 + MAX_DEPTH];
+        int kept = 0;
+        Candidate c;
+        int rot = nextRand() % 4;
+        for (int dd = 0; dd < 4; ++dd) {
+            int d = (dd + rot) % 4;
+            int nx = me.x + dirX(d), ny = me.y + dirY(d);
+            if (nx < 0 || nx >= N || ny < 0 || ny >= M || w.G[ny][nx] != 0) continue;
+            for (int side = 0; side < 2; ++side) {
+                int t = (d < 2 ? 2 : 0) + side;   // perpendicular
+                for (int a = 1; a <= outMax; ++a)
+                    for (int b = 1; b <= acrossMax; ++b) {
+                        const int legs[3][2] = { { d, a }, { t, b }, { d ^ 1, 0 } };
+                        c.len = walk(w, s, me.x, me.y, legs, 3, c.path);
+                        if (!c.len || risk(s, c.path, c.len, 0)) continue;
+                        c.estimate = a * b + c.len;
+                        int at = kept < keep ? kept++ : keep;
+                        if (at == keep) {
+                            if (c.estimate <= best[keep - 1].estimate) continue;
+                            at = keep - 1;
+                        }
+                        while (at > 0 && best[at - 1].estimate < c.estimate) { best[at] = best[at - 1]; --at; }
+                        best[at] = c;
+                    }
+            }
+        }
+
+        int pick = -1, pickGain = 0;
+        for (int i = 0; i < kept; ++i) {
+            int gain = captured(w, s, best[i]);
+            if (gain > pickGain || (gain == pickGain && pick >= 0 && best[i].len < best[pick].len)) { pick = i; pickGain = gain; }
+        }
+        if (pick >= 0) { adopt(best[pick].path, best[pick].len, me); return; }
+
+        // nothing safe from here: edge along the wall and look again next step
+        int options[4], count = 0;
+        for (int d = 0; d < 4; ++d) {
+            int nx = me.x + dirX(d), ny = me.y + dirY(d);
+            if (nx >= 0 && nx < N && ny >= 0 && ny < M && w.G[ny][nx] == 1) options[count++] = d;
+        }
+        if (!count) return;
+        int d = options[nextRand() % count];
+        for (int i = 0; i < count; ++i) if (options[i] == idleDir) d = idleDir;
+        if (nextRand() % 16 == 0) d = options[nextRand() % count];   // don't pace the same stretch forever
+        idleDir = d;
+        Cell step{ (int8_t)(me.x + dirX(d)), (int8_t)(me.y + dirY(d)) };
+        adopt(&step, 1, me);
+    }
+
+    // Off the wall without a plan: shortest way back, safest first.
+    void planHome(const RoomWorld& w, Scratch& s, const RoomWorld::Player& me) {
+        buildThreat(w, s, RoomWorld::STEP_TICKS - w.stepTimer, MAX_PATH);
+        uint64_t existing = 0;
+        const int8_t mine = (int8_t)(RoomWorld::TRAIL + seat);
+        for (int i = 0; i < M; ++i)
+            for (int j = 0; j < N; ++j)
+                if (w.G[i][j] == mine) existing |= s.threat[i][j];
+
+        Candidate c, pick;
+        pick.len = 0;
+        int pickRisk = 1 << 30;
+        for (int f = 0; f < 4; ++f)
+            for (int k = 1; k <= depth + 1; ++k)
+                for (int g = 0; g < 4; ++g) {
+                    if ((g ^ 1) == f) continue;
+                    const int legs[2][2] = { { f, k }, { g, 0 } };
+                    c.len = walk(w, s, me.x, me.y, legs, 2, c.path);
+                    if (!c.len) continue;
+                    int r = risk(s, c.path, c.len, existing);
+                    if (r < pickRisk || (r == pickRisk && c.len < pick.len)) { pick = c; pickRisk = r; }
+                }
+        if (!pick.len) return;
+        adopt(pick.path, pick.len, me);
+        if (pickRisk && !w.freezeEnemies && me.points.powerUps > 0) freezeNow = true;
+    }
+
+    // Moves along the plan as the player steps; drops it if the player went
+    // elsewhere or someone else's trail has since crossed what's left of it.
+    void follow(const RoomWorld& w, const RoomWorld::Player& me) {
+        if (planPos >= planLen) return;
+        if (me.x == path[planPos].x && me.y == path[planPos].y) {
+            from = path[planPos++];
+        }
+        else if (me.x != from.x || me.y != from.y) { planLen = planPos = 0; return; }
+        for (int i = planPos; i < planLen; ++i)
+            if (w.G[path[i].y][path[i].x] >= RoomWorld::TRAIL) { planLen = planPos = 0; return; }
+    }
+
+public:
+    RoomBot(uint8_t playerSeat = 0, int searchDepth = 4, uint32_t seed = 1)
+        : seat(playerSeat), depth(searchDepth < 1 ? 1 : (searchDepth > MAX_DEPTH ? MAX_DEPTH : searchDepth)),
+        rng(seed ? seed : 0x9e3779b9u) {}
+
+    uint8_t getSeat() const { return seat; }
+    int getDepth() const { return depth; }
+    const Stats& stats() const { return st; }
+
+    // Inputs for the next tick, as the world stands now; writes at most 3.
+    int think(const RoomWorld& w, RoomInput* out) {
+        if (seat >= w.playerCount) return 0;
+        const RoomWorld::Player& me = w.players[seat];
+        if (!me.alive) { planLen = planPos = 0; return 0; }
+        follow(w, me);
+        bool onWall = w.G[me.y][me.x] == 1;
+        if (planPos >= planLen) {
+            planLen = planPos = 0;
+            if (!onWall || retryIn <= 0) {
+                auto t0 = std::chrono::steady_clock::now();
+                Scratch& s = scratch();
+                if (onWall) planFromWall(w, s, me);
+                else planHome(w, s, me);
+                double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+                ++st.decisions;
+                st.totalMicros += us;
+                if (us > st.maxMicros) st.maxMicros = us;
+                retryIn = planLen ? 0 : RoomWorld::STEP_TICKS;
+            }
+            else --retryIn;
+        }
+
+        int n = 0;
+        if (freezeNow) {
+            out[n++] = RoomInput{ seat, 0, 0, RoomInput::FREEZE };
+            freezeNow = false;
+        }
+        int8_t dx = 0, dy = 0;
+        if (planPos < planLen) {
+            dx = (int8_t)(path[planPos].x - me.x);
+            dy = (int8_t)(path[planPos].y - me.y);
+        }
+        if (onWall && (dx || dy)) out[n++] = RoomInput{ seat, dx, dy, RoomInput::PRESS };
+        out[n++] = RoomInput{ seat, dx, dy, RoomInput::HELD };
+        return n;
+    }
+};
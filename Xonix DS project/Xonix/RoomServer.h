@@ -0,0 +1,399 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "MpmcQueue.h"
+#include "Profiler.h"
+#include "RoomBot.h"
+#include "RoomWorld.h"
+
+
+////////////////////////////////  ROOM SERVER /////////////////////////////////////
+
+// Hosts many independent headless rooms (one RoomWorld each) and ticks every
+// room at a fixed rate on a fixed set of worker threads.
+//  - Each worker owns a min-heap of its rooms ordered by next due time and
+//    always runs the earliest one that is due.
+//  - A worker with nothing due steals the most overdue room from another
+//    worker. The stolen room stays with the thief, so load evens out over time.
+//  - A room more than maxLagTicks behind skips ahead instead of replaying its
+//    backlog, and createRoom refuses new rooms once measured load passes
+//    maxLoad. Under overload, rooms are turned away or drop ticks; lateness
+//    never piles up.
+// Front-ends attach() to a room, post inputs into its lock-free mailbox and
+// copy out the world as published after each tick.
+
+struct RoomServerConfig {
+    unsigned workers = 1;
+    double tickHz = 60;
+    int maxLagTicks = 3;         // behind by more than this: skip, don't catch up
+    double maxLoad = 0.85;       // admission limit, fraction of core time; <= 0 admits everything
+    int stealAfterMicros = 500;  // only steal rooms at least this overdue
+};
+
+struct RoomServerStats {
+    size_t rooms = 0;
+    uint64_t ticks = 0, skipped = 0, steals = 0, rejected = 0;
+    double utilisation = 0;    // busy fraction of the cores the workers can actually use
+    double avgTickMicros = 0;
+    double jitterP50 = 0, jitterP99 = 0, jitterMax = 0;   // tick start minus due time, microseconds
+};
+
+class Room {
+    friend class RoomServer;
+    friend class RoomClient;
+
+    static const int INBOX = 64;
+
+    uint32_t id;
+    RoomWorld world;
+    MpmcQueue<RoomInput> inbox;
+    RoomInput pending[INBOX + 3 * RoomWorld::MAX_PLAYERS];   // room for the bots' inputs after the mailbox
+    std::vector<RoomBot> bots;
+    std::atomic<bool> closed;
+    std::atomic<int> clients;
+
+    mutable std::mutex viewMutex;
+    RoomWorld view;   // last published world, refreshed only while clients are attached
+
+public:
+    // The last botCount seats are played by bots of the given depth.
+    Room(uint32_t roomId, uint32_t seed, int players, int botCount = 0, int botDepth = 4)
+        : id(roomId), inbox(INBOX), closed(false), clients(0) {
+        world.reset(seed, players);
+        view = world;
+        for (int p = world.playerCount - std::min(botCount, world.playerCount); p < world.playerCount; ++p)
+            bots.emplace_back((uint8_t)p, botDepth, seed * 2654435761u + p);
+    }
+    uint32_t getID() const { return id; }
+};
+
+// A front-end's connection to one room. Inputs are dropped if the mailbox is
+// full; read() copies the latest published world and returns its tick number.
+class RoomClient {
+    std::shared_ptr<Room> room;
+public:
+    RoomClient() {}
+    explicit RoomClient(std::shared_ptr<Room> r) : room(std::move(r)) {
+        if (room) ++room->clients;
+    }
+    RoomClient(RoomClient&& o) : room(std::move(o.room)) {}
+    RoomClient& operator=(RoomClient&& o) {
+        if (this != &o) { release(); room = std::move(o.room); }
+        return *this;
+    }
+    RoomClient(const RoomClient&) = delete;
+    RoomClient& operator=(const RoomClient&) = delete;
+    ~RoomClient() { release(); }
+
+    bool valid() const { return room != nullptr; }
+
+    bool post(const RoomInput& in) { return room && room->inbox.tryEnqueue(in); }
+
+    uint32_t read(RoomWorld& out) const {
+        std::lock_guard<std::mutex> lock(room->viewMutex);
+        out = room->view;
+        return out.tickNo;
+    }
+
+private:
+    void release() {
+        if (room) --room->clients;
+        room.reset();
+    }
+};
+
+class RoomServer {
+    typedef std::chrono::steady_clock Clock;
+
+    struct Slot {
+        Clock::time_point due;
+        std::shared_ptr<Room> room;
+    };
+    struct LaterFirst {
+        bool operator()(const Slot& a, const Slot& b) const { return a.due > b.due; }
+    };
+
+    // Log-linear lateness histogram: 8 sub-buckets per power of two microseconds.
+    static const int JITTER_BUCKETS = 8 * 30;
+    static int jitterBucket(uint64_t us) {
+        if (us < 8) return (int)us;
+        int e = 3;
+        while ((us >> (e + 1)) != 0) ++e;
+        int b = (e - 2) * 8 + (int)((us >> (e - 3)) & 7);
+        return b < JITTER_BUCKETS ? b : JITTER_BUCKETS - 1;
+    }
+    static double bucketUpper(int b) {
+        if (b < 8) return b + 1;
+        int e = b / 8 + 2;
+        uint64_t base = (uint64_t)1 << e, step = (uint64_t)1 << (e - 3);
+        return (double)(base + (uint64_t)(b % 8 + 1) * step);
+    }
+
+    struct Worker {
+        std::mutex mtx;
+        std::condition_variable cv;
+        std::vector<Slot> heap;
+        std::atomic<size_t> rooms;
+        std::atomic<uint64_t> ticks, skipped, steals, busyNs, maxLateUs;
+        std::atomic<uint64_t> jitter[JITTER_BUCKETS];
+        std::atomic<uint64_t> costTicks, costNs;   // like ticks/busyNs but never reset; feeds admission
+        std::thread thread;
+
+        Worker() : rooms(0), ticks(0), skipped(0), steals(0), busyNs(0), maxLateUs(0), costTicks(0), costNs(0) {
+            for (auto& b : jitter) b.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    RoomServerConfig cfg;
+    Clock::duration period;
+    unsigned cores;   // workers that can run at once
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<bool> stopping;
+    std::atomic<uint64_t> rejected;
+    std::atomic<uint32_t> nextID;
+    Clock::time_point statsSince;
+
+    std::mutex registryMutex;
+    std::unordered_map<uint32_t, std::shared_ptr<Room>> registry;
+
+    // Runs one tick of s.room and schedules its next one; false once the room is closed.
+    bool runRoom(Worker& w, Slot& s, Clock::time_point now) {
+        Room& r = *s.room;
+        if (r.closed.load(std::memory_order_acquire)) return false;
+
+        uint64_t lateUs = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now - s.due).count();
+        w.jitter[jitterBucket(lateUs)].fetch_add(1, std::memory_order_relaxed);
+        if (lateUs > w.maxLateUs.load(std::memory_order_relaxed)) w.maxLateUs.store(lateUs, std::memory_order_relaxed);
+
+        PROFILE_ZONE("room tick");
+        int n = 0;
+        while (n < Room::INBOX && r.inbox.tryDequeue(r.pending[n])) ++n;
+        for (RoomBot& b : r.bots) n += b.think(r.world, r.pending + n);
+        r.world.tick(r.pending, n);
+        if (r.clients.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(r.viewMutex);
+            r.view = r.world;
+        }
+
+        Clock::time_point done = Clock::now();
+        s.due += period;
+        if (done - s.due > period * cfg.maxLagTicks) {
+            uint64_t behind = (uint64_t)((done - s.due) / period);
+            s.due += period * (Clock::duration::rep)behind;
+            w.skipped.fetch_add(behind, std::memory_order_relaxed);
+        }
+        uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(done - now).count();
+        w.ticks.fetch_add(1, std::memory_order_relaxed);
+        w.busyNs.fetch_add(ns, std::memory_order_relaxed);
+        w.costTicks.fetch_add(1, std::memory_order_relaxed);
+        w.costNs.fetch_add(ns, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Takes the most overdue room from some other worker, without waiting on busy locks.
+    bool steal(unsigned self, Clock::time_point now, Slot& out) {
+        const Clock::time_point cutoff = now - std::chrono::microseconds(cfg.stealAfterMicros);
+        for (size_t k = 1; k < workers.size(); ++k) {
+            Worker& v = *workers[(self + k) % workers.size()];
+            std::unique_lock<std::mutex> lock(v.mtx, std::try_to_lock);
+            if (!lock.owns_lock() || v.heap.empty() || v.heap.front().due > cutoff) continue;
+            std::pop_heap(v.heap.begin(), v.heap.end(), LaterFirst());
+            out = std::move(v.heap.back());
+            v.heap.pop_back();
+            v.rooms.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    void workerLoop(unsigned self) {
+        Worker& w = *workers[self];
+        std::unique_lock<std::mutex> lock(w.mtx);
+        while (!stopping.load(std::memory_order_acquire)) {
+            Clock::time_point now = Clock::now();
+            Slot s;
+            bool stolen = false;
+            if (!w.heap.empty() && w.heap.front().due <= now) {
+                std::pop_heap(w.heap.begin(), w.heap.end(), LaterFirst());
+                s = std::move(w.heap.back());
+                w.heap.pop_back();
+                lock.unlock();
+            }
+            else {
+                lock.unlock();
+                stolen = steal(self, now, s);
+                if (!stolen) {
+                    lock.lock();
+                    if (stopping.load(std::memory_order_acquire)) break;
+                    Clock::time_point wake = now + std::chrono::milliseconds(1);   // look for stealable work again
+                    if (!w.heap.empty() && w.heap.front().due < wake) wake = w.heap.front().due;
+                    w.cv.wait_until(lock, wake);
+                    continue;
+                }
+                w.steals.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            bool keep = runRoom(w, s, now);
+            lock.lock();
+            if (keep) {
+                w.heap.push_back(std::move(s));
+                std::push_heap(w.heap.begin(), w.heap.end(), LaterFirst());
+                if (stolen) w.rooms.fetch_add(1, std::memory_order_relaxed);
+            }
+            else if (!stolen) {
+                w.rooms.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+public:
+    explicit RoomServer(const RoomServerConfig& config = RoomServerConfig())
+        : cfg(config), stopping(false), rejected(0), nextID(1) {
+        if (cfg.workers == 0) cfg.workers = 1;
+        if (cfg.tickHz <= 0) cfg.tickHz = 60;
+        if (cfg.maxLagTicks < 1) cfg.maxLagTicks = 1;
+        period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / cfg.tickHz));
+        unsigned hw = std::thread::hardware_concurrency();
+        cores = hw ? std::min(cfg.workers, hw) : cfg.workers;
+        statsSince = Clock::now();
+        for (unsigned i = 0; i < cfg.workers; ++i) workers.emplace_back(new Worker());
+        for (unsigned i = 0; i < cfg.workers; ++i)
+            workers[i]->thread = std::thread(&RoomServer::workerLoop, this, i);
+    }
+
+    RoomServer(const RoomServer&) = delete;
+    RoomServer& operator=(const RoomServer&) = delete;
+
+    ~RoomServer() {
+        stopping.store(true, std::memory_order_release);
+        for (auto& w : workers) {
+            { std::lock_guard<std::mutex> lock(w->mtx); }
+            w->cv.notify_all();
+        }
+        for (auto& w : workers) w->thread.join();
+    }
+
+    const RoomServerConfig& config() const { return cfg; }
+
+    size_t roomCount() {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        return registry.size();
+    }
+
+    // Starts a new room for the given number of players on the least loaded
+    // worker; returns its id, or 0 when admitting it would push the measured
+    // load past maxLoad. The last bots seats are filled by RoomBots.
+    uint32_t createRoom(uint32_t seed, int players = 2, int bots = 0, int botDepth = 4) {
+        if (cfg.maxLoad > 0) {
+            uint64_t ticks = 0, busy = 0;
+            for (auto& w : workers) {
+                ticks += w->costTicks.load(std::memory_order_relaxed);
+                busy += w->costNs.load(std::memory_order_relaxed);
+            }
+            if (ticks >= 1000) {
+                double perTick = (double)busy / ticks * 1e-9;
+                double load = (roomCount() + 1) * perTick * cfg.tickHz / cores;
+                if (load > cfg.maxLoad) {
+                    rejected.fetch_add(1, std::memory_order_relaxed);
+                    return 0;
+                }
+            }
+        }
+
+        uint32_t id = nextID.fetch_add(1, std::memory_order_relaxed);
+        std::shared_ptr<Room> room = std::make_shared<Room>(id, seed, players, bots, botDepth);
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            registry[id] = room;
+        }
+        size_t best = 0;
+        for (size_t i = 1; i < workers.size(); ++i)
+            if (workers[i]->rooms.load(std::memory_order_relaxed) < workers[best]->rooms.load(std::memory_order_relaxed))
+                best = i;
+        Worker& w = *workers[best];
+        {
+            std::lock_guard<std::mutex> lock(w.mtx);
+            w.heap.push_back(Slot{ Clock::now() + period, room });
+            std::push_heap(w.heap.begin(), w.heap.end(), LaterFirst());
+            w.rooms.fetch_add(1, std::memory_order_relaxed);
+        }
+        w.cv.notify_one();
+        return id;
+    }
+
+    // Stops ticking a room; attached clients keep their last view.
+    bool closeRoom(uint32_t id) {
+        std::shared_ptr<Room> room;
+        {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            auto it = registry.find(id);
+            if (it == registry.end()) return false;
+            room = it->second;
+            registry.erase(it);
+        }
+        room->closed.store(true, std::memory_order_release);
+        return true;
+    }
+
+    // Invalid client if the room doesn't exist.
+    RoomClient attach(uint32_t id) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        auto it = registry.find(id);
+        return it == registry.end() ? RoomClient() : RoomClient(it->second);
+    }
+
+    // Counters since construction or the last resetStats().
+    RoomServerStats stats() {
+        RoomServerStats st;
+        st.rooms = roomCount();
+        st.rejected = rejected.load(std::memory_order_relaxed);
+        uint64_t busy = 0, hist[JITTER_BUCKETS] = {}, samples = 0, maxUs = 0;
+        for (auto& w : workers) {
+            st.ticks += w->ticks.load(std::memory_order_relaxed);
+            st.skipped += w->skipped.load(std::memory_order_relaxed);
+            st.steals += w->steals.load(std::memory_order_relaxed);
+            busy += w->busyNs.load(std::memory_order_relaxed);
+            maxUs = std::max<uint64_t>(maxUs, w->maxLateUs.load(std::memory_order_relaxed));
+            for (int b = 0; b < JITTER_BUCKETS; ++b) {
+                uint64_t c = w->jitter[b].load(std::memory_order_relaxed);
+                hist[b] += c;
+                samples += c;
+            }
+        }
+        double elapsed = std::chrono::duration<double>(Clock::now() - statsSince).count();
+        if (elapsed > 0) st.utilisation = busy * 1e-9 / (elapsed * cores);
+        if (st.ticks) st.avgTickMicros = busy * 1e-3 / st.ticks;
+        uint64_t seen = 0;
+        bool have50 = false;
+        for (int b = 0; b < JITTER_BUCKETS && samples; ++b) {
+            seen += hist[b];
+            if (!have50 && seen * 2 >= samples) { st.jitterP50 = bucketUpper(b); have50 = true; }
+            if (seen * 100 >= samples * 99) { st.jitterP99 = bucketUpper(b); break; }
+        }
+        st.jitterMax = (double)maxUs;
+        st.jitterP50 = std::min(st.jitterP50, st.jitterMax);   // bucket bounds can overshoot the real max
+        st.jitterP99 = std::min(st.jitterP99, st.jitterMax);
+        return st;
+    }
+
+    void resetStats() {
+        for (auto& w : workers) {
+            w->ticks.store(0, std::memory_order_relaxed);
+            w->skipped.store(0, std::memory_order_relaxed);
+            w->steals.store(0, std::memory_order_relaxed);
+            w->busyNs.store(0, std::memory_order_relaxed);
+            w->maxLateUs.store(0, std::memory_order_relaxed);
+            for (auto& b : w->jitter) b.store(0, std::memory_order_relaxed);
+        }
+        rejected.store(0, std::memory_order_relaxed);
+        statsSince = Clock::now();
+    }
+};
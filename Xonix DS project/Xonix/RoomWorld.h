@@ -0,0 +1,375 @@
+#pragma once
+#include <cstdint>
+#include "Board.h"
+#include "InputQueue.h"
+#include "TimerWheel.h"
+
+
+////////////////////////////////  ROOM WORLD /////////////////////////////////////
+
+// Headless state of one territory match for 2..MAX_PLAYERS players: the shared
+// board, the players, the enemies and the scores. It never touches a window
+// or a global, so any number of rooms can be ticked side by side on worker
+// threads, and a copy is a complete snapshot of the match.
+// One tick() is one 60 Hz frame of the old runMultiplayerMode loop: enemies
+// move every tick, players step every STEP_TICKS ticks.
+//
+// Each player lays its own trail id (2 + index). Everyone who closes a trail
+// in the same step is resolved by one capture pass over the board, so the
+// cost doesn't depend on how many players close at once. Other players'
+// in-flight trails are left alone, and a dead player's trail is cleared.
+// Captured cells record their owner and territory[] is updated as cells
+// change hands, never recounted.
+
+// Scoring rules shared with the single-player PointsTracker.
+struct ScoreCounter {
+    int score = 0, bonus = 0, powerUps = 0, par = 50;
+
+    void add(int tiles) {
+        int pts = tiles;
+        if ((bonus < 3 && tiles > 10) || (bonus >= 3 && bonus < 5 && tiles > 5)) { pts *= 2; bonus++; }
+        else if (bonus >= 5 && tiles > 5) pts *= 4;
+        score += pts;
+        while (score >= par) { powerUps++; par += (par == 50 ? 20 : 30); }
+    }
+
+    bool use() {
+        if (powerUps <= 0) return false;
+        powerUps--;
+        return true;
+    }
+};
+
+// One input event from a front-end. PRESS is a key-down: presses queue per
+// player and each player step takes one, turning the player (and moving it a
+// cell off a wall), so no tap is lost to a later one. HELD is the direction
+// currently held down ((0,0) for none), which steers a sliding player on steps
+// with no press queued. FREEZE spends a power-up.
+struct RoomInput {
+    enum : uint8_t { PRESS = 1, HELD = 2, FREEZE = 4 };
+    uint8_t player;
+    int8_t dx, dy;
+    uint8_t flags;
+};
+
+struct RoomWorld {
+    static const int MAX_PLAYERS = 8;
+    static const int ENEMIES = 4;
+    static const int STEP_TICKS = 5;       // player moves every 5th frame (the old 0.07 s delay at 60 fps)
+    static const int FREEZE_TICKS = 180;   // 3 s
+    static const int8_t TRAIL = 2;         // G value of player p's trail is TRAIL + p
+    static const int TIMERS = 16;          // timed effects pending at once
+
+    enum TimerKind : uint8_t { THAW = 1 };  // the freeze wears off
+
+    struct Player {
+        int x, y, dx, dy;
+        int heldDx, heldDy;
+        bool alive, drawing, frozen;
+        InputQueue turns;   // presses waiting for this player's next steps; stamped with tickNo
+        int trailLen;   // cells of the current in-flight trail
+        ScoreCounter points;
+    };
+    struct Enemy {
+        int x, y, dx, dy;
+    };
+
+    int8_t G[M][N];       // 0 open, 1 wall, TRAIL + p = player p's trail
+    int8_t owner[M][N];   // player who captured a wall cell; -1 for the border and open cells
+    int territory[MAX_PLAYERS];
+    int playerCount;
+    Player players[MAX_PLAYERS];
+    Enemy enemies[ENEMIES];
+    bool freezeEnemies;
+    uint32_t freezeEnd;   // tick at which a freeze wears off (for bots; the wheel ends it)
+    TimerWheel<TIMERS> timers;   // timed effects, due on tickNo
+    uint32_t tickNo;
+    int stepTimer;
+    uint32_t rng;
+    uint32_t dying;       // players killed this tick whose trails still need clearing
+
+    // startTick is where tickNo (and the timer wheel) carry on from, so a new
+    // round can keep counting ticks without the wheel replaying the gap.
+    void reset(uint32_t seed, int numPlayers = 2, uint32_t startTick = 0) {
+        for (int i = 0; i < M; ++i)
+            for (int j = 0; j < N; ++j) {
+                G[i][j] = (i == 0 || j == 0 || i == M - 1 || j == N - 1) ? 1 : 0;
+                owner[i][j] = -1;
+            }
+        rng = seed ? seed : 0x9e3779b9u;
+        for (int k = 0; k < ENEMIES; ++k) {
+            Enemy& e = enemies[k];
+            e.x = e.y = 300;
+            e.dx = 4 - (int)(nextRand() % 8);
+            e.dy = 4 - (int)(nextRand() % 8);
+            if (e.dx == 0 && e.dy == 0) e.dx = 1;
+        }
+        playerCount = numPlayers < 2 ? 2 : (numPlayers > MAX_PLAYERS ? MAX_PLAYERS : numPlayers);
+        // spawn points on the border; the first two are the classic two-player spots
+        const int spawn[MAX_PLAYERS][2] = {
+            { 10, 0 }, { N - 11, 0 }, { 10, M - 1 }, { N - 11, M - 1 },
+            { 0, 8 }, { N - 1, 8 }, { 0, M - 9 }, { N - 1, M - 9 }
+        };
+        for (int p = 0; p < MAX_PLAYERS; ++p) {
+            Player& pl = players[p];
+            pl.x = spawn[p][0]; pl.y = spawn[p][1];
+            pl.dx = pl.dy = pl.heldDx = pl.heldDy = 0;
+            pl.alive = p < playerCount;
+            pl.drawing = pl.frozen = false;
+            pl.turns.clear();   // padding included, so snapshots compare equal
+            pl.trailLen = 0;
+            pl.points = ScoreCounter();
+            territory[p] = 0;
+        }
+        freezeEnemies = false;
+        freezeEnd = tickNo = startTick;
+        timers.reset(startTick);
+        stepTimer = 0;
+        dying = 0;
+    }
+
+    int aliveCount() const {
+        int n = 0;
+        for (int p = 0; p < playerCount; ++p) n += players[p].alive;
+        return n;
+    }
+
+    bool finished() const { return aliveCount() == 0; }
+
+    // One frame of an enemy's motion against the current walls. Trails don't
+    // deflect enemies, so bots can use this to look ahead.
+    void moveEnemy(Enemy& e) const {
+        e.x += e.dx;
+        int gy = e.y / ts, gx = e.x / ts;
+        if (gx <= 0 || gx >= N - 1 || G[gy][gx] == 1) { e.dx = -e.dx; e.x += e.dx; }
+        e.y += e.dy;
+        gy = e.y / ts; gx = e.x / ts;
+        if (gy <= 0 || gy >= M - 1 || G[gy][gx] == 1) { e.dy = -e.dy; e.y += e.dy; }
+        if (e.x < 0) e.x = 0; else if (e.x > N * ts) e.x = N * ts;
+        if (e.y < 0) e.y = 0; else if (e.y > M * ts) e.y = M * ts;
+    }
+
+    // Advances one frame, applying this frame's inputs first, in order.
+    void tick(const RoomInput* inputs, int count) {
+        ++tickNo;
+        timers.advance(tickNo, [this](uint8_t kind, uint8_t arg) { onTimer(kind, arg); });
+        for (int i = 0; i < count; ++i) apply(inputs[i]);
+
+        if (++stepTimer >= STEP_TICKS) {
+            stepTimer = 0;
+            stepPlayers();
+        }
+
+        if (!freezeEnemies) {
+            for (int k = 0; k < ENEMIES; ++k) {
+                moveEnemy(enemies[k]);
+                int gy = enemies[k].y / ts, gx = enemies[k].x / ts;
+                if (gy > 0 && gy < M && gx > 0 && gx < N && G[gy][gx] >= TRAIL)
+                    kill(G[gy][gx] - TRAIL);
+            }
+        }
+
+        // head-on: whoever is out drawing loses
+        for (int p = 0; p < playerCount; ++p)
+            for (int q = p + 1; q < playerCount; ++q) {
+                Player& a = players[p];
+                Player& b = players[q];
+                if (!a.alive || !b.alive || a.x != b.x || a.y != b.y) continue;
+                bool consA = G[a.y][a.x] != 1 && a.drawing;
+                bool consB = G[b.y][b.x] != 1 && b.drawing;
+                if (consA) kill(p);
+                if (consB) kill(q);
+            }
+
+        clearDeadTrails();
+    }
+
+private:
+    uint32_t nextRand() {   // xorshift32; rand() is neither per-room nor thread-safe
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        return rng;
+    }
+
+    void onTimer(uint8_t kind, uint8_t) {
+        if (kind == THAW) {
+            freezeEnemies = false;
+            for (int p = 0; p < playerCount; ++p) players[p].frozen = false;
+        }
+    }
+
+    void kill(int p) {
+        if (!players[p].alive) return;
+        players[p].alive = false;
+        dying |= 1u << p;
+    }
+
+    // One sweep removes the in-flight trails of everyone who died this tick.
+    void clearDeadTrails() {
+        if (!dying) return;
+        for (int i = 1; i < M - 1; ++i)
+            for (int j = 1; j < N - 1; ++j)
+                if (G[i][j] >= TRAIL && (dying >> (G[i][j] - TRAIL) & 1)) G[i][j] = 0;
+        for (int p = 0; p < playerCount; ++p)
+            if (dying >> p & 1) { players[p].trailLen = 0; players[p].drawing = false; }
+        dying = 0;
+    }
+
+    void apply(const RoomInput& in) {
+        if (in.player >= playerCount) return;
+        Player& pl = players[in.player];
+        if (in.flags & RoomInput::PRESS) {
+            if (pl.alive && !pl.frozen && (in.dx || in.dy)) pl.turns.push(in.dx, in.dy, tickNo);
+        }
+        if (in.flags & RoomInput::HELD) {
+            pl.heldDx = in.dx;
+            pl.heldDy = in.dy;
+        }
+        if (in.flags & RoomInput::FREEZE) {
+            // freezes the enemies and every other player
+            if (pl.alive && !freezeEnemies && pl.points.use()) {
+                freezeEnemies = true;
+                for (int q = 0; q < playerCount; ++q) players[q].frozen = q != in.player;
+                freezeEnd = tickNo + FREEZE_TICKS;
+                timers.schedule(freezeEnd, THAW);
+            }
+        }
+    }
+
+    static int clampTo(int v, int lo, int hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+    void stepPlayers() {
+        for (int p = 0; p < playerCount; ++p) {
+            Player& pl = players[p];
+            if (!pl.alive || pl.frozen) continue;
+            // one queued press per step; with none, a held key steers the slide
+            TimedTurn turn;
+            const bool turned = pl.turns.pop(turn);
+            const bool onWall = G[pl.y][pl.x] == 1;
+            if (turned) { pl.dx = turn.dx; pl.dy = turn.dy; }
+            else if (!onWall && (pl.heldDx || pl.heldDy)) { pl.dx = pl.heldDx; pl.dy = pl.heldDy; }
+            if (turned || !onWall) {
+                pl.x = clampTo(pl.x + pl.dx, 0, N - 1);
+                pl.y = clampTo(pl.y + pl.dy, 0, M - 1);
+            }
+            int8_t& c = G[pl.y][pl.x];
+            if (c == 0) { c = (int8_t)(TRAIL + p); pl.drawing = true; ++pl.trailLen; }
+            else if (c == TRAIL + p && pl.drawing) kill(p);
+        }
+
+        // judged on everyone's new positions, before any trail is cleared
+        for (int p = 0; p < playerCount; ++p) {
+            Player& pl = players[p];
+            if (!pl.alive) continue;
+            int8_t c = G[pl.y][pl.x];
+            // stepping onto another player's trail
+            if (c >= TRAIL && c != TRAIL + p) { kill(p); continue; }
+            // drawing into another player who stands on a wall
+            if (!pl.drawing) continue;
+            for (int q = 0; q < playerCount; ++q) {
+                const Player& o = players[q];
+                if (q != p && o.alive && o.x == pl.x && o.y == pl.y && G[o.y][o.x] == 1) { kill(p); break; }
+            }
+        }
+
+        uint32_t closing = 0;
+        for (int p = 0; p < playerCount; ++p) {
+            Player& pl = players[p];
+            if (pl.alive && G[pl.y][pl.x] == 1 && pl.drawing) {
+                pl.drawing = false;
+                closing |= 1u << p;
+            }
+        }
+        clearDeadTrails();
+        if (closing) capture(closing);
+    }
+
+    bool closingTrail(int8_t c, uint32_t closing) const {
+        return c >= TRAIL && (closing >> (c - TRAIL) & 1);
+    }
+
+    // Resolves every trail closed this step in one pass:
+    //  1. flood from the enemies through open cells and still-open trails;
+    //  2. each open region they can't reach goes to the closing player with
+    //     the most trail cells along its edge;
+    //  3. closing trails turn into their owners' walls.
+    // Work is O(M*N) however many players close together.
+    void capture(uint32_t closing) {
+        enum : uint8_t { UNSEEN = 0, REACHED = 1, CLAIMED = 2 };
+        uint8_t mark[M][N] = {};
+        int16_t stack[M * N][2];
+        int gained[MAX_PLAYERS] = {};
+
+        // 1. what the enemies can still reach
+        for (int k = 0; k < ENEMIES; ++k) {
+            int r = enemies[k].y / ts, c = enemies[k].x / ts;
+            if (r <= 0 || r >= M - 1 || c <= 0 || c >= N - 1) continue;
+            if (mark[r][c] || G[r][c] == 1 || closingTrail(G[r][c], closing)) continue;
+            int top = 0;
+            mark[r][c] = REACHED;
+            stack[top][0] = (int16_t)r; stack[top][1] = (int16_t)c; ++top;
+            while (top > 0) {
+                --top;
+                int cr = stack[top][0], cc = stack[top][1];
+                const int nr[4] = { cr - 1, cr + 1, cr, cr };
+                const int nc[4] = { cc, cc, cc - 1, cc + 1 };
+                for (int d = 0; d < 4; ++d) {
+                    int8_t v = G[nr[d]][nc[d]];
+                    if (mark[nr[d]][nc[d]] || v == 1 || closingTrail(v, closing)) continue;
+                    mark[nr[d]][nc[d]] = REACHED;
+                    stack[top][0] = (int16_t)nr[d]; stack[top][1] = (int16_t)nc[d]; ++top;
+                }
+            }
+        }
+
+        // 2. enclosed open regions, one component at a time
+        for (int i = 1; i < M - 1; ++i)
+            for (int j = 1; j < N - 1; ++j) {
+                if (G[i][j] != 0 || mark[i][j]) continue;
+                int edge[MAX_PLAYERS] = {};
+                int size = 0, top = 0;
+                mark[i][j] = CLAIMED;
+                stack[size][0] = (int16_t)i; stack[size][1] = (int16_t)j; ++size;
+                while (top < size) {   // the stack doubles as the component's cell list
+                    int cr = stack[top][0], cc = stack[top][1];
+                    ++top;
+                    const int nr[4] = { cr - 1, cr + 1, cr, cr };
+                    const int nc[4] = { cc, cc, cc - 1, cc + 1 };
+                    for (int d = 0; d < 4; ++d) {
+                        int8_t v = G[nr[d]][nc[d]];
+                        if (closingTrail(v, closing)) { ++edge[v - TRAIL]; continue; }
+                        if (v != 0 || mark[nr[d]][nc[d]]) continue;
+                        mark[nr[d]][nc[d]] = CLAIMED;
+                        stack[size][0] = (int16_t)nr[d]; stack[size][1] = (int16_t)nc[d]; ++size;
+                    }
+                }
+                int best = -1;
+                for (int p = 0; p < playerCount; ++p)
+                    if ((closing >> p & 1) && (best < 0 || edge[p] > edge[best])) best = p;
+                for (int k = 0; k < size; ++k) {
+                    int cr = stack[k][0], cc = stack[k][1];
+                    G[cr][cc] = 1;
+                    owner[cr][cc] = (int8_t)best;
+                }
+                territory[best] += size;
+                gained[best] += size;
+            }
+
+        // 3. closing trails become walls
+        for (int i = 1; i < M - 1; ++i)
+            for (int j = 1; j < N - 1; ++j)
+                if (closingTrail(G[i][j], closing)) {
+                    int p = G[i][j] - TRAIL;
+                    G[i][j] = 1;
+                    owner[i][j] = (int8_t)p;
+                    ++territory[p];
+                }
+
+        for (int p = 0; p < playerCount; ++p)
+            if (closing >> p & 1) {
+                players[p].points.add(players[p].trailLen + gained[p]);
+                players[p].trailLen = 0;
+            }
+    }
+};
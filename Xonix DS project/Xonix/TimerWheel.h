@@ -0,0 +1,182 @@
+#pragma once
+#include <cstdint>
+
+
+////////////////////////////////  TIMER WHEEL /////////////////////////////////////
+
+// Timed effects of one world (a freeze wearing off, and whatever comes next)
+// as events due on a simulation tick, instead of a clock or a countdown per
+// effect checked every frame.
+//
+// Three wheels of 64 slots: level 0 holds events due in the next 64 ticks,
+// one slot per tick; level 1 the next 4096 ticks, 64 ticks a slot; level 2
+// the next 262144 ticks (over an hour at 60 Hz), 4096 a slot, with anything
+// further parked in its last slot. Scheduling links an event into its slot;
+// each tick expires one level-0 slot, and every 64th tick first moves one
+// level-1 slot (every 4096th, one level-2 slot) down into the finer wheels.
+// So scheduling, cancelling and expiring are O(1) per event, and a tick
+// with nothing due is a bit test.
+//
+// Everything lives in fixed arrays of small indices: a world holding a wheel
+// stays trivially copyable, so rollback and net snapshots copy it as bytes.
+// Events due on the same tick fire in the order they were scheduled, so a
+// replay of the same inputs fires the same events in the same order.
+
+template<int CAPACITY>
+class TimerWheel {
+    static_assert(CAPACITY > 0 && CAPACITY < 255, "event indices are bytes");
+
+public:
+    typedef uint32_t Handle;           // 0 is never a live event
+    static const int SLOTS = 64, LEVELS = 3;
+
+private:
+    static const uint8_t NONE = 0xFF;
+
+    struct Event {
+        uint32_t due;
+        uint16_t seq;                  // scheduling order; also the handle's generation
+        uint8_t next, prev;            // neighbours in the slot, or the free list's next
+        uint8_t slot;                  // level * SLOTS + slot, NONE when free
+        uint8_t kind, arg;
+    };
+
+    Event events[CAPACITY];
+    uint8_t heads[LEVELS * SLOTS];
+    uint64_t occupied[LEVELS];         // bit s: slot s of the level has events
+    uint8_t freeHead;
+    uint16_t nextSeq;
+    uint16_t live;
+    uint32_t current;                  // last tick advanced to
+
+    void link(uint8_t i) {
+        Event& e = events[i];
+        const uint32_t delta = e.due - current;
+        int level, s;
+        if (delta < SLOTS) { level = 0; s = e.due & (SLOTS - 1); }
+        else if (delta < SLOTS * SLOTS) { level = 1; s = (e.due >> 6) & (SLOTS - 1); }
+        else {
+            level = 2;
+            const uint32_t reach = delta < SLOTS * SLOTS * SLOTS ? e.due : current + SLOTS * SLOTS * SLOTS - 1;
+            s = (reach >> 12) & (SLOTS - 1);
+        }
+        const int at = level * SLOTS + s;
+        e.slot = (uint8_t)at;
+        e.prev = NONE;
+        e.next = heads[at];
+        if (e.next != NONE) events[e.next].prev = i;
+        heads[at] = i;
+        occupied[level] |= 1ull << s;
+    }
+
+    void unlink(uint8_t i) {
+        Event& e = events[i];
+        if (e.prev != NONE) events[e.prev].next = e.next; else heads[e.slot] = e.next;
+        if (e.next != NONE) events[e.next].prev = e.prev;
+        if (heads[e.slot] == NONE) occupied[e.slot / SLOTS] &= ~(1ull << (e.slot % SLOTS));
+    }
+
+    void release(uint8_t i) {
+        events[i].slot = NONE;
+        events[i].next = freeHead;
+        freeHead = i;
+        --live;
+    }
+
+    // Moves every event of a coarse slot down to where it now belongs.
+    void cascade(int level, int s) {
+        if (!(occupied[level] >> s & 1)) return;
+        uint8_t i = heads[level * SLOTS + s];
+        heads[level * SLOTS + s] = NONE;
+        occupied[level] &= ~(1ull << s);
+        while (i != NONE) {
+            const uint8_t next = events[i].next;
+            link(i);
+            i = next;
+        }
+    }
+
+public:
+    // Empties the wheel and sets the tick it counts from.
+    void reset(uint32_t now) {
+        for (int i = 0; i < CAPACITY; ++i) {
+            events[i].slot = NONE;
+            events[i].next = (uint8_t)(i + 1 < CAPACITY ? i + 1 : NONE);
+        }
+        for (int i = 0; i < LEVELS * SLOTS; ++i) heads[i] = NONE;
+        for (int l = 0; l < LEVELS; ++l) occupied[l] = 0;
+        freeHead = 0;
+        nextSeq = 1;
+        live = 0;
+        current = now;
+    }
+
+    // Schedules an event for tick due (the next tick at the earliest).
+    // Returns 0 if all CAPACITY events are pending.
+    Handle schedule(uint32_t due, uint8_t kind, uint8_t arg = 0) {
+        if (freeHead == NONE) return 0;
+        const uint8_t i = freeHead;
+        Event& e = events[i];
+        freeHead = e.next;
+        ++live;
+        if ((int32_t)(due - current) < 1) due = current + 1;
+        e.due = due;
+        e.seq = nextSeq++;
+        if (!nextSeq) nextSeq = 1;
+        e.kind = kind;
+        e.arg = arg;
+        link(i);
+        return (Handle)e.seq << 8 | i;
+    }
+
+    // False if the event already fired or was cancelled.
+    bool cancel(Handle h) {
+        const uint8_t i = (uint8_t)(h & 0xFF);
+        if (!h || i >= CAPACITY || events[i].slot == NONE || events[i].seq != (uint16_t)(h >> 8)) return false;
+        unlink(i);
+        release(i);
+        return true;
+    }
+
+    bool pending(Handle h) const {
+        const uint8_t i = (uint8_t)(h & 0xFF);
+        return h && i < CAPACITY && events[i].slot != NONE && events[i].seq == (uint16_t)(h >> 8);
+    }
+
+    // Tick a pending event is due on.
+    uint32_t dueOf(Handle h) const { return events[h & 0xFF].due; }
+
+    int size() const { return live; }
+    uint32_t now() const { return current; }
+
+    // Steps to tick `to`, one tick at a time, calling fire(kind, arg) for each
+    // event as it comes due. fire may schedule or cancel events.
+    template<typename F>
+    void advance(uint32_t to, F fire) {
+        while ((int32_t)(to - current) > 0) {
+            const uint32_t t = ++current;
+            if (!(t & (SLOTS - 1))) {
+                if (!(t & (SLOTS * SLOTS - 1))) cascade(2, (t >> 12) & (SLOTS - 1));
+                cascade(1, (t >> 6) & (SLOTS - 1));
+            }
+            const int s = t & (SLOTS - 1);
+            if (!(occupied[0] >> s & 1)) continue;
+
+            // take the slot, then fire in scheduling order
+            uint8_t due[CAPACITY];
+            int n = 0;
+            for (uint8_t i = heads[s]; i != NONE; i = events[i].next) due[n++] = i;
+            heads[s] = NONE;
+            occupied[0] &= ~(1ull << s);
+            for (int a = 1; a < n; ++a)
+                for (int b = a; b > 0 && (int16_t)(events[due[b]].seq - events[due[b - 1]].seq) < 0; --b) {
+                    uint8_t tmp = due[b]; due[b] = due[b - 1]; due[b - 1] = tmp;
+                }
+            for (int k = 0; k < n; ++k) {
+                const uint8_t kind = events[due[k]].kind, arg = events[due[k]].arg;
+                release(due[k]);
+                fire(kind, arg);
+            }
+        }
+    }
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+
+////////////////////////////////  TRIPLE BUFFER /////////////////////////////////////
+
+// Hands the newest value from one writer thread to one reader thread without
+// either side ever waiting or copying under a lock.
+// Of the three slots the writer owns one (back), the reader owns one (front)
+// and the third (middle) is parked in a shared atomic index. publish() swaps
+// the freshly written back slot into the middle; fetch() swaps the middle out
+// into the front if it was published since the last fetch. Each is one atomic
+// exchange, so a stalled reader only means the writer keeps overwriting the
+// middle, and a stalled writer only means the reader keeps its last value.
+// After publish() the new back slot holds an older value: write every field.
+
+template<typename T>
+class TripleBuffer {
+    static const uint8_t INDEX = 3, FRESH = 4;   // middle = slot index | FRESH if unread
+
+    // the index each side touches sits on its own cache line
+    T slots[3];
+    char pad0[64];
+    std::atomic<uint8_t> middle;
+    char pad1[64];
+    uint8_t back;    // writer's
+    char pad2[64];
+    uint8_t front;   // reader's
+
+public:
+    TripleBuffer() : middle(1), back(0), front(2) {}
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Writer side: fill this, then publish().
+    T& writeSlot() { return slots[back]; }
+
+    void publish() {
+        back = middle.exchange((uint8_t)(back | FRESH), std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Reader side: true if a newer value was taken into readSlot().
+    bool fetch() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    const T& readSlot() const { return slots[front]; }
+};
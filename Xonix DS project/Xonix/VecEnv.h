@@ -0,0 +1,289 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <vector>
+#include "Board.h"
+#include "GridKernels.h"
+#include "RoomWorld.h"
+#include "WorkerPool.h"
+
+
+////////////////////////////////  VECTOR ENV /////////////////////////////////////
+
+// B independent single-player worlds stepped together, for training bots.
+// One step is one player move (RoomWorld::STEP_TICKS frames of enemy motion),
+// with the single-player rules: the player slides while off the wall, a
+// direction on the wall moves exactly one cell, crossing your own trail or
+// an enemy touching it ends the episode, and closing a trail fills every
+// region no enemy can reach. Rewards are the ScoreCounter (PointsTracker)
+// points earned by the step.
+//
+// State is kept as structure-of-arrays, one column per field across all
+// worlds. Observations go straight into caller-owned buffers given to bind():
+// in OBS_BYTES mode the caller's grid buffer *is* the board storage (0 open,
+// 1 wall, 2 trail), so nothing is copied at all; in OBS_BITS mode each world
+// gets a wall plane and a trail plane of packed bits, updated incrementally.
+// Worlds that finish are reset inside the same step (done[] tells which), so
+// the caller never has to reset one by hand.
+// Worlds are split into contiguous chunks across the calling thread and a
+// WorkerPool; each world is only ever touched by one thread per step.
+
+class VecEnv {
+public:
+    enum Action : uint8_t { NOOP = 0, LEFT, RIGHT, UP, DOWN, FREEZE, ACTION_COUNT };
+    enum ObsMode { OBS_BYTES = 0, OBS_BITS = 1 };
+    enum Done : uint8_t { RUNNING = 0, TERMINATED = 1, TRUNCATED = 2 };
+    enum PlayerField { PX = 0, PY, PDX, PDY, POWER_UPS, FREEZE_LEFT, PLAYER_FIELDS };
+    static const int CELLS = M * N;
+    static const int PLANE_BYTES = (CELLS + 7) / 8;
+    static const int MAX_ENEMIES = 8;
+    static const int FREEZE_STEPS = RoomWorld::FREEZE_TICKS / RoomWorld::STEP_TICKS;
+
+    // Caller-owned, contiguous, world-major. Sizes per world: grid gridBytes(),
+    // player PLAYER_FIELDS, enemies 2 * enemyCount() (x, y in pixels),
+    // reward 1, done 1, action 1 (read by step()).
+    struct Buffers {
+        uint8_t* grid;
+        int16_t* player;
+        int16_t* enemies;
+        float* reward;
+        uint8_t* done;
+        const uint8_t* action;
+    };
+
+private:
+    static const uint8_t OPEN = 0, WALL = 1, TRAIL = 2;   // as the game's grid, for captureBoard()
+    static const size_t CHUNK = 64;   // worlds per job
+
+    size_t B;
+    int E;
+    ObsMode mode;
+    uint32_t maxSteps;
+    Buffers buf;
+    bool bound = false;
+
+    std::vector<uint8_t> ownGrid;   // board storage until bind() in OBS_BYTES, always in OBS_BITS
+    uint8_t* grid;                  // B * CELLS
+
+    // per-world columns
+    std::vector<int16_t> px, py;
+    std::vector<int8_t> pdx, pdy;
+    std::vector<uint8_t> drawing;
+    std::vector<int16_t> trailLen;
+    std::vector<uint16_t> freezeLeft;
+    std::vector<uint32_t> steps, rng;
+    std::vector<ScoreCounter> points;
+    // per-enemy columns, B * E
+    std::vector<int16_t> ex, ey;
+    std::vector<int8_t> edx, edy;
+
+    std::unique_ptr<WorkerPool> pool;
+    std::vector<std::vector<int16_t>> scratch;   // flood-fill stack per thread
+
+    uint32_t nextRand(size_t w) {
+        uint32_t& r = rng[w];
+        r ^= r << 13;
+        r ^= r >> 17;
+        r ^= r << 5;
+        return r;
+    }
+
+    void resetWorld(size_t w) {
+        uint8_t* g = grid + w * CELLS;
+        for (int i = 0; i < M; ++i)
+            for (int j = 0; j < N; ++j)
+                g[i * N + j] = (i == 0 || j == 0 || i == M - 1 || j == N - 1) ? WALL : OPEN;
+        px[w] = 10; py[w] = 0;
+        pdx[w] = pdy[w] = 0;
+        drawing[w] = 0;
+        trailLen[w] = 0;
+        freezeLeft[w] = 0;
+        steps[w] = 0;
+        points[w] = ScoreCounter();
+        for (int k = 0; k < E; ++k) {
+            size_t e = w * E + k;
+            ex[e] = ey[e] = 300;
+            edx[e] = (int8_t)(4 - (int)(nextRand(w) % 8));
+            edy[e] = (int8_t)(4 - (int)(nextRand(w) % 8));
+            if (edx[e] == 0 && edy[e] == 0) edx[e] = 1;
+        }
+        if (mode == OBS_BITS) packPlanes(w);
+    }
+
+    void packPlanes(size_t w) {
+        if (!bound) return;
+        const uint8_t* g = grid + w * CELLS;
+        uint8_t* wall = buf.grid + w * 2 * PLANE_BYTES;
+        uint8_t* trail = wall + PLANE_BYTES;
+        std::memset(wall, 0, 2 * PLANE_BYTES);
+        for (int c = 0; c < CELLS; ++c) {
+            wall[c >> 3] |= (uint8_t)((g[c] == WALL) << (c & 7));
+            trail[c >> 3] |= (uint8_t)((g[c] == TRAIL) << (c & 7));
+        }
+    }
+
+    // Fills every open region no enemy can reach, turns the trail into wall
+    // and returns how many cells became wall; the game's own capture.
+    int capture(size_t w, std::vector<int16_t>& stack) {
+        struct At { int x, y; } at[MAX_ENEMIES];
+        for (int k = 0; k < E; ++k) { at[k].x = ex[w * E + k]; at[k].y = ey[w * E + k]; }
+        return captureBoard(grid + w * CELLS, StockDims(), at, E, stack.data());
+    }
+
+    static int clampTo(int v, int lo, int hi) { return v < lo ? lo : (v > hi ? hi : v); }
+
+    void stepWorld(size_t w, std::vector<int16_t>& stack) {
+        uint8_t* g = grid + w * CELLS;
+        uint8_t a = buf.action[w];
+        int before = points[w].score;
+        bool dead = false;
+
+        if (a == FREEZE) {
+            if (!freezeLeft[w] && points[w].use()) freezeLeft[w] = FREEZE_STEPS;
+        }
+        else if (a >= LEFT && a <= DOWN) {
+            static const int8_t dirs[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+            pdx[w] = dirs[a - LEFT][0];
+            pdy[w] = dirs[a - LEFT][1];
+        }
+        bool onWall = g[py[w] * N + px[w]] == WALL;
+        if (!onWall || (a >= LEFT && a <= DOWN)) {
+            px[w] = (int16_t)clampTo(px[w] + pdx[w], 0, N - 1);
+            py[w] = (int16_t)clampTo(py[w] + pdy[w], 0, M - 1);
+        }
+        int cell = py[w] * N + px[w];
+        if (g[cell] == OPEN) {
+            g[cell] = TRAIL;
+            drawing[w] = 1;
+            ++trailLen[w];
+            if (mode == OBS_BITS) buf.grid[w * 2 * PLANE_BYTES + PLANE_BYTES + (cell >> 3)] |= (uint8_t)(1 << (cell & 7));
+        }
+        else if (g[cell] == TRAIL && drawing[w]) dead = true;
+        else if (g[cell] == WALL && drawing[w]) {
+            points[w].add(capture(w, stack));
+            drawing[w] = 0;
+            trailLen[w] = 0;
+            pdx[w] = pdy[w] = 0;
+            if (mode == OBS_BITS) packPlanes(w);
+        }
+
+        if (freezeLeft[w]) --freezeLeft[w];
+        else {
+            for (int t = 0; t < RoomWorld::STEP_TICKS && !dead; ++t)
+                for (int k = 0; k < E; ++k) {
+                    size_t e = w * E + k;
+                    int x = ex[e] + edx[e], y = ey[e];
+                    int gx = x / ts, gy = y / ts;
+                    if (gx <= 0 || gx >= N - 1 || g[gy * N + gx] == WALL) { edx[e] = (int8_t)-edx[e]; x += edx[e]; }
+                    y += edy[e];
+                    gx = x / ts; gy = y / ts;
+                    if (gy <= 0 || gy >= M - 1 || g[gy * N + gx] == WALL) { edy[e] = (int8_t)-edy[e]; y += edy[e]; }
+                    ex[e] = (int16_t)clampTo(x, 0, N * ts);
+                    ey[e] = (int16_t)clampTo(y, 0, M * ts);
+                    gx = ex[e] / ts; gy = ey[e] / ts;
+                    if (gy > 0 && gy < M && gx > 0 && gx < N && g[gy * N + gx] == TRAIL) dead = true;
+                }
+        }
+
+        ++steps[w];
+        buf.reward[w] = (float)(points[w].score - before);
+        buf.done[w] = dead ? TERMINATED : (maxSteps && steps[w] >= maxSteps ? TRUNCATED : RUNNING);
+        if (buf.done[w]) resetWorld(w);
+        writeObs(w);
+    }
+
+    void writeObs(size_t w) {
+        int16_t* p = buf.player + w * PLAYER_FIELDS;
+        p[PX] = px[w]; p[PY] = py[w];
+        p[PDX] = pdx[w]; p[PDY] = pdy[w];
+        p[POWER_UPS] = (int16_t)points[w].powerUps;
+        p[FREEZE_LEFT] = (int16_t)freezeLeft[w];
+        int16_t* e = buf.enemies + w * 2 * E;
+        for (int k = 0; k < E; ++k) {
+            e[2 * k] = ex[w * E + k];
+            e[2 * k + 1] = ey[w * E + k];
+        }
+    }
+
+    template<typename F>
+    void forChunks(F fn) {
+        size_t chunks = (B + CHUNK - 1) / CHUNK;
+        unsigned workers = pool ? pool->size() : 0;
+        if (!workers || chunks < 2) { fn(0, B, scratch[0]); return; }
+        // thread t takes chunks t, t + T, ...; the caller is thread 0
+        unsigned T = workers + 1;
+        if (T > chunks) T = (unsigned)chunks;
+        auto run = [this, chunks, T, &fn](unsigned t) {
+            for (size_t c = t; c < chunks; c += T) {
+                size_t lo = c * CHUNK, hi = lo + CHUNK < B ? lo + CHUNK : B;
+                fn(lo, hi, scratch[t]);
+            }
+        };
+        std::vector<std::future<void>> done;
+        for (unsigned t = 1; t < T; ++t) done.push_back(pool->submit([&run, t] { run(t); }));
+        run(0);
+        for (auto& f : done) f.get();
+    }
+
+public:
+    // threads counts the caller; threads - 1 pool workers are started.
+    // maxSteps truncates an episode (0 for never).
+    VecEnv(size_t count, int enemies, ObsMode obsMode, uint32_t seed, unsigned threads, uint32_t maxSteps)
+        : B(count ? count : 1), E(enemies < 1 ? 1 : (enemies > MAX_ENEMIES ? MAX_ENEMIES : enemies)),
+        mode(obsMode), maxSteps(maxSteps), ownGrid(B * CELLS), grid(ownGrid.data()),
+        px(B), py(B), pdx(B), pdy(B), drawing(B), trailLen(B), freezeLeft(B), steps(B), rng(B), points(B),
+        ex(B * E), ey(B * E), edx(B * E), edy(B * E) {
+        std::memset(&buf, 0, sizeof(buf));
+        if (threads > 1) pool.reset(new WorkerPool(threads - 1));
+        scratch.assign(threads > 1 ? threads : 1, std::vector<int16_t>(CELLS + 1));
+        for (size_t w = 0; w < B; ++w) {
+            uint32_t s = seed + (uint32_t)w * 2654435761u;
+            rng[w] = s ? s : 0x9e3779b9u;
+            resetWorld(w);
+        }
+    }
+
+    size_t size() const { return B; }
+    int enemyCount() const { return E; }
+    ObsMode obsMode() const { return mode; }
+    size_t gridBytes() const { return mode == OBS_BYTES ? CELLS : 2 * PLANE_BYTES; }
+
+    // Points every observation at caller memory. In OBS_BYTES mode the board
+    // moves into buffers.grid, which must then be treated as read-only.
+    // The buffers must outlive the env or the next bind().
+    void bind(const Buffers& b) {
+        if (mode == OBS_BYTES) {
+            std::memmove(b.grid, grid, B * CELLS);
+            grid = b.grid;
+        }
+        buf = b;
+        bound = true;
+        for (size_t w = 0; w < B; ++w) {
+            if (mode == OBS_BITS) packPlanes(w);
+            writeObs(w);
+        }
+    }
+
+    // Starts a fresh episode in every world; rewards and done flags are cleared.
+    void reset() {
+        for (size_t w = 0; w < B; ++w) {
+            resetWorld(w);
+            if (!bound) continue;
+            buf.reward[w] = 0;
+            buf.done[w] = RUNNING;
+            writeObs(w);
+        }
+    }
+
+    // Applies buffers.action to every world and writes observations, rewards
+    // and done flags. Requires bind().
+    void step() {
+        if (!bound) return;
+        forChunks([this](size_t lo, size_t hi, std::vector<int16_t>& stack) {
+            for (size_t w = lo; w < hi; ++w) stepWorld(w, stack);
+        });
+    }
+};
@@ -7,278 +7,316 @@
 #include <iostream>
 #include <cstring>
 #include <cstdio> 
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cstdarg>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#ifdef _WIN32
+#include <direct.h>
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+#include "AllocTracker.h"
+#include "AvlMap.h"
+#include "BigMapWorld.h"
+#include "Board.h"
+#include "FlowField.h"
+#include "GridKernels.h"
+#include "InputQueue.h"
+#include "LevelCompiler.h"
+#include "LevelPack.h"
+#include "Matchmaker.h"
+#include "MpmcQueue.h"
+#include "NetGame.h"
+#include "Profiler.h"
+#include "Rollback.h"
+#include "RoomServer.h"
+#include "TimerWheel.h"
+#include "TripleBuffer.h"
+#include "WorkerPool.h"
+#include "vendor/scrypt/scrypt.h"
 using namespace std;
 using namespace sf;
 
 
+/////////////////////// ALLOCATION HOOK ////////////////////////
+
+// Debug builds count every heap allocation (see AllocTracker.h); the game
+// loop and --render-bench --alloc-check read the counts per frame.
+#if XONIX_ALLOC_TRACK
+void* operator new(size_t size) {
+    AllocTracker::noteAlloc(size);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+#endif
+
+
+/////////////////////// CACHED TEXT ////////////////////////
+
+// A Text set printf-style that only hands SFML a new string when the
+// formatted value changed, and then through a reused sf::String filled a
+// character at a time. Redrawing the same HUD value every frame costs no heap
+// allocation, and a changed one none once the buffers have grown.
+class CachedText : public Text {
+    char shown[256] = "";
+    String scratch;
+
+public:
+    using Text::Text;
+
+    void format(const char* fmt, ...) {
+        char buf[sizeof(shown)];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(buf, sizeof(buf), fmt, args);
+        va_end(args);
+        if (!strcmp(buf, shown)) return;
+        memcpy(shown, buf, sizeof(buf));
+        scratch.clear();
+        for (const char* c = buf; *c; ++c) scratch += String((Uint32)(unsigned char)*c);
+        setString(scratch);
+    }
+};
+
+
 ////////////////////////////////  THEME /////////////////////////////////////
 
+// Per-role tint colours used to bake the theme's tile/enemy sprites.
+// A fully transparent tint keeps the stock artwork for that role.
+struct ThemePalette {
+    Color wall, player, trail, enemy;
+
+    ThemePalette(Color _wall = Color::Transparent,
+        Color _player = Color::Transparent,
+        Color _trail = Color::Transparent,
+        Color _enemy = Color::Transparent)
+        : wall(_wall), player(_player), trail(_trail), enemy(_enemy)
+    {
+    }
+};
+
 struct Theme {
     int id;                   // unique theme ID
     std::string name;         // display name
     std::string description;  // brief description
+    ThemePalette palette;     // sprite recolouring
 
     Theme(int _id = 0,
         const std::string& _name = "",
-        const std::string& _desc = "")
+        const std::string& _desc = "",
+        const ThemePalette& _palette = ThemePalette())
         : id(_id),
         name(_name),
-        description(_desc)
+        description(_desc),
+        palette(_palette)
     {
     }
 };
 
-struct AVLNode {
-    Theme data;        // stored theme
-    AVLNode* left;     // left subtree
-    AVLNode* right;    // right subtree
-    int height;        // node height for balancing
-
-    AVLNode(const Theme& t)
-        : data(t),
-        left(nullptr),
-        right(nullptr),
-        height(1)
-    {
-    }
-};
-
-// — AVL Rotation Helpers —
-
-// Returns height of node (0 if null)
-int nodeHeight(AVLNode* n) {
-    return n ? n->height : 0;
-}
-
-// Updates height of a node based on children
-void updateHeight(AVLNode* n) {
-    int lh = nodeHeight(n->left);
-    int rh = nodeHeight(n->right);
-    n->height = 1 + (lh > rh ? lh : rh);
-}
-
-// Balance factor = left height minus right height
-int getBalance(AVLNode* n) {
-    return n ? nodeHeight(n->left) - nodeHeight(n->right) : 0;
-}
-
-// Right rotation
-AVLNode* rotateRight(AVLNode* y) {
-    AVLNode* x = y->left;
-    AVLNode* T2 = x->right;
-    // Perform rotation
-    x->right = y;
-    y->left = T2;
-    // Update heights
-    updateHeight(y);
-    updateHeight(x);
-    return x;
-}
-
-// Left rotation
-AVLNode* rotateLeft(AVLNode* x) {
-    AVLNode* y = x->right;
-    AVLNode* T2 = y->left;
-    // Perform rotation
-    y->left = x;
-    x->right = T2;
-    // Update heights
-    updateHeight(x);
-    updateHeight(y);
-    return y;
-}
-
-// Left-Right rotation
-AVLNode* rotateLeftRight(AVLNode* n) {
-    n->left = rotateLeft(n->left);
-    return rotateRight(n);
-}
-
-// Right-Left rotation
-AVLNode* rotateRightLeft(AVLNode* n) {
-    n->right = rotateRight(n->right);
-    return rotateLeft(n);
-}
-
-// — AVL Insertion —
-// Inserts Theme t into AVL tree rooted at node, returns new root.
-
-AVLNode* insert(AVLNode* node, const Theme& t) {
-    // 1. Normal BST insert
-    if (!node)
-        return new AVLNode(t);
-    if (t.id < node->data.id)
-        node->left = insert(node->left, t);
-    else if (t.id > node->data.id)
-        node->right = insert(node->right, t);
-    else
-        return node; // duplicate IDs not allowed
-
-    // 2. Update height
-    updateHeight(node);
-
-    // 3. Get balance factor
-    int balance = getBalance(node);
-
-    // 4. Rebalance if needed
-    // Left Left Case
-    if (balance > 1 && t.id < node->left->data.id)
-        return rotateRight(node);
+// Theme catalog ordered by theme ID. Nodes are pooled inside the map (see AvlMap.h).
+typedef AvlMap<int, Theme> ThemeTree;
+
+// — Theme Catalog —
+// Owns the ID-keyed tree plus two secondary indexes over the lower-cased
+// theme name: a hash map for exact lookups and a trie for prefix search.
+// Names are unique (ignoring case). All mutations go through the catalog so
+// the three structures never disagree; name lookups cost O(name length)
+// instead of a walk over every theme.
+
+class ThemeCatalog {
+    struct TrieNode {
+        vector<pair<char, int32_t>> children;   // sorted by char
+        int32_t passCount = 0;   // names ending in this subtree
+        int themeID = 0;         // nonzero if a name ends exactly here
+    };
 
-    // Right Right Case
-    if (balance < -1 && t.id > node->right->data.id)
-        return rotateLeft(node);
+    ThemeTree byID;
+    unordered_map<string, int> byName;   // normalized name -> theme ID
+    vector<TrieNode> trie;               // trie[0] is the root
+    vector<int32_t> freeTrie;            // recycled trie slots
 
-    // Left Right Case
-    if (balance > 1 && t.id > node->left->data.id) {
-        node->left = rotateLeft(node->left);
-        return rotateRight(node);
+    static string normalize(const string& name) {
+        string key(name);
+        for (auto& c : key) c = (char)tolower((unsigned char)c);
+        return key;
     }
 
-    // Right Left Case
-    if (balance < -1 && t.id < node->right->data.id) {
-        node->right = rotateRight(node->right);
-        return rotateLeft(node);
+    int32_t childOf(int32_t n, char c) const {
+        for (const auto& ch : trie[n].children) {
+            if (ch.first == c) return ch.second;
+            if (ch.first > c) break;
+        }
+        return -1;
     }
 
-    // Balanced
-    return node;
-}
-
-// — AVL Deletion: Remove a Theme by ID and rebalance —
+    int32_t addChild(int32_t n, char c) {
+        int32_t idx;
+        if (!freeTrie.empty()) { idx = freeTrie.back(); freeTrie.pop_back(); trie[idx] = TrieNode(); }
+        else { idx = (int32_t)trie.size(); trie.emplace_back(); }
+        auto& kids = trie[n].children;
+        auto pos = kids.begin();
+        while (pos != kids.end() && pos->first < c) ++pos;
+        kids.insert(pos, make_pair(c, idx));
+        return idx;
+    }
 
-// Helper to find the node with minimum ID in a subtree
-AVLNode* minValueNode(AVLNode* node) {
-    AVLNode* current = node;
-    while (current->left)
-        current = current->left;
-    return current;
-}
+    void trieAdd(const string& key, int id) {
+        int32_t n = 0;
+        ++trie[0].passCount;
+        for (char c : key) {
+            int32_t next = childOf(n, c);
+            if (next < 0) next = addChild(n, c);
+            n = next;
+            ++trie[n].passCount;
+        }
+        trie[n].themeID = id;
+    }
 
-AVLNode* removeNode(AVLNode* root, int id) {
-    if (!root)
-        return nullptr;
-
-    // 1. Standard BST deletion
-    if (id < root->data.id) {
-        root->left = removeNode(root->left, id);
-    }
-    else if (id > root->data.id) {
-        root->right = removeNode(root->right, id);
-    }
-    else {
-        // node to be deleted found
-        if (!root->left || !root->right) {
-            AVLNode* temp = root->left ? root->left : root->right;
-            if (!temp) {
-                // no child
-                temp = root;
-                root = nullptr;
-            }
-            else {
-                // one child
-                *root = *temp;  // copy contents
+    // key must be present. Nodes no other name passes through are unlinked and recycled.
+    void trieRemove(const string& key) {
+        int32_t n = 0;
+        --trie[0].passCount;
+        for (char c : key) {
+            int32_t next = childOf(n, c);
+            if (--trie[next].passCount == 0) {
+                auto& kids = trie[n].children;
+                for (auto it = kids.begin(); it != kids.end(); ++it)
+                    if (it->first == c) { kids.erase(it); break; }
+                // the rest of the path belongs to this name only
+                while (next >= 0) {
+                    int32_t after = trie[next].children.empty() ? -1 : trie[next].children[0].second;
+                    trie[next] = TrieNode();
+                    freeTrie.push_back(next);
+                    next = after;
+                }
+                return;
             }
-            delete temp;
-        }
-        else {
-            // two children: get inorder successor (smallest in right subtree)
-            AVLNode* temp = minValueNode(root->right);
-            // copy successor’s data
-            root->data = temp->data;
-            // delete the successor
-            root->right = removeNode(root->right, temp->data.id);
+            n = next;
         }
+        trie[n].themeID = 0;
     }
 
-    // if tree had only one node
-    if (!root)
-        return nullptr;
-
-    // 2. Update height
-    updateHeight(root);
-
-    // 3. Get balance factor
-    int balance = getBalance(root);
-
-    // 4. Rebalance if needed
-    // Left Left
-    if (balance > 1 && getBalance(root->left) >= 0)
-        return rotateRight(root);
-
-    // Left Right
-    if (balance > 1 && getBalance(root->left) < 0) {
-        root->left = rotateLeft(root->left);
-        return rotateRight(root);
+    void indexName(const Theme& t) {
+        string key = normalize(t.name);
+        byName[key] = t.id;
+        trieAdd(key, t.id);
     }
 
-    // Right Right
-    if (balance < -1 && getBalance(root->right) <= 0)
-        return rotateLeft(root);
-
-    // Right Left
-    if (balance < -1 && getBalance(root->right) > 0) {
-        root->right = rotateRight(root->right);
-        return rotateLeft(root);
+    // Only if t owns its name: a duplicate loaded by assignSorted() was never indexed.
+    void unindexName(const Theme& t) {
+        string key = normalize(t.name);
+        auto it = byName.find(key);
+        if (it == byName.end() || it->second != t.id) return;
+        byName.erase(it);
+        trieRemove(key);
     }
 
-    return root;
-}
-
-
+public:
+    ThemeCatalog() : trie(1) {}
 
-// — In‑Order Traversal: Print Theme IDs and Names —
-void inorderPrint(AVLNode* root) {
-    if (!root) return;
-    inorderPrint(root->left);
-    // Print ID and name
-    std::cout << "Theme " << root->data.id
-        << ": " << root->data.name << std::endl;
-    inorderPrint(root->right);
-}
+    // Fails on a duplicate ID or name.
+    bool insert(const Theme& t) {
+        if (byName.count(normalize(t.name))) return false;
+        if (!byID.insert(t.id, t).second) return false;
+        indexName(t);
+        return true;
+    }
 
+    // Replaces the catalog with themes sorted by ID; the tree is built in O(n).
+    template<typename It>
+    void assignSorted(It first, It last) {
+        vector<ThemeTree::value_type> sorted;
+        for (It it = first; it != last; ++it) sorted.emplace_back(it->id, *it);
+        byID.assignSorted(sorted.begin(), sorted.end());
+        byName.clear();
+        trie.assign(1, TrieNode());
+        freeTrie.clear();
+        for (const auto& kv : byID) {
+            if (byName.count(normalize(kv.second.name))) continue;   // first ID keeps the name
+            indexName(kv.second);
+        }
+    }
 
-// — Search by Theme ID: BST-style lookup —
-AVLNode* findByID(AVLNode* root, int id) {
-    if (!root) return nullptr;
-    if (id == root->data.id)
-        return root;
-    else if (id < root->data.id)
-        return findByID(root->left, id);
-    else
-        return findByID(root->right, id);
-}
+    // Renames/redescribes a theme; fails if the ID is unknown or the new name is taken.
+    bool update(int id, const string& newName, const string& newDesc) {
+        Theme* t = byID.get(id);
+        if (!t) return false;
+        string newKey = normalize(newName);
+        auto clash = byName.find(newKey);
+        if (clash != byName.end() && clash->second != id) return false;
+        unindexName(*t);
+        t->name = newName;
+        t->description = newDesc;
+        indexName(*t);
+        return true;
+    }
 
+    bool remove(int id) {
+        const Theme* t = byID.get(id);
+        if (!t) return false;
+        unindexName(*t);
+        byID.erase(id);
+        return true;
+    }
 
-// — Search by Theme Name: full-tree traversal lookup —
-AVLNode* findByName(AVLNode* root, const std::string& name) {
-    if (!root) return nullptr;
-    if (root->data.name == name)
-        return root;
-    // Search left subtree
-    AVLNode* found = findByName(root->left, name);
-    if (found) return found;
-    // Otherwise search right subtree
-    return findByName(root->right, name);
-}
+    const Theme* findByID(int id) const { return byID.get(id); }
 
-// — Update Theme by ID —
-// Finds a theme by ID and updates its name/description.
-// Uses findByID internally.
+    // Case-insensitive exact match.
+    const Theme* findByName(const string& name) const {
+        auto it = byName.find(normalize(name));
+        return it == byName.end() ? nullptr : byID.get(it->second);
+    }
 
-void updateTheme(AVLNode* root, int id,
-    const std::string& newName,
-    const std::string& newDesc) {
-    AVLNode* node = findByID(root, id);
-    if (!node) {
-        std::cout << "No theme with ID " << id << " found.\n";
-        return;
+    // Appends up to limit themes whose name starts with prefix (case-insensitive),
+    // in alphabetical order. Returns how many themes match in total.
+    size_t prefixSearch(const string& prefix, size_t limit, vector<const Theme*>& out) const {
+        int32_t n = 0;
+        for (char c : normalize(prefix)) {
+            n = childOf(n, c);
+            if (n < 0) return 0;
+        }
+        // depth-first in child order = alphabetical
+        vector<int32_t> stack(1, n);
+        size_t added = 0;
+        while (!stack.empty() && added < limit) {
+            int32_t cur = stack.back(); stack.pop_back();
+            if (trie[cur].themeID) {
+                out.push_back(byID.get(trie[cur].themeID));
+                ++added;
+            }
+            const auto& kids = trie[cur].children;
+            for (auto it = kids.rbegin(); it != kids.rend(); ++it) stack.push_back(it->second);
+        }
+        return (size_t)trie[n].passCount;
     }
-    node->data.name = newName;
-    node->data.description = newDesc;
-    std::cout << "Theme " << id << " updated to \""
-        << newName << "\" - " << newDesc << "\n";
-}
+
+    const ThemeTree& themes() const { return byID; }
+    size_t size() const { return byID.size(); }
+};
 
 
 enum PauseAction { PAUSE_RESUME = 0, PAUSE_SAVE, PAUSE_LOAD, PAUSE_EXIT }; // for pause menu //
@@ -288,50 +326,54 @@ enum PauseAction { PAUSE_RESUME = 0, PAUSE_SAVE, PAUSE_LOAD, PAUSE_EXIT }; // fo
 
 
 
-const int M = 25, N = 40, ts = 18;
-int grid[M][N];
 struct Enemy
 {
     int x, y, dx, dy; Enemy() { x = y = 300; dx = 4 - rand() % 8; dy = 4 - rand() % 8; }
-    void move()
+    template<typename Dims>
+    void move(const int* g, Dims d)
     {
-        x += dx;
-        if (grid[y / ts][x / ts] == 1)
-        {
-            dx = -dx; x += dx;
-        }
-        y += dy;
-        if (grid[y / ts][x / ts] == 1)
-        {
-            dy = -dy; y += dy;
-        }
+        bounceEnemy(g, d, *this);
+    }
+    // Hunter step: follows the shared flow field toward the player's trail,
+    // lining up on a cell's centre line before moving along it so turns stay
+    // inside open cells. With nothing to chase it bounces like the others.
+    // The stock speed of 2 px per frame is about half the player's pace.
+    template<typename Dims>
+    void chase(const int* g, const FlowField<Dims>& f, int speed = 2)
+    {
+        int r = y / ts, c = x / ts;
+        int d = f.direction(r, c);
+        if (d < 0) { move(g, Dims()); return; }
+        int cx = c * ts + ts / 2, cy = r * ts + ts / 2;
+        int ax = d == 0 ? -1 : (d == 1 ? 1 : 0), ay = d == 2 ? -1 : (d == 3 ? 1 : 0);
+        if (ax && y != cy) { dx = 0; dy = max(-speed, min(speed, cy - y)); }
+        else if (ay && x != cx) { dy = 0; dx = max(-speed, min(speed, cx - x)); }
+        else { dx = ax * speed; dy = ay * speed; }
+        x += dx; y += dy;
     }
 };
-void drop(int r, int c)
-{
-    if (grid[r][c] == 0) grid[r][c] = -1;
-    if (grid[r - 1][c] == 0)
-        drop(r - 1, c);
-    if (grid[r + 1][c] == 0)
-        drop(r + 1, c);
-    if (grid[r][c - 1] == 0)
-        drop(r, c - 1);
-    if (grid[r][c + 1] == 0)
-        drop(r, c + 1);
-}
 
 
 
-const int ENEMY_COUNT = 4;
+// save.dat is this struct written raw. version goes first so a save from an
+// older build is refused rather than read with the wrong layout; level names
+// the pack level it was made on, since the grid alone does not say where the
+// level's bounds, spawns and drops are.
+const uint32_t SAVE_VERSION = 2;
 
 struct GameState {
+    uint32_t version;
+    char level[LEVEL_NAME_BYTES];
+    uint32_t tickNo;
+    int nextDrop;
+    int enemyCount;
     int grid[M][N];
     int px, py, dx, dy;
     bool inGame, drawing, moveQ, frozen;
     float freezeElapsed;
     float timer, delay;
     int score, bonus, powerUps, par;
-    Enemy enemies[ENEMY_COUNT];
+    Enemy enemies[LEVEL_MAX_ENEMIES];
 };
 
 bool saveGame(const GameState& s, const char* fname) {
@@ -345,78 +387,151 @@ bool loadGame(GameState& s, const char* fname) {
     std::ifstream in(fname, std::ios::binary);
     if (!in) return false;
     in.read(reinterpret_cast<char*>(&s), sizeof(s));
-    return in.good();
+    return in.good() && s.version == SAVE_VERSION;
 }
 
 // ────────────────────────────────────────────────────────────────────────────
 
-// — Save Player’s Theme to File —
-// Appends the selected theme ID for a user to “user_themes.txt”
-// Uses only <fstream>
+// — Whole-file rewrites —
+// A file rewritten in full is written to "<name>.tmp" and then moved over the
+// original in one step, so a crash leaves either the old file or the new one.
 
-void savePlayerTheme(const std::string& username, int themeID) {
-    std::ofstream out("user_themes.txt", std::ios::app);
-    if (!out) {
-        std::cerr << "Error: could not open user_themes.txt for writing\n";
-        return;
-    }
-    out << username << " " << themeID << "\n";
-    // file is closed automatically when out goes out of scope
+bool replaceFile(const string& tmp, const string& dest) {
+#ifdef _WIN32
+    return MoveFileExA(tmp.c_str(), dest.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(tmp.c_str(), dest.c_str()) == 0;   // atomic over an existing file
+#endif
 }
 
-// — Load Player’s Theme from File —
-// Reads “user_themes.txt” for the given username and returns the last saved theme ID.
-// Uses only <fstream> and <string>.
+// At startup: a leftover "<name>.tmp" is a rewrite that never finished. If the
+// file itself is gone (builds that removed it before renaming could crash in
+// between) the temp file is all that is left and takes its place; otherwise
+// the file is intact and the temp file is dropped.
+void recoverReplacedFile(const string& dest) {
+    string tmp = dest + ".tmp";
+    if (!ifstream(tmp)) return;
+    if (ifstream(dest)) std::remove(tmp.c_str());
+    else replaceFile(tmp, dest);
+}
 
-int loadPlayerTheme(const std::string& username) {
-    std::ifstream in("user_themes.txt");
-    if (!in) {
-        std::cerr << "Warning: could not open user_themes.txt for reading\n";
-        return 0;  // 0 = no theme saved
+// ────────────────────────────────────────────────────────────────────────────
+
+// — Player Preferences Store —
+// Per-user key/value settings (theme, last level, key bindings) kept in a hash
+// map and persisted to "user_themes.txt" as an append-only log of
+// "username key value" lines. Lines written by older builds ("username themeID")
+// are read as the theme key. The log is rewritten with only the live values
+// once it grows past twice the number of live entries.
+
+class PreferenceStore {
+    string filename;
+    unordered_map<string, unordered_map<string, string>> users;
+    size_t liveCount = 0;   // distinct (user, key) pairs
+    size_t logLines = 0;    // lines currently in the file
+
+    bool needsCompaction() const { return logLines > 2 * liveCount + 32; }
+
+    void compact() {
+        string tmp = filename + ".tmp";
+        {
+            ofstream out(tmp, ios::trunc);
+            if (!out) return;
+            for (auto& u : users)
+                for (auto& kv : u.second)
+                    out << u.first << " " << kv.first << " " << kv.second << "\n";
+            if (!out) return;
+        }
+        if (replaceFile(tmp, filename)) logLines = liveCount;
+    }
+
+    void apply(const string& user, const string& key, const string& value) {
+        auto& prefs = users[user];
+        if (prefs.find(key) == prefs.end()) ++liveCount;
+        prefs[key] = value;
+    }
+
+public:
+    // Replays the log once at startup; later reads never touch the file.
+    void load(const char* fname) {
+        filename = fname;
+        users.clear(); liveCount = logLines = 0;
+        recoverReplacedFile(filename);
+        ifstream in(fname);
+        string line;
+        while (getline(in, line)) {
+            istringstream ls(line);
+            string u, k, v;
+            if (!(ls >> u >> k)) continue;
+            ++logLines;
+            if (ls >> v) apply(u, k, v);
+            else apply(u, "theme", k);   // legacy "username themeID"
+        }
+        if (needsCompaction()) compact();
+    }
+
+    const string* get(const string& user, const string& key) const {
+        auto u = users.find(user);
+        if (u == users.end()) return nullptr;
+        auto kv = u->second.find(key);
+        return kv == u->second.end() ? nullptr : &kv->second;
     }
-    std::string u;
-    int id;
-    int lastID = 0;
-    // Read all entries; keep the last matching one
-    while (in >> u >> id) {
-        if (u == username) {
-            lastID = id;
+    int getInt(const string& user, const string& key, int fallback) const {
+        const string* v = get(user, key);
+        return v ? atoi(v->c_str()) : fallback;
+    }
+
+    // Appends one log line, unless the value is already current.
+    void set(const string& user, const string& key, const string& value) {
+        const string* cur = get(user, key);
+        if (cur && *cur == value) return;
+        apply(user, key, value);
+        {
+            ofstream out(filename, ios::app);
+            if (!out) {
+                cerr << "Error: could not open " << filename << " for writing\n";
+                return;
+            }
+            out << user << " " << key << " " << value << "\n";
         }
+        ++logLines;
+        if (needsCompaction()) compact();
     }
-    return lastID;
+    void setInt(const string& user, const string& key, int value) { set(user, key, to_string(value)); }
+};
+
+static PreferenceStore gPrefs;
+
+// — Save / Load Player’s Theme —
+// 0 = no theme saved
+
+void savePlayerTheme(const std::string& username, int themeID) {
+    gPrefs.setInt(username, "theme", themeID);
 }
 
+int loadPlayerTheme(const std::string& username) {
+    return gPrefs.getInt(username, "theme", 0);
+}
 
+// — Single-player key bindings —
+// Stored as sf::Keyboard::Key codes under "key.left", "key.right", ... ; arrows + T by default.
 
-struct Player {
-    std::string username;
-    int score;
-    Player* next;
-    Player(const std::string& u, int s) : username(u), score(s), next(nullptr) {}
+struct KeyBindings {
+    Keyboard::Key left = Keyboard::Left, right = Keyboard::Right;
+    Keyboard::Key up = Keyboard::Up, down = Keyboard::Down;
+    Keyboard::Key freeze = Keyboard::T;
 };
 
-class MatchQueue {
-    Player* head;
-    Player* tail;
-public:
-    MatchQueue() : head(nullptr), tail(nullptr) {}
-    void enqueue(Player* p) {
-        p->next = nullptr;
-        if (!tail) head = tail = p;
-        else { tail->next = p; tail = p; }
-    }
-    Player* dequeue() {
-        if (!head) return nullptr;
-        Player* p = head;
-        head = head->next;
-        if (!head) tail = nullptr;
-        p->next = nullptr;
-        return p;
-    }
-    bool isEmpty() const { return head == nullptr; }
-};
+KeyBindings loadKeyBindings(const std::string& username) {
+    KeyBindings k;
+    k.left = Keyboard::Key(gPrefs.getInt(username, "key.left", k.left));
+    k.right = Keyboard::Key(gPrefs.getInt(username, "key.right", k.right));
+    k.up = Keyboard::Key(gPrefs.getInt(username, "key.up", k.up));
+    k.down = Keyboard::Key(gPrefs.getInt(username, "key.down", k.down));
+    k.freeze = Keyboard::Key(gPrefs.getInt(username, "key.freeze", k.freeze));
+    return k;
+}
 
-static MatchQueue g_matchQueue;
 
 
 /////////////////////// LEADERBOARD ///////////////////////
@@ -431,6 +546,7 @@ struct LBEntry {
 class Leaderboard {
     LBEntry heap[LB_CAPACITY];
     int size;
+    CachedText title, lines[LB_CAPACITY], footer;   // kept across draw() calls
 
     void swapEntry(int i, int j) { LBEntry tmp = heap[i]; heap[i] = heap[j]; heap[j] = tmp; }
     void heapifyUp(int idx) {
@@ -501,21 +617,22 @@ public:
                 if (tmp[j].score > tmp[mx].score) mx = j;
             swap(tmp[i], tmp[mx]);
         }
-        Text title("--  LEADERBOARD  --", font, 30);
+        title.setFont(font); title.setCharacterSize(30);
+        title.format("--  LEADERBOARD  --");   // format(): no String rebuilt once it is set
         title.setFillColor(Color::Yellow);
         title.setPosition(200, 20);
         win.draw(title);
         for (int i = 0; i < ts; ++i) {
-            char buf[64];
-            sprintf_s(buf, "%2d. %-15s %5d", i + 1, tmp[i].name, tmp[i].score);
-            Text line(buf, font, 24);
-            line.setPosition(200, 70 + i * 30);
-            win.draw(line);
+            lines[i].setFont(font); lines[i].setCharacterSize(24);
+            lines[i].format("%2d. %-15s %5d", i + 1, tmp[i].name, tmp[i].score);
+            lines[i].setPosition(200, 70 + i * 30);
+            win.draw(lines[i]);
         }
-        Text f("Press Esc to return", font, 20);
-        f.setFillColor(Color::Cyan);
-        f.setPosition(220, 70 + ts * 30 + 20);
-        win.draw(f);
+        footer.setFont(font); footer.setCharacterSize(20);
+        footer.format("Press Esc to return");
+        footer.setFillColor(Color::Cyan);
+        footer.setPosition(220, 70 + ts * 30 + 20);
+        win.draw(footer);
     }
 };
 
@@ -523,107 +640,279 @@ static Leaderboard gLeader;
 
 
 /////////////////// FOR GAMEROOM ///////////////////////
-struct MatchPlayer {
-    std::string name;
+// Waiting players live in gMatchmaker (see Matchmaker.h). The leaderboard file
+// is read once at startup to seed it; after that nothing is re-parsed.
+
+static MatchmakingEngine gMatchmaker;
+static Clock gMatchClock;   // time base for queue wait times
+
+double matchNow() { return gMatchClock.getElapsedTime().asSeconds(); }
+
+// Join requests from front-ends wait in g_matchQueue until the next matching
+// pass drains them into gMatchmaker. The queue is lock-free and preallocated
+// (see MpmcQueue.h), so any thread can post a request without allocating.
+struct MatchRequest {
+    char name[MAX_NAME_LEN];
     int score;
 };
 
-// maximum number of players we’ll ever load (same as LB_CAPACITY)
-const int MAX_CANDS = LB_CAPACITY;
+static MpmcQueue<MatchRequest> g_matchQueue(1024);
 
-MatchPlayer gCands[MAX_CANDS];
-int   gCandCount = 0;
+// Pairs a matching pass formed that have not been played yet, oldest first.
+// They stay paired: a pass is O(n), and sending them back to the queue would
+// reset the wait that widened their windows.
+static vector<MatchResult> gFormedMatches;
+
+// False if the request queue is full.
+bool requestMatch(const std::string& user, int score) {
+    MatchRequest req;
+    strncpy_s(req.name, user.c_str(), MAX_NAME_LEN - 1);
+    req.name[MAX_NAME_LEN - 1] = '\0';
+    req.score = score;
+    return g_matchQueue.tryEnqueue(req);
+}
+
+// Moves pending requests into the skill queue; a repeat request updates the
+// player's score. A player already paired leaves the pair, and the partner goes
+// back to the queue with the wait they had built up.
+void drainMatchRequests() {
+    MatchRequest req;
+    while (g_matchQueue.tryDequeue(req)) {
+        for (size_t i = 0; i < gFormedMatches.size(); ++i) {
+            const MatchResult& m = gFormedMatches[i];
+            if (m.a.name != req.name && m.b.name != req.name) continue;
+            const bool isA = m.a.name == req.name;
+            const MatchPlayer& partner = isA ? m.b : m.a;
+            gMatchmaker.enqueue(partner.name, partner.score, matchNow() - (isA ? m.waitB : m.waitA));
+            gFormedMatches.erase(gFormedMatches.begin() + i);
+            break;
+        }
+        gMatchmaker.cancel(req.name);
+        gMatchmaker.enqueue(req.name, req.score, matchNow());
+    }
+}
 
-void loadMatchCandidates(const char* filename) {
+void seedMatchmaker(const char* filename) {
     std::ifstream in(filename);
-    gCandCount = 0;
     std::string uname;
     int sc;
-    while (gCandCount < MAX_CANDS && (in >> uname >> sc)) {
-        gCands[gCandCount++] = { uname, sc };
-    }
-    // selection‐sort descending by score
-    for (int i = 0; i < gCandCount; ++i) {
-        for (int j = i + 1; j < gCandCount; ++j) {
-            if (gCands[j].score > gCands[i].score) {
-                MatchPlayer tmp = gCands[i];
-                gCands[i] = gCands[j];
-                gCands[j] = tmp;
-            }
+    while (in >> uname >> sc) gMatchmaker.enqueue(uname, sc, matchNow());
+}
 
-        }
+// Runs one matching pass and takes a pair to play: the one containing
+// preferName, otherwise the oldest formed. The rest stay in gFormedMatches
+// for later calls.
+bool runMatchmaking(const std::string& preferName, MatchResult& chosen) {
+    drainMatchRequests();
+    gMatchmaker.tick(matchNow(), gFormedMatches);
+    if (gFormedMatches.empty()) return false;
+    size_t pick = 0;
+    for (size_t i = 0; i < gFormedMatches.size(); ++i)
+        if (gFormedMatches[i].a.name == preferName || gFormedMatches[i].b.name == preferName) { pick = i; break; }
+    chosen = gFormedMatches[pick];
+    gFormedMatches.erase(gFormedMatches.begin() + pick);
+    return true;
+}
+
+
+/////////////////////// LOGIN/SIGNUP //////////////////////////
+
+// users.txt holds one "username record" pair per line. A record is either
+//   $scrypt$<log2N>$<r>$<p>$<saltHex>$<hashHex>
+// or, for accounts created by older builds, the plaintext password. Plaintext
+// records (and hashes made with an outdated cost) are rewritten on the next
+// successful login.
+
+struct AuthConfig {
+    int log2N = 14;     // scrypt CPU/memory cost, N = 2^log2N
+    int r = 8;          // scrypt block size
+    int p = 1;          // scrypt parallelism
+    int workers = 2;    // hashing threads
+};
+
+// Reads "key value" lines from the deployment's auth.cfg; missing file or keys keep defaults.
+AuthConfig loadAuthConfig(const char* fname) {
+    AuthConfig cfg;
+    ifstream in(fname);
+    string key; int val;
+    while (in >> key >> val) {
+        if (key == "scrypt_log2n" && val >= 1 && val <= 24) cfg.log2N = val;
+        else if (key == "scrypt_r" && val >= 1 && val <= 64) cfg.r = val;
+        else if (key == "scrypt_p" && val >= 1 && val <= 16) cfg.p = val;
+        else if (key == "auth_workers" && val >= 1 && val <= 16) cfg.workers = val;
     }
+    return cfg;
 }
 
+const char* const SCRYPT_PREFIX = "$scrypt$";
+const int SALT_BYTES = 16, HASH_BYTES = 32;
+
+string toHex(const uint8_t* data, size_t len) {
+    static const char digits[] = "0123456789abcdef";
+    string out(len * 2, '0');
+    for (size_t i = 0; i < len; ++i) {
+        out[2 * i] = digits[data[i] >> 4];
+        out[2 * i + 1] = digits[data[i] & 15];
+    }
+    return out;
+}
 
-std::pair<MatchPlayer, MatchPlayer> findBestMatch() {
-    if (gCandCount < 2) return {};
-    int bestDiff = 1000000000;
-    int bestIdx = 0;
-    for (int i = 0; i + 1 < gCandCount; ++i) {
-        int diff = gCands[i].score - gCands[i + 1].score;
-        if (diff < 0) diff = -diff;
-        if (diff < bestDiff) {
-            bestDiff = diff;
-            bestIdx = i;
+bool fromHex(const string& hex, vector<uint8_t>& out) {
+    if (hex.size() % 2) return false;
+    out.resize(hex.size() / 2);
+    for (size_t i = 0; i < out.size(); ++i) {
+        int v = 0;
+        for (int k = 0; k < 2; ++k) {
+            char c = hex[2 * i + k];
+            v <<= 4;
+            if (c >= '0' && c <= '9') v |= c - '0';
+            else if (c >= 'a' && c <= 'f') v |= c - 'a' + 10;
+            else return false;
         }
+        out[i] = (uint8_t)v;
     }
-    return { gCands[bestIdx], gCands[bestIdx + 1] };
+    return true;
 }
 
+// Compares without an early exit so timing doesn't leak the matching prefix length.
+bool constantTimeEquals(const uint8_t* a, const uint8_t* b, size_t len) {
+    uint8_t diff = 0;
+    for (size_t i = 0; i < len; ++i) diff |= a[i] ^ b[i];
+    return diff == 0;
+}
 
-std::pair<MatchPlayer, MatchPlayer> runMatchmaking(const char* file) {
-    loadMatchCandidates(file);
-    auto match = findBestMatch();
-    // if no two players, get out
-    if (match.first.name.empty()) return {};
+string hashPassword(const string& pwd, const AuthConfig& cfg) {
+    uint8_t salt[SALT_BYTES], hash[HASH_BYTES];
+    random_device rd;
+    for (int i = 0; i < SALT_BYTES; ++i) salt[i] = (uint8_t)(rd() & 0xFF);
+    if (scrypt_kdf((const uint8_t*)pwd.data(), pwd.size(), salt, SALT_BYTES,
+        1ull << cfg.log2N, cfg.r, cfg.p, hash, HASH_BYTES) != 0)
+        return "";
+    return string(SCRYPT_PREFIX) + to_string(cfg.log2N) + "$" + to_string(cfg.r) + "$" + to_string(cfg.p)
+        + "$" + toHex(salt, SALT_BYTES) + "$" + toHex(hash, HASH_BYTES);
+}
 
-    // remove the matched two by shifting left
-    bool removed1 = false, removed2 = false;
-    MatchPlayer a = match.first, b = match.second;
-    int write = 0;
-    for (int read = 0; read < gCandCount; ++read) {
-        auto& mp = gCands[read];
-        if (!removed1 && mp.name == a.name && mp.score == a.score) { removed1 = true; continue; }
-        if (!removed2 && mp.name == b.name && mp.score == b.score) { removed2 = true; continue; }
-        gCands[write++] = mp;
+// Checks pwd against a stored record. needsRehash is set when the record
+// is legacy plaintext or was hashed with a different cost than cfg.
+bool verifyPassword(const string& pwd, const string& record, const AuthConfig& cfg, bool& needsRehash) {
+    needsRehash = false;
+    size_t prefixLen = strlen(SCRYPT_PREFIX);
+    if (record.compare(0, prefixLen, SCRYPT_PREFIX) != 0) {
+        bool ok = record.size() == pwd.size() &&
+            constantTimeEquals((const uint8_t*)record.data(), (const uint8_t*)pwd.data(), pwd.size());
+        needsRehash = ok;
+        return ok;
     }
-    gCandCount = write;
 
-    // re-enqueue the rest
-    for (int i = 0; i < gCandCount; ++i) {
-        g_matchQueue.enqueue(new Player(gCands[i].name, gCands[i].score));
+    // split "<log2N>$<r>$<p>$<salt>$<hash>"
+    string fields[5];
+    size_t pos = prefixLen;
+    for (int i = 0; i < 5; ++i) {
+        size_t end = (i < 4) ? record.find('$', pos) : record.size();
+        if (end == string::npos) return false;
+        fields[i] = record.substr(pos, end - pos);
+        pos = end + 1;
     }
-    return match;
-}
+    int log2N = atoi(fields[0].c_str()), r = atoi(fields[1].c_str()), p = atoi(fields[2].c_str());
+    vector<uint8_t> salt, expected;
+    if (log2N < 1 || log2N > 24 || r < 1 || p < 1 ||
+        !fromHex(fields[3], salt) || !fromHex(fields[4], expected) || expected.empty())
+        return false;
 
+    vector<uint8_t> actual(expected.size());
+    if (scrypt_kdf((const uint8_t*)pwd.data(), pwd.size(), salt.data(), salt.size(),
+        1ull << log2N, r, p, actual.data(), actual.size()) != 0)
+        return false;
+    if (!constantTimeEquals(actual.data(), expected.data(), expected.size()))
+        return false;
+    needsRehash = (log2N != cfg.log2N || r != cfg.r || p != cfg.p);
+    return true;
+}
 
-/////////////////////// LOGIN/SIGNUP //////////////////////////
+// File access is serialised by fileMtx so hashing jobs on different
+// workers can register/migrate accounts concurrently.
 class UserManager {
     string filename;
-public:
-    UserManager(const string& file) : filename(file) {}
-    bool usernameExists(const string& user) {
+    AuthConfig cfg;
+    mutex fileMtx;
+
+    bool findRecord(const string& user, string& record) {
+        lock_guard<mutex> lock(fileMtx);
         ifstream in(filename); if (!in) return false;
-        string u, p; while (in >> u >> p) if (u == user) return true;
+        string u, p; while (in >> u >> p) if (u == user) { record = p; return true; }
         return false;
     }
+    // Replaces user's record through replaceFile(), so a crash never truncates users.txt.
+    void rewriteRecord(const string& user, const string& record) {
+        lock_guard<mutex> lock(fileMtx);
+        vector<pair<string, string>> rows;
+        {
+            ifstream in(filename);
+            string u, p; while (in >> u >> p) rows.push_back({ u, u == user ? record : p });
+        }
+        string tmp = filename + ".tmp";
+        {
+            ofstream out(tmp, ios::trunc);
+            if (!out) return;
+            for (auto& row : rows) out << row.first << " " << row.second << "\n";
+            if (!out) return;
+        }
+        replaceFile(tmp, filename);
+    }
+public:
+    UserManager(const string& file, const AuthConfig& config) : filename(file), cfg(config) { recoverReplacedFile(filename); }
+    bool usernameExists(const string& user) {
+        string record;
+        return findRecord(user, record);
+    }
+    // Slow: runs scrypt. Call from a worker thread, not the UI loop.
     bool registerUser(const string& user, const string& pwd) {
-        if (usernameExists(user) || pwd.size() < 4) return false;
+        if (user.empty() || usernameExists(user) || pwd.size() < 4) return false;
+        string record = hashPassword(pwd, cfg);
+        if (record.empty()) return false;
+        lock_guard<mutex> lock(fileMtx);
+        {
+            ifstream in(filename);
+            string u, p; while (in >> u >> p) if (u == user) return false;  // lost a race
+        }
         ofstream out(filename, ios::app);
-        out << user << " " << pwd << "\n";
+        out << user << " " << record << "\n";
         return true;
     }
+    // Slow: runs scrypt. Call from a worker thread, not the UI loop.
     bool loginUser(const string& user, const string& pwd) {
-        ifstream in(filename); if (!in) return false;
-        string u, p; while (in >> u >> p) if (u == user && p == pwd) return true;
-        return false;
+        string record;
+        if (!findRecord(user, record)) return false;
+        bool needsRehash = false;
+        if (!verifyPassword(pwd, record, cfg, needsRehash)) return false;
+        if (needsRehash) {
+            string upgraded = hashPassword(pwd, cfg);
+            if (!upgraded.empty()) rewriteRecord(user, upgraded);
+        }
+        return true;
+    }
+};
+
+// Runs credential checks on a worker pool; the auth screen polls the returned futures.
+class AuthService {
+    UserManager users;
+    WorkerPool pool;
+public:
+    AuthService(const string& file, const AuthConfig& cfg)
+        : users(file, cfg), pool((unsigned)cfg.workers) {}
+    future<bool> submitLogin(const string& user, const string& pwd) {
+        return pool.submit([this, user, pwd] { return users.loginUser(user, pwd); });
+    }
+    future<bool> submitRegister(const string& user, const string& pwd) {
+        return pool.submit([this, user, pwd] { return users.registerUser(user, pwd); });
     }
 };
 enum AuthAction { ACT_LOGIN = 0, ACT_REGISTER = 1, ACT_DONE = 2 };
 
 bool showAuthScreen(RenderWindow& window, Font& font, string& outUsername) {
-    UserManager mgr("users.txt");
+    AuthService auth("users.txt", loadAuthConfig("auth.cfg"));
+    future<bool> pending;   // valid while a login/register job is in flight
+    Clock pendingClock;
     AuthAction sel = ACT_LOGIN;
     bool inForm = false; int field = 0;
     string username, password, msg;
@@ -649,6 +938,7 @@ bool showAuthScreen(RenderWindow& window, Font& font, string& outUsername) {
         Event e;
         while (window.pollEvent(e)) {
             if (e.type == Event::Closed) return false;
+            if (pending.valid()) continue;   // form is locked until the worker answers
             if (e.type == Event::KeyPressed) {
                 if (!inForm) {
                     if (e.key.code == Keyboard::Left || e.key.code == Keyboard::Right)
@@ -672,9 +962,8 @@ bool showAuthScreen(RenderWindow& window, Font& font, string& outUsername) {
                     {
                         if (field == 0) field = 1;
                         else {
-                            bool ok = (sel == ACT_LOGIN) ? mgr.loginUser(username, password) : mgr.registerUser(username, password);
-                            if (ok) { outUsername = username; return true; }
-                            else msg = (sel == ACT_LOGIN ? "Login failed" : "Register failed");
+                            pending = (sel == ACT_LOGIN) ? auth.submitLogin(username, password) : auth.submitRegister(username, password);
+                            pendingClock.restart();
                         }
                     }
                 }
@@ -685,6 +974,19 @@ bool showAuthScreen(RenderWindow& window, Font& font, string& outUsername) {
                 if (c >= 32 && c < 127) { auto& s = (field == 0 ? username : password); s.push_back(c); }
             }
         }
+        if (pending.valid()) {
+            if (pending.wait_for(chrono::seconds(0)) == future_status::ready) {
+                bool ok = pending.get();
+                if (ok) { outUsername = username; return true; }
+                msg = (sel == ACT_LOGIN ? "Login failed" : "Register failed");
+                info.setFillColor(Color::Red);
+            }
+            else {
+                int dots = (int)(pendingClock.getElapsedTime().asSeconds() * 3) % 4;
+                msg = string(sel == ACT_LOGIN ? "Checking credentials" : "Creating account") + string(dots, '.');
+                info.setFillColor(Color::Yellow);
+            }
+        }
         for (int i = 0; i < 2; i++) btn[i].setFillColor(i == sel ? Color::Yellow : Color::White);
         userIn.setString(username + (inForm && field == 0 ? "_" : ""));
         passIn.setString(string(password.size(), '*') + (inForm && field == 1 ? "_" : ""));
@@ -699,25 +1001,18 @@ bool showAuthScreen(RenderWindow& window, Font& font, string& outUsername) {
 
 /////////////////////// POINTS & POWERUPS //////////////////////
 class PointsTracker {
-    int score = 0, bonus = 0, powerUps = 0, par = 50;
-    Font f; Text txt;
+    ScoreCounter counter;
+    Font f; CachedText txt;
 public:
     PointsTracker() {
         f.loadFromFile("C:/Users/yahya/OneDrive/Desktop/Xonix DS project/fonts/Roboto_Condensed-Bold.ttf");
         txt.setFont(f); txt.setCharacterSize(20); txt.setPosition(10, 10); updateText();
     }
-    void updateText() { txt.setString("Score: " + to_string(score) + "   Power-ups: " + to_string(powerUps)); }
-    void Pointscounter(int tiles) {
-        int pts = tiles;
-        if ((bonus < 3 && tiles>10) || (bonus >= 3 && bonus < 5 && tiles>5)) { pts *= 2; bonus++; }
-        else if (bonus >= 5 && tiles > 5) pts *= 4;
-        score += pts;
-        while (score >= par) { powerUps++; par += (par == 50 ? 20 : 30); }
-        updateText();
-    }
-    void UsePowerUp() { if (powerUps > 0) powerUps--; updateText(); }
+    void updateText() { txt.format("Score: %d   Power-ups: %d", counter.score, counter.powerUps); }
+    void Pointscounter(int tiles) { counter.add(tiles); updateText(); }
+    void UsePowerUp() { counter.use(); updateText(); }
     void draw(RenderWindow& w) { w.draw(txt); }
-    int getScore()const { return score; }  int getPowerUps()const { return powerUps; }
+    int getScore()const { return counter.score; }  int getPowerUps()const { return counter.powerUps; }
 };
 
 
@@ -767,205 +1062,567 @@ T clamp(T v, T lo, T hi) {
 }
 
 
-int selectLevel(RenderWindow& w, Font& f) {
-    const int opt = 3;
-    const char* labels[opt] = { "Level 01", "Level 02", "Level 03" };
-    Text m[opt];
-    int sel = 0;
+/////////////////////// LEVELS ////////////////////////
 
-    for (int i = 0; i < opt; i++) {
-        m[i].setFont(f);
-        m[i].setString(labels[i]);
-        m[i].setCharacterSize(28);
-        FloatRect r = m[i].getLocalBounds();
-        m[i].setOrigin(r.width / 2, r.height / 2);
-        m[i].setPosition(w.getSize().x / 2, w.getSize().y / 2 + i * 50);
-    }
+// Single-player levels come from levels.xlp, a pack compiled offline from
+// levels.txt (see LevelCompiler.h) and mapped at startup; see LevelPack.h.
+// Without a pack the three stock levels below are compiled in memory instead.
+
+static const char* STOCK_LEVELS =
+    "level Level 01\n"
+    "bouncer 16 16\nbouncer 16 16\nbouncer 16 16\nbouncer 16 16\n"
+    "level Level 02 (1 hunter)\n"
+    "bouncer 16 16\nbouncer 16 16\nbouncer 16 16\nbouncer 16 16\nbouncer 16 16\n"
+    "hunter 16 16\n"
+    "level Level 03 (2 hunters)\n"
+    "bouncer 16 16\nbouncer 16 16\nbouncer 16 16\nbouncer 16 16\nbouncer 16 16\nbouncer 16 16\n"
+    "hunter 16 16\nhunter 16 16\n";
+
+static LevelPack gLevels;
+
+void loadLevels(const char* packPath) {
+    if (gLevels.open(packPath)) return;
+    cerr << "Warning: no level pack at " << packPath << ", using the stock levels\n";
+    vector<uint8_t> pack;
+    string err;
+    if (!compileLevels(STOCK_LEVELS, pack, err)) cerr << "stock levels: " << err << "\n";
+    gLevels.openMemory(move(pack));
+}
+
+// Xonix --compile-levels SOURCE PACK
+int runLevelCompiler(int argc, char** argv) {
+    if (argc != 3) { cerr << "usage: Xonix --compile-levels levels.txt levels.xlp\n"; return 2; }
+    string err;
+    int levels = 0;
+    if (!compileLevelFile(argv[1], argv[2], err, &levels)) { cerr << err << "\n"; return 1; }
+    cout << "compiled " << levels << " levels into " << argv[2] << "\n";
+    return 0;
+}
+
+// Lists the pack from its index, a screenful at a time, so a pack of hundreds
+// opens as fast as one of three. Only the highlighted level's body is read,
+// for the preview, which is laid out the way the game will lay it out.
+// Returns the chosen level, or -1 on Escape.
+int selectLevel(RenderWindow& w, Font& f, const LevelPack& pack, int initialSel = 0) {
+    const int count = pack.size(), rowsShown = 12;
+    if (count == 0) return -1;
+    int sel = (initialSel >= 0 && initialSel < count) ? initialSel : 0;
+    int first = 0, previewed = -1;
+
+    Text title("Select Level", f, 28);
+    title.setFillColor(Color::Yellow); title.setPosition(40, 16);
+    CachedText total("", f, 18), rows[rowsShown], info[3];
+    total.setPosition(240, 26);
+    total.format("%d levels", count);
+    for (int i = 0; i < rowsShown; i++) { rows[i].setFont(f); rows[i].setCharacterSize(20); rows[i].setPosition(40, 70 + i * 28.f); }
+    for (int i = 0; i < 3; i++) { info[i].setFont(f); info[i].setCharacterSize(18); info[i].setPosition(520, 310 + i * 26.f); }
+    Text hint("Up/Down  PgUp/PgDn  Home/End  Enter=Play  Esc=Back", f, 16);
+    hint.setFillColor(Color(160, 160, 160)); hint.setPosition(40, w.getSize().y - 32.f);
+
+    Texture previewTex;
+    previewTex.create(N, M);
+    Sprite preview(previewTex);
+    preview.setPosition(520, 70); preview.setScale(9, 9);
+    vector<Uint8> pixels(M * N * 4);
+    vector<int> board(M * N);
+    bool playable = false;
 
     while (w.isOpen()) {
         Event e;
         while (w.pollEvent(e)) {
             if (e.type == Event::Closed) w.close();
             if (e.type == Event::KeyPressed) {
-                if (e.key.code == Keyboard::Up) sel = (sel - 1 + opt) % opt;
-                if (e.key.code == Keyboard::Down) sel = (sel + 1) % opt;
-                if (e.key.code == Keyboard::Enter) return sel; // Return 1 for Level 01, 2 for Level 02, 3 for Level 03
+                if (e.key.code == Keyboard::Up) sel = (sel - 1 + count) % count;
+                else if (e.key.code == Keyboard::Down) sel = (sel + 1) % count;
+                else if (e.key.code == Keyboard::PageUp) sel = max(0, sel - rowsShown);
+                else if (e.key.code == Keyboard::PageDown) sel = min(count - 1, sel + rowsShown);
+                else if (e.key.code == Keyboard::Home) sel = 0;
+                else if (e.key.code == Keyboard::End) sel = count - 1;
+                else if (e.key.code == Keyboard::Enter && playable) return sel;
+                else if (e.key.code == Keyboard::Escape) return -1;
+            }
+        }
+        first = clamp(first, sel - rowsShown + 1, sel);
+
+        if (sel != previewed) {
+            previewed = sel;
+            const LevelIndexEntry& lv = pack.info(sel);
+            LevelView view;
+            playable = pack.level(sel, view);
+            fill(pixels.begin(), pixels.end(), (Uint8)0);
+            if (playable) {
+                int top, left;
+                view.place(board.data(), M, N, top, left);
+                auto paint = [&](int r, int c, Color col) {
+                    Uint8* p = &pixels[(r * N + c) * 4];
+                    p[0] = col.r; p[1] = col.g; p[2] = col.b; p[3] = 255;
+                };
+                for (int i = 0; i < M * N; i++) paint(i / N, i % N, board[i] ? Color(0, 90, 170) : Color(10, 10, 10));
+                paint(top + view.rec->startRow, left + view.rec->startCol, Color::Yellow);
+                for (int k = 0; k < view.enemyCount(); k++)
+                    paint(top + view.spawns[k].row, left + view.spawns[k].col,
+                        view.spawns[k].kind == LEVEL_HUNTER ? Color(255, 110, 110) : Color::White);
+                info[0].format("%d x %d, %d%% open", lv.rows, lv.cols, lv.openPercent);
+                info[1].format("%d bouncers, %d hunters", lv.bouncers, lv.hunters);
+                if (lv.drops) info[2].format("%d power-up drops", lv.drops);
+                else info[2].format("no power-up drops");
+            }
+            else {
+                info[0].format("this level is damaged");
+                info[1].format(" ");
+                info[2].format(" ");
             }
+            previewTex.update(pixels.data());
         }
 
         w.clear(Color::Black);
-        for (int i = 0; i < opt; i++) {
-            m[i].setFillColor(i == sel ? Color::Yellow : Color::White);
-            w.draw(m[i]);
+        w.draw(title); w.draw(total);
+        for (int i = 0; i < rowsShown && first + i < count; i++) {
+            rows[i].format("%3d  %s", first + i + 1, pack.info(first + i).name);
+            rows[i].setFillColor(first + i == sel ? Color::Yellow : Color::White);
+            w.draw(rows[i]);
         }
+        w.draw(preview);
+        for (int i = 0; i < 3; i++) w.draw(info[i]);
+        w.draw(hint);
         w.display();
     }
 
-    return 0;
+    return -1;
 }
 
-/////////////////////// SINGLE-PLAYER ////////////////////////
-int runSinglePlayerMode(RenderWindow& window, Sprite& sTile, Sprite& sEnemy, Font& font, int level) {
-    GameState state;
+/////////////////////// THEME ATLAS ////////////////////////
+
+// Every theme's recoloured copy of tiles.png and enemy.png is baked once at
+// startup into a grid of cells inside one texture:
+//
+//   cell = [ tiles strip | enemy ]   (theme rows wrap to stay under the GPU's max width)
+//
+// The first cell holds the stock art. Cells are baked in parallel and cached as
+// <cacheDir>/theme_<id>_<hash>.png, where the hash covers the source pixels and
+// the palette, so editing either invalidates the cache entry. Switching theme
+// only moves the texture-rect origin; nothing is reloaded when a game starts.
+
+static void makeDir(const string& dir) {
+#ifdef _WIN32
+    _mkdir(dir.c_str());
+#else
+    mkdir(dir.c_str(), 0755);
+#endif
+}
 
-    RectangleShape sidePanel(Vector2f(200, M * ts)); sidePanel.setFillColor(Color(50, 50, 50)); sidePanel.setPosition(N * ts, 0);
-    Text hudTitle("STATS", font, 24); hudTitle.setFillColor(Color::Yellow); hudTitle.setPosition(N * ts + 20, 20);
-    Text scoreLabel("", font, 18), powerLabel("", font, 18);
-    scoreLabel.setPosition(N * ts + 20, 60); powerLabel.setPosition(N * ts + 20, 90);
-    PointsTracker tracker; int enemyCount; Enemy enemies[10];
+class ThemeAtlas {
+    Texture texture;
+    unordered_map<int, Vector2i> cellOf;   // theme ID -> top-left of its cell
+    Vector2i active;                       // cell of the current theme
+    int tilesW = 0, tilesH = 0, enemyW = 0, enemyH = 0;
 
-    if (level == 0) {
-        enemyCount = 4;
-    }
-    else if (level == 1) {
-        enemyCount = 6;
+    static uint64_t fnv1a(const void* data, size_t len, uint64_t h = 1469598103934665603ull) {
+        const uint8_t* p = (const uint8_t*)data;
+        for (size_t i = 0; i < len; ++i) { h ^= p[i]; h *= 1099511628211ull; }
+        return h;
     }
-    else if (level == 2) {
-        enemyCount = 8;
-    }
-    bool inGame = true, drawing = false, moveQ = false; bool frozen = false;
-    int px = 10, py = 0, dx = 0, dy = 0;
-    Clock freezeC, clock; float timer = 0, delay = 0.07f;
-    for (int i = 0; i < M; i++) for (int j = 0; j < N; j++) grid[i][j] = (i == 0 || j == 0 || i == M - 1 || j == N - 1) ? 1 : 0;
-    for (int k = 0; k < enemyCount; k++) enemies[k] = Enemy();
-    while (window.isOpen()) {
-        float dt = clock.restart().asSeconds(); timer += dt;
-        if (frozen && freezeC.getElapsedTime().asSeconds() >= 3.f) frozen = false;
-        Event e; while (window.pollEvent(e)) {
-            if (e.type == Event::Closed) return tracker.getScore();
-            if (e.type == Event::KeyPressed && e.key.code == Keyboard::Escape) {
-                PauseAction act = showPauseMenu(window, font);
-                if (act == PAUSE_RESUME) {
-
-
-                }
-                else if (act == PAUSE_SAVE) {
-                    for (int i = 0; i < M; ++i)
-                        for (int j = 0; j < N; ++j)
-                            state.grid[i][j] = grid[i][j];
-
-                    state.px = px;
-                    state.py = py;
-                    state.dx = dx;
-                    state.dy = dy;
-                    state.inGame = inGame;
-                    state.drawing = drawing;
-                    state.moveQ = moveQ;
-                    state.frozen = frozen;
-                    state.freezeElapsed = freezeC.getElapsedTime().asSeconds();
-                    state.timer = timer;
-                    state.delay = delay;
-
-                    state.score = tracker.getScore();
-                    state.powerUps = tracker.getPowerUps();
-                    state.bonus = 0;
-                    state.par = 50;
-
-                    for (int i = 0; i < ENEMY_COUNT; ++i)
-                        state.enemies[i] = enemies[i];
-
-                    saveGame(state, "save.dat");
 
-                }
-                else if (act == PAUSE_LOAD) {
-                    if (loadGame(state, "save.dat")) {
-                        for (int i = 0; i < M; ++i)
-                            for (int j = 0; j < N; ++j)
-                                grid[i][j] = state.grid[i][j];
-
-                        px = state.px;
-                        py = state.py;
-                        dx = state.dx;
-                        dy = state.dy;
-                        inGame = state.inGame;
-                        drawing = state.drawing;
-                        moveQ = state.moveQ;
-                        frozen = state.frozen;
-                        timer = state.timer;
-                        delay = state.delay;
-                        freezeC.restart();
-                        if (state.frozen)
-                            freezeC.restart();
-
-                        for (int i = 0; i < ENEMY_COUNT; ++i)
-                            enemies[i] = state.enemies[i];
-
-
-                        for (int i = 0; i < state.powerUps; ++i)
-                            tracker.UsePowerUp();
-
-
-                        for (int i = 0; i < state.score; i += 10)
-                            tracker.Pointscounter(10);
-
-                        Clock c;
-                        while (c.getElapsedTime().asSeconds() < 3.f) {}
-                        while (c.getElapsedTime().asSeconds() < 3.f) {}
-                    }
-                }
-                else if (act == PAUSE_EXIT) {
-                    return tracker.getScore();
-                }
+    // Maps each pixel's luminance onto the tint, normalised so the brightest pixel
+    // of the region becomes the full tint colour. Alpha is kept.
+    static void recolour(Uint8* px, int stride, int x0, int y0, int w, int h, Color tint) {
+        if (tint.a == 0) return;
+        int maxL = 1;
+        for (int y = y0; y < y0 + h; ++y)
+            for (int x = x0; x < x0 + w; ++x) {
+                const Uint8* p = px + (y * stride + x) * 4;
+                int l = (p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8;
+                if (l > maxL) maxL = l;
             }
-
-            if (e.type == Event::KeyPressed && inGame && grid[py][px] == 1 && !moveQ) {
-                if (e.key.code == Keyboard::Left) { dx = -1; dy = 0; moveQ = true; }
-                if (e.key.code == Keyboard::Right) { dx = 1; dy = 0; moveQ = true; }
-                if (e.key.code == Keyboard::Up) { dx = 0; dy = -1; moveQ = true; }
-                if (e.key.code == Keyboard::Down) { dx = 0; dy = 1; moveQ = true; }
+        for (int y = y0; y < y0 + h; ++y)
+            for (int x = x0; x < x0 + w; ++x) {
+                Uint8* p = px + (y * stride + x) * 4;
+                int l = (p[0] * 77 + p[1] * 150 + p[2] * 29) >> 8;
+                p[0] = (Uint8)(tint.r * l / maxL);
+                p[1] = (Uint8)(tint.g * l / maxL);
+                p[2] = (Uint8)(tint.b * l / maxL);
             }
-            if (e.type == Event::KeyPressed && inGame && e.key.code == Keyboard::T && tracker.getPowerUps() > 0 && !frozen)
-            {
-                tracker.UsePowerUp();
-                frozen = true;
-                freezeC.restart();
+    }
+
+public:
+    static const int WALL_X = 0, PLAYER_X = 36, TRAIL_X = 54;   // source tiles in tiles.png
+
+    // Bakes (or loads from cache) one cell per theme and uploads the atlas.
+    bool build(const Image& tiles, const Image& enemy, const ThemeCatalog& catalog, const string& cacheDir) {
+        tilesW = (int)tiles.getSize().x; tilesH = (int)tiles.getSize().y;
+        enemyW = (int)enemy.getSize().x; enemyH = (int)enemy.getSize().y;
+        if (tilesW == 0 || enemyW == 0) return false;
+        const int cellW = tilesW + enemyW, cellH = max(tilesH, enemyH);
+        const int maxSize = (int)Texture::getMaximumSize();
+        const int maxPerRow = max(1, min(maxSize / cellW, 16));
+
+        // stock cell first, then catalog order, until the texture is full
+        vector<const Theme*> order(1, nullptr);
+        int maxCells = maxPerRow * max(1, maxSize / cellH);
+        for (const auto& kv : catalog.themes()) {
+            if ((int)order.size() >= maxCells) {
+                cerr << "Warning: theme atlas full, later themes use stock art\n";
+                break;
             }
+            order.push_back(&kv.second);
         }
-        if (inGame && grid[py][px] != 1)
+        const int cells = (int)order.size();
+        const int perRow = min(cells, maxPerRow);
+        const int atlasW = perRow * cellW, atlasH = ((cells + perRow - 1) / perRow) * cellH;
+
+        // the stock cell, laid out the same way every theme cell is
+        vector<Uint8> base((size_t)cellW * cellH * 4, 0);
+        const Uint8* tp = tiles.getPixelsPtr();
+        const Uint8* ep = enemy.getPixelsPtr();
+        for (int y = 0; y < tilesH; ++y) memcpy(&base[(y * cellW) * 4], tp + y * tilesW * 4, tilesW * 4);
+        for (int y = 0; y < enemyH; ++y) memcpy(&base[(y * cellW + tilesW) * 4], ep + y * enemyW * 4, enemyW * 4);
+        uint64_t assetHash = fnv1a(base.data(), base.size());
+
+        makeDir(cacheDir);
+        vector<Uint8> atlas((size_t)atlasW * atlasH * 4, 0);
+        cellOf.clear();
         {
-            if (Keyboard::isKeyPressed(Keyboard::Left))
-            {
-                dx = -1; dy = 0;
-            }
-            if (Keyboard::isKeyPressed(Keyboard::Right))
-            {
-                dx = 1; dy = 0;
-            }
-            if (Keyboard::isKeyPressed(Keyboard::Up))
-            {
-                dx = 0; dy = -1;
-            }
-            if (Keyboard::isKeyPressed(Keyboard::Down))
-            {
-                dx = 0; dy = 1;
+            WorkerPool pool(max(1u, thread::hardware_concurrency()));
+            vector<future<void>> jobs;
+            for (int c = 0; c < cells; ++c) {
+                Vector2i origin((c % perRow) * cellW, (c / perRow) * cellH);
+                if (order[c]) cellOf[order[c]->id] = origin;
+                jobs.push_back(pool.submit([&, c, origin] {
+                    vector<Uint8> cell(base);
+                    const Theme* t = order[c];
+                    if (t) {
+                        const ThemePalette& pal = t->palette;
+                        uint64_t h = fnv1a(&pal, sizeof(pal), assetHash);
+                        char name[64];
+                        snprintf(name, sizeof(name), "/theme_%d_%016llx.png", t->id, (unsigned long long)h);
+                        Image cached;
+                        if (cached.loadFromFile(cacheDir + name) &&
+                            cached.getSize().x == (unsigned)cellW && cached.getSize().y == (unsigned)cellH) {
+                            memcpy(cell.data(), cached.getPixelsPtr(), cell.size());
+                        }
+                        else {
+                            recolour(cell.data(), cellW, WALL_X, 0, ts, tilesH, pal.wall);
+                            recolour(cell.data(), cellW, PLAYER_X, 0, ts, tilesH, pal.player);
+                            recolour(cell.data(), cellW, TRAIL_X, 0, ts, tilesH, pal.trail);
+                            recolour(cell.data(), cellW, tilesW, 0, enemyW, enemyH, pal.enemy);
+                            Image out;
+                            out.create(cellW, cellH, cell.data());
+                            out.saveToFile(cacheDir + name);
+                        }
+                    }
+                    for (int y = 0; y < cellH; ++y)
+                        memcpy(&atlas[((origin.y + y) * atlasW + origin.x) * 4], &cell[y * cellW * 4], cellW * 4);
+                }));
             }
+            for (auto& j : jobs) j.get();
         }
-        if (inGame && timer > delay)
-        {
-            timer = 0;
 
-            if (grid[py][px] == 1)
-            {
-                // We’re on safe tile: only move if a single‐step was queued
-                if (moveQ)
-                {
-                    px = clamp(px + dx, 0, N - 1);
-                    py = clamp(py + dy, 0, M - 1);
-                    moveQ = false;
-                }
-            }
-            else
-            {
-                // Off safe: we slide continuously in the current direction
-                px = clamp(px + dx, 0, N - 1);
-                py = clamp(py + dy, 0, M - 1);
-            }
+        Image img;
+        img.create(atlasW, atlasH, atlas.data());
+        if (!texture.loadFromImage(img)) return false;
+        active = Vector2i(0, 0);
+        return true;
+    }
 
-            // Start trail if leaving safe
-            if (grid[py][px] == 0)
+    // O(1): only changes which cell the rect helpers point into.
+    void setTheme(int themeID) {
+        auto it = cellOf.find(themeID);
+        active = (it == cellOf.end()) ? Vector2i(0, 0) : it->second;
+    }
+
+    const Texture& getTexture() const { return texture; }
+    IntRect tile(int srcX) const { return IntRect(active.x + srcX, active.y, ts, ts); }
+    IntRect enemyRect() const { return IntRect(active.x + tilesW, active.y, enemyW, enemyH); }
+};
+
+static ThemeAtlas gAtlas;
+
+
+/////////////////////// PROFILER OVERLAY ////////////////////////
+
+// F3 toggles a table of per-zone p50/p99 over the last two seconds of every
+// thread's zones, the simulation thread's included (see Profiler.h); F4 writes every thread's recent zones to
+// trace.json for chrome://tracing. While hidden it costs nothing per frame.
+// Below the zones go the key-to-screen latency and how late the simulation
+// thread's ticks start, if the loop reports them, and in debug builds the heap allocations of the last frame and the most any
+// frame has made since the table was last shown.
+class ProfilerOverlay {
+    Text text;
+    RectangleShape back;
+    bool visible = false;
+    Clock sinceRefresh;
+    vector<Profiler::ZoneStats> stats;
+    uint64_t lastAllocs = 0, maxAllocs = 0;
+    const LatencyHistogram* latency = nullptr;
+    bool simReported = false;
+    uint64_t lastLateUs = 0, maxLateUs = 0;
+
+    void refresh() {
+        Profiler::summarize(2000000000ull, stats, true);
+        string table = "zone            p50 us   p99 us   max us\n";
+        char line[96];
+        for (const auto& z : stats) {
+            snprintf(line, sizeof(line), "%-14s %8.1f %8.1f %8.1f\n", z.name, z.p50, z.p99, z.max);
+            table += line;
+        }
+        if (latency && latency->count()) {
+            snprintf(line, sizeof(line), "key to screen ms  p50 %.0f  p99 %.0f  max %.1f\n",
+                latency->percentileMs(0.5), latency->percentileMs(0.99), latency->maxMs());
+            table += line;
+        }
+        if (simReported) {
+            snprintf(line, sizeof(line), "sim tick late us  last %llu  max %llu\n",
+                (unsigned long long)lastLateUs, (unsigned long long)maxLateUs);
+            table += line;
+        }
+#if XONIX_ALLOC_TRACK
+        snprintf(line, sizeof(line), "heap allocs/frame  last %llu  max %llu\n",
+            (unsigned long long)lastAllocs, (unsigned long long)maxAllocs);
+        table += line;
+#endif
+        table += "F3 hide   F4 save trace.json";
+        text.setString(table);
+        FloatRect b = text.getLocalBounds();
+        back.setSize(Vector2f(b.width + 16, b.height + 18));
+        sinceRefresh.restart();
+    }
+
+public:
+    explicit ProfilerOverlay(Font& font) : text("", font, 14) {
+        text.setFillColor(Color::White);
+        text.setPosition(8, 6);
+        back.setFillColor(Color(0, 0, 0, 190));
+    }
+
+    // True if the key was one of the overlay's.
+    bool handleKey(Keyboard::Key code) {
+        if (code == Keyboard::F3) {
+            visible = !visible;
+            maxAllocs = maxLateUs = 0;
+            if (visible) refresh();
+            return true;
+        }
+        if (code == Keyboard::F4) {
+            if (Profiler::writeChromeTrace("trace.json")) cout << "Profiler: wrote trace.json\n";
+            else cerr << "Profiler: could not write trace.json\n";
+            return true;
+        }
+        return false;
+    }
+
+    // Adds an input-latency line fed from h.
+    void showLatency(const LatencyHistogram* h) { latency = h; }
+
+    // Allocations made by one frame, before the overlay itself drew.
+    void noteFrameAllocs(uint64_t n) {
+        lastAllocs = n;
+        maxAllocs = max(maxAllocs, n);
+    }
+
+    // How late the newest simulation tick started against its schedule.
+    void noteSimLateness(uint64_t us) {
+        simReported = true;
+        lastLateUs = us;
+        maxLateUs = max(maxLateUs, us);
+    }
+
+    void draw(RenderWindow& window) {
+        if (!visible) return;
+        if (sinceRefresh.getElapsedTime().asSeconds() >= 0.25f) refresh();
+        window.draw(back);
+        window.draw(text);
+    }
+};
+
+/////////////////////// SINGLE-PLAYER ////////////////////////
+
+// Frame drawing, shared by the game loop and --render-bench. Each returns the
+// draw calls it issued; every SFML draw() is one GL draw call.
+
+// Wall and trail tiles of a board (see GridKernels.h); open cells are left to the clear colour.
+template<typename Dims>
+int drawBoard(RenderTarget& target, Sprite& sTile, const int* cells, Dims d) {
+    int calls = 0;
+    for (int i = 0; i < d.rows(); i++)
+        for (int j = 0; j < d.cols(); j++)
+        {
+            int v = cells[i * d.cols() + j];
+            if (v == 0) continue;
+            sTile.setTextureRect(v == 1 ? gAtlas.tile(ThemeAtlas::WALL_X) : gAtlas.tile(ThemeAtlas::TRAIL_X));
+            sTile.setPosition(j * ts, i * ts); target.draw(sTile);
+            ++calls;
+        }
+    return calls;
+}
+
+// The player tile and the enemies, spinning; enemies from firstHunter on are tinted as hunters.
+int drawSprites(RenderTarget& target, Sprite& sTile, Sprite& sEnemy, int px, int py,
+    const Enemy* enemies, int enemyCount, int firstHunter) {
+    sTile.setTextureRect(gAtlas.tile(ThemeAtlas::PLAYER_X));
+    sTile.setPosition(px * ts, py * ts); target.draw(sTile);
+    for (int k = 0; k < enemyCount; k++)
+    {
+        sEnemy.rotate(2.f); sEnemy.setPosition(enemies[k].x, enemies[k].y);
+        sEnemy.setColor(k >= firstHunter ? Color(255, 110, 110) : Color::White);   // hunters glow red
+        target.draw(sEnemy);
+    }
+    sEnemy.setColor(Color::White);
+    return 1 + enemyCount;
+}
+
+// The stats panel to the right of a board boardW pixels wide.
+struct SideHud {
+    RectangleShape panel;
+    Text title;
+    CachedText scoreLabel, powerLabel;
+
+    SideHud(const Font& font, float boardW, float boardH)
+        : panel(Vector2f(200, boardH)), title("STATS", font, 24), scoreLabel("", font, 18), powerLabel("", font, 18) {
+        panel.setFillColor(Color(50, 50, 50)); panel.setPosition(boardW, 0);
+        title.setFillColor(Color::Yellow); title.setPosition(boardW + 20, 20);
+        scoreLabel.setPosition(boardW + 20, 60); powerLabel.setPosition(boardW + 20, 90);
+    }
+
+    int draw(RenderTarget& target, int score, int powerUps) {
+        target.draw(panel); target.draw(title);
+        scoreLabel.format("Score: %d", score);
+        powerLabel.format("PU: %d", powerUps);
+        target.draw(scoreLabel);
+        target.draw(powerLabel);
+        return 4;
+    }
+};
+
+// What the render side needs to draw one simulation tick. The sim thread
+// writes a whole frame every tick; the render side only ever reads its copy.
+template<typename Dims>
+struct SinglePlayerFrame {
+    int grid[Dims::ROWS][Dims::COLS];
+    int px, py;
+    int enemyCount, firstHunter;
+    int enemyX[LEVEL_MAX_ENEMIES], enemyY[LEVEL_MAX_ENEMIES]; // after this tick
+    int prevX[LEVEL_MAX_ENEMIES], prevY[LEVEL_MAX_ENEMIES];   // before it, for interpolation
+    int score, powerUps;
+    bool inGame;
+    uint64_t publishedNs;            // Profiler::now() when published
+    uint64_t lateUs;                 // how far behind schedule this tick started
+    uint32_t turnSeq;                // bumped whenever a tick applies a queued turn
+    uint64_t turnStampNs;            // that turn's key event stamp
+};
+
+// A key press on its way from the render thread to the sim thread.
+struct SimInput {
+    int8_t dx, dy;
+    bool freeze;
+    uint64_t stampNs;
+};
+
+// The single-player game, ticked at TICK_HZ on its own thread. The render
+// thread posts presses into a lock-free mailbox and draws the newest frame
+// from a triple buffer, so neither waits for the other: a stalled display()
+// no longer holds back the simulation, and a slow tick no longer holds back a
+// frame. The board is a FixedDims (see GridKernels.h) at least the stock
+// size, so every pack level fits; the sim's grid belongs to the sim thread
+// while it runs, so stop() it before touching the game state from elsewhere
+// (pause menu, save, load).
+template<typename Dims>
+class SinglePlayerSim {
+public:
+    static const int TICK_HZ = 60;   // enemy speeds are in pixels per tick
+    static const int FREEZE_TICKS = 3 * TICK_HZ;
+    static const int ROWS = Dims::ROWS, COLS = Dims::COLS;
+    typedef SinglePlayerFrame<Dims> Frame;
+
+private:
+    static_assert(ROWS >= M && COLS >= N, "pack levels are checked against the stock board");
+
+    TripleBuffer<Frame>& out;
+    MpmcQueue<SimInput>& inbox;
+    thread worker;
+    atomic<bool> running;
+
+    ScoreCounter points;
+    int enemyCount = 4, hunters = 0, bouncers = 4;   // the last hunters enemies chase the trail
+    Enemy enemies[LEVEL_MAX_ENEMIES];
+    int hunterSpeed[LEVEL_MAX_ENEMIES];
+    int prevX[LEVEL_MAX_ENEMIES], prevY[LEVEL_MAX_ENEMIES];
+    int grid[ROWS][COLS];
+    FlowField<Dims> field;
+    uint32_t gridVersion = 0;   // bumped on every grid write so the field knows to rebuild
+    bool inGame = true, drawing = false, frozen = false;
+    enum TimerKind : uint8_t { THAW = 1, DROP = 2 };
+    uint32_t tickNo = 0;
+    TimerWheel<8> timers;                 // timed effects, due on tickNo
+    TimerWheel<8>::Handle thaw = 0;       // the pending end of the current freeze
+    const LevelDrop* drops = nullptr;     // the level's power-up schedule, in its pack
+    const char* levelName;                // in the pack too; saves are tied to it
+    int dropCount = 0, nextDrop = 0;
+    int top = 0, left = 0, bottom = ROWS - 1, right = COLS - 1;   // the level's cells on the board
+    int px = 10, py = 0, dx = 0, dy = 0;
+    float timer = 0, delay = 0.07f;
+    InputQueue turns;   // presses wait here for the next player step
+    uint32_t turnSeq = 0;
+    uint64_t turnStampNs = 0;
+    int captureStack[ROWS * COLS + 1];
+
+    // One drop is pending at a time; firing it queues the next.
+    void scheduleDrop() {
+        if (nextDrop < dropCount) timers.schedule(drops[nextDrop].tick, DROP);
+    }
+
+    void onTimer(uint8_t kind) {
+        if (kind == THAW) frozen = false;
+        else if (kind == DROP) {
+            const LevelDrop& d = drops[nextDrop++];
+            if (d.kind == LEVEL_DROP_FREEZE) points.powerUps += d.count;
+            scheduleDrop();
+        }
+    }
+
+    void tick() {
+        PROFILE_ZONE("sim tick");
+        ++tickNo;
+        timers.advance(tickNo, [this](uint8_t kind, uint8_t) { onTimer(kind); });
+        SimInput in;
+        while (inbox.tryDequeue(in)) {
+            if (!inGame) continue;
+            if (!in.freeze) turns.push(in.dx, in.dy, in.stampNs);
+            else if (!frozen && points.use()) { frozen = true; thaw = timers.schedule(tickNo + FREEZE_TICKS, THAW); }
+        }
+        timer += 1.f / TICK_HZ;
+
+        if (inGame && timer > delay)
+        {
+            PROFILE_ZONE("player step");
+            timer = 0;
+
+            // one queued press per step turns the player
+            TimedTurn turn;
+            bool turned = turns.pop(turn);
+            if (turned) { dx = turn.dx; dy = turn.dy; ++turnSeq; turnStampNs = turn.stampNs; }
+
+            if (grid[py][px] == 1)
+            {
+                // We’re on safe tile: only move a single step per press
+                if (turned)
+                {
+                    px = clamp(px + dx, left, right);
+                    py = clamp(py + dy, top, bottom);
+                }
+            }
+            else
+            {
+                // Off safe: we slide continuously in the current direction
+                px = clamp(px + dx, left, right);
+                py = clamp(py + dy, top, bottom);
+            }
+
+            // Start trail if leaving safe
+            if (grid[py][px] == 0)
             {
                 grid[py][px] = 2;
                 drawing = true;
+                ++gridVersion;
             }
             // If we run into our own trail while drawing → game over
             else if (grid[py][px] == 2 && drawing)
@@ -975,414 +1632,828 @@ int runSinglePlayerMode(RenderWindow& window, Sprite& sTile, Sprite& sEnemy, Fon
         }
         if (inGame && grid[py][px] == 1 && drawing)
         {
+            PROFILE_ZONE("capture");
             dx = dy = 0; drawing = false;
-            int trail = 0, before = 0;
-            for (int i = 0; i < M; i++)for (int j = 0; j < N; j++)
-            {
-                if (grid[i][j] == 2)trail++; else if (grid[i][j] == 0)before++;
-            }
-            for (int k = 0; k < enemyCount; k++) drop(enemies[k].y / ts, enemies[k].x / ts);
-            for (int i = 0; i < M; i++)
-                for (int j = 0; j < N; j++) grid[i][j] = (grid[i][j] == -1 ? 0 : 1);
-
-            int after = 0;
-            for (int i = 0; i < M; i++)
-                for (int j = 0; j < N; j++)
-                    if (grid[i][j] == 0) after++;
-            tracker.Pointscounter(trail + (before - after));
+            points.add(captureBoard(&grid[0][0], Dims(), enemies, enemyCount, captureStack));
+            ++gridVersion;
         }
+        for (int k = 0; k < enemyCount; k++) { prevX[k] = enemies[k].x; prevY[k] = enemies[k].y; }
         if (inGame && !frozen) {
+            PROFILE_ZONE("enemies");
+            if (hunters) { PROFILE_ZONE("hunter field"); field.update(grid, py, px, gridVersion); }
             for (int k = 0; k < enemyCount; k++) {
-                enemies[k].move();
+                if (k >= bouncers) enemies[k].chase(&grid[0][0], field, hunterSpeed[k]);
+                else enemies[k].move(&grid[0][0], Dims());
                 int gi = enemies[k].y / ts, gj = enemies[k].x / ts;
-                if (gi > 0 && gi < M && gj > 0 && gj < N && grid[gi][gj] == 2)
+                if (gi > 0 && gi < ROWS && gj > 0 && gj < COLS && grid[gi][gj] == 2)
                     inGame = false;
             }
         }
-        window.clear();
-        for (int i = 0; i < M; i++)
-            for (int j = 0; j < N; j++)
-            {
-                if (grid[i][j] == 0) continue;
-                sTile.setTextureRect(grid[i][j] == 1 ? IntRect(0, 0, ts, ts) : IntRect(54, 0, ts, ts));
-                sTile.setPosition(j * ts, i * ts); window.draw(sTile);
+    }
+
+    void publish(uint64_t lateUs) {
+        Frame& f = out.writeSlot();
+        memcpy(f.grid, grid, sizeof(f.grid));
+        f.px = px; f.py = py;
+        f.enemyCount = enemyCount; f.firstHunter = bouncers;
+        for (int k = 0; k < enemyCount; k++) {
+            f.enemyX[k] = enemies[k].x; f.enemyY[k] = enemies[k].y;
+            f.prevX[k] = prevX[k]; f.prevY[k] = prevY[k];
+        }
+        f.score = points.score; f.powerUps = points.powerUps;
+        f.inGame = inGame;
+        f.lateUs = lateUs;
+        f.turnSeq = turnSeq; f.turnStampNs = turnStampNs;
+        f.publishedNs = Profiler::now();
+        out.publish();
+    }
+
+    // Ticks on a fixed schedule. A tick that starts more than a few ticks late
+    // moves the schedule instead of running the backlog back to back.
+    void loop() {
+        typedef chrono::steady_clock SimClock;
+        const SimClock::duration period = chrono::duration_cast<SimClock::duration>(chrono::duration<double>(1.0 / TICK_HZ));
+        SimClock::time_point due = SimClock::now();
+        while (running.load(memory_order_acquire)) {
+            SimClock::time_point now = SimClock::now();
+            if (now < due) {
+                sf::sleep(microseconds((Int64)chrono::duration_cast<chrono::microseconds>(due - now).count()));
+                continue;
             }
-        sTile.setTextureRect(IntRect(36, 0, ts, ts));
-        sTile.setPosition(px * ts, py * ts); window.draw(sTile);
-        for (int k = 0; k < enemyCount; k++)
-        {
-            sEnemy.rotate(2.f); sEnemy.setPosition(enemies[k].x, enemies[k].y);
-            window.draw(sEnemy);
-        }
-        window.draw(sidePanel); window.draw(hudTitle);
-        scoreLabel.setString("Score: " + to_string(tracker.getScore()));
-        powerLabel.setString("PU: " + to_string(tracker.getPowerUps()));
-        window.draw(scoreLabel);
-        window.draw(powerLabel);
-        if (!inGame) {
-            Text over("Game Over\nEsc=Menu", font, 28);
-            over.setFillColor(Color::Red);
-            FloatRect b = over.getLocalBounds();
-            over.setOrigin(b.width / 2, b.height / 2);
-            over.setPosition((N * ts) / 2, (M * ts) / 2);
-            window.draw(over);
+            uint64_t lateUs = (uint64_t)chrono::duration_cast<chrono::microseconds>(now - due).count();
+            if (now - due > 4 * period) due = now;
+            due += period;
+            tick();
+            publish(lateUs);
         }
+    }
 
-        window.display();
+public:
+    // The level stays in its pack, which must outlive the sim.
+    SinglePlayerSim(const LevelView& level, const char* name, TripleBuffer<Frame>& frames, MpmcQueue<SimInput>& inputs)
+        : out(frames), inbox(inputs), running(false), levelName(name) {
+        static_assert(TICK_HZ == LEVEL_TICK_HZ, "level drops are scheduled in sim ticks");
+        level.place(&grid[0][0], ROWS, COLS, top, left);
+        bottom = top + level.rows() - 1; right = left + level.cols() - 1;
+        px = left + level.rec->startCol; py = top + level.rec->startRow;
+        enemyCount = min(level.enemyCount(), LEVEL_MAX_ENEMIES);
+        hunters = 0;
+        for (int k = 0; k < enemyCount; k++) {
+            const LevelSpawn& s = level.spawns[k];
+            Enemy& e = enemies[k];
+            e.x = (left + s.col) * ts + ts / 2; e.y = (top + s.row) * ts + ts / 2;
+            if (s.dx || s.dy) { e.dx = s.dx; e.dy = s.dy; }
+            else { e.dx = s.speed - rand() % (2 * s.speed); e.dy = s.speed - rand() % (2 * s.speed); }
+            hunterSpeed[k] = s.speed;
+            hunters += s.kind == LEVEL_HUNTER;
+            prevX[k] = e.x; prevY[k] = e.y;
+        }
+        bouncers = enemyCount - hunters;
+        drops = level.drops; dropCount = level.dropCount();
+        timers.reset(0);
+        scheduleDrop();
+        publish(0);
     }
-    return tracker.getScore();
-}
+    ~SinglePlayerSim() { stop(); }
 
+    void start() {
+        if (running.exchange(true)) return;
+        worker = thread(&SinglePlayerSim::loop, this);
+    }
 
-/////////////////////// MULTIPLAYER /////////////////////////
+    void stop() {
+        running.store(false, memory_order_release);
+        if (worker.joinable()) worker.join();
+    }
 
+    int score() const { return points.score; }
+
+    // Only while stopped.
+    void saveTo(GameState& state) const {
+        static_assert(ROWS == M && COLS == N, "save.dat holds a stock board");
+        state = GameState();
+        state.version = SAVE_VERSION;
+        strncpy_s(state.level, levelName, LEVEL_NAME_BYTES - 1);
+        state.tickNo = tickNo;
+        state.nextDrop = nextDrop;
+        state.enemyCount = enemyCount;
+        for (int i = 0; i < M; ++i)
+            for (int j = 0; j < N; ++j)
+                state.grid[i][j] = grid[i][j];
+
+        state.px = px;
+        state.py = py;
+        state.dx = dx;
+        state.dy = dy;
+        state.inGame = inGame;
+        state.drawing = drawing;
+        state.moveQ = turns.size() > 0;
+        state.frozen = frozen;
+        state.freezeElapsed = frozen && timers.pending(thaw)
+            ? (float)(FREEZE_TICKS - (int)(timers.dueOf(thaw) - tickNo)) / TICK_HZ : 0.f;
+        state.timer = timer;
+        state.delay = delay;
+
+        state.score = points.score;
+        state.powerUps = points.powerUps;
+        state.bonus = 0;
+        state.par = 50;
+
+        for (int i = 0; i < enemyCount; ++i)
+            state.enemies[i] = enemies[i];
+    }
 
-void runMultiplayerMode(
-    RenderWindow& window,
-    Sprite& sTile,
-    Sprite& sEnemySprite,
-    Font& font
-) {
-    // --- HUD setup ---
-    RectangleShape sidePanel(Vector2f(200.f, M * ts));
-    sidePanel.setFillColor(Color(50, 50, 50));
-    sidePanel.setPosition(N * ts, 0.f);
-
-    Text hudTitle("STATS", font, 24);
-    hudTitle.setFillColor(Color::Yellow);
-    hudTitle.setPosition(N * ts + 20.f, 20.f);
-
-    Text p1Label("", font, 18), p2Label("", font, 18);
-    p1Label.setFillColor(Color::Red);
-    p1Label.setPosition(N * ts + 20.f, 60.f);
-    p2Label.setFillColor(Color(0, 255, 255));
-    p2Label.setPosition(N * ts + 20.f, 100.f);
-
-    PointsTracker tracker1, tracker2;
-    const int enemyCount = 4;
-
-    // Local Enemy struct
-    struct EnemyLocal {
-        int x, y, dx, dy;
-        void init() {
-            x = y = 300;
-            dx = 4 - rand() % 8;
-            dy = 4 - rand() % 8;
-            if (dx == 0 && dy == 0) dx = 1;
-        }
-        void move(int G[][N], int t) {
-            x += dx;
-            int gy = y / t, gx = x / t;
-            if (gx <= 0 || gx >= N - 1 || G[gy][gx] == 1) { dx = -dx; x += dx; }
-            y += dy;
-            gy = y / t; gx = x / t;
-            if (gy <= 0 || gy >= M - 1 || G[gy][gx] == 1) { dy = -dy; y += dy; }
-            if (x < 0) x = 0; else if (x > N * t) x = N * t;
-            if (y < 0) y = 0; else if (y > M * t) y = M * t;
+    // Only while stopped. False, leaving the game as it was, if the save was
+    // made on another level.
+    bool loadFrom(const GameState& state) {
+        static_assert(ROWS == M && COLS == N, "save.dat holds a stock board");
+        if (strncmp(state.level, levelName, LEVEL_NAME_BYTES) != 0 || state.enemyCount != enemyCount
+            || state.nextDrop < 0 || state.nextDrop > dropCount)
+            return false;
+        for (int i = 0; i < M; ++i)
+            for (int j = 0; j < N; ++j)
+                grid[i][j] = state.grid[i][j];
+        ++gridVersion;
+
+        px = state.px;
+        py = state.py;
+        dx = state.dx;
+        dy = state.dy;
+        inGame = state.inGame;
+        drawing = state.drawing;
+        turns.clear();
+        if (state.moveQ) turns.push((int8_t)dx, (int8_t)dy, Profiler::now());
+        frozen = state.frozen;
+        tickNo = state.tickNo;
+        nextDrop = state.nextDrop;
+        timers.reset(tickNo);
+        thaw = frozen ? timers.schedule(tickNo + FREEZE_TICKS - (int)(state.freezeElapsed * TICK_HZ), THAW) : 0;
+        scheduleDrop();
+        timer = state.timer;
+        delay = state.delay;
+
+        for (int i = 0; i < enemyCount; ++i) {
+            enemies[i] = state.enemies[i];
+            prevX[i] = enemies[i].x; prevY[i] = enemies[i].y;
         }
-    };
 
-    EnemyLocal enemies[10];
-    for (int i = 0; i < enemyCount; ++i)
-        enemies[i].init();
-
-    // Shared grid
-    static int G[M][N];
-    for (int i = 0; i < M; ++i)
-        for (int j = 0; j < N; ++j)
-            G[i][j] = (i == 0 || j == 0 || i == M - 1 || j == N - 1) ? 1 : 0;
-
-    // Recursive flood fill for capture
-    auto dropL = [&](auto&& self, int r, int c)->void {
-        if (r <= 0 || r >= M - 1 || c <= 0 || c >= N - 1) return;
-        if (G[r][c] == 0) {
-            G[r][c] = -1;
-            self(self, r - 1, c);
-            self(self, r + 1, c);
-            self(self, r, c - 1);
-            self(self, r, c + 1);
-        }
-        };
-
-    // Player state
-    bool alive1 = true, alive2 = true;
-    bool draw1 = false, draw2 = false;
-    bool moveQ1 = false, moveQ2 = false;
-    int px1 = 10, py1 = 0, dx1 = 0, dy1 = 0;
-    int px2 = N - 11, py2 = 0, dx2 = 0, dy2 = 0;
-
-    // Freeze state
-    bool freezeEnemies = false;
-    bool freezeP1 = false, freezeP2 = false;
-    Clock freezeC1, freezeC2;
-    const float freezeDuration = 3.f;
-
-    Clock clock;
-    float timer = 0.f, delay = 0.07f;
 
+        for (int i = 0; i < state.powerUps; ++i)
+            points.use();
+
+
+        for (int i = 0; i < state.score; i += 10)
+            points.add(10);
+        publish(0);
+        return true;
+    }
+};
+
+int runSinglePlayerMode(RenderWindow& window, Sprite& sTile, Sprite& sEnemy, Font& font, const LevelView& level, const char* levelName, const KeyBindings& keys) {
+    GameState state;
+
+    SideHud hud(font, N * ts, M * ts);
+    Text over("Game Over\nEsc=Menu", font, 28);
+    over.setFillColor(Color::Red);
+    FloatRect overBounds = over.getLocalBounds();
+    over.setOrigin(overBounds.width / 2, overBounds.height / 2);
+    over.setPosition((N * ts) / 2, (M * ts) / 2);
+    ProfilerOverlay overlay(font);
+    LatencyHistogram keyToScreen;
+    uint32_t shownTurnSeq = 0;
+    overlay.showLatency(&keyToScreen);
+
+    // the simulation runs on its own thread from here on; this loop pumps
+    // events into its mailbox and draws whatever frame it last published
+    typedef SinglePlayerSim<StockDims> Sim;
+    static TripleBuffer<Sim::Frame> frames;   // static: three frames are too big for the stack
+    MpmcQueue<SimInput> inputs(64);
+    Sim sim(level, levelName, frames, inputs);
+    Enemy shown[LEVEL_MAX_ENEMIES];   // enemy positions as drawn, between two ticks
+    const uint64_t tickNs = 1000000000ull / Sim::TICK_HZ;
+    sim.start();
     while (window.isOpen()) {
-        float dt = clock.restart().asSeconds();
-        timer += dt;
+        PROFILE_ZONE("frame");
+        const uint64_t allocMark = AllocTracker::count();
+        {
+            PROFILE_ZONE("input");
+            Event e; while (window.pollEvent(e)) {
+                if (e.type == Event::Closed) { sim.stop(); keyToScreen.print(stdout, "Key to screen latency"); return sim.score(); }
+                if (e.type == Event::KeyPressed && overlay.handleKey(e.key.code)) continue;
+                if (e.type == Event::KeyPressed && e.key.code == Keyboard::Escape) {
+                    sim.stop();
+                    PauseAction act = showPauseMenu(window, font);
+                    if (act == PAUSE_RESUME) {
 
-        // Auto-unfreeze after duration
-        if (freezeEnemies) {
-            if ((freezeP2 && freezeC1.getElapsedTime().asSeconds() >= freezeDuration) ||
-                (freezeP1 && freezeC2.getElapsedTime().asSeconds() >= freezeDuration))
-            {
-                freezeEnemies = freezeP1 = freezeP2 = false;
-            }
-        }
 
-        // Event handling
-        Event e;
-        while (window.pollEvent(e)) {
-            if (e.type == Event::Closed) return;
-            if (!alive1 && !alive2 &&
-                e.type == Event::KeyPressed && e.key.code == Keyboard::Escape)
-            {
-                return; // back to menu
-            }
+                    }
+                    else if (act == PAUSE_SAVE) {
+                        sim.saveTo(state);
+                        saveGame(state, "save.dat");
 
-            if (e.type == Event::KeyPressed) {
-                // P1 boundary move
-                if (alive1 && G[py1][px1] == 1 && !moveQ1 && !freezeP1) {
-                    if (e.key.code == Keyboard::Left) { dx1 = -1; dy1 = 0; moveQ1 = true; }
-                    if (e.key.code == Keyboard::Right) { dx1 = 1; dy1 = 0; moveQ1 = true; }
-                    if (e.key.code == Keyboard::Up) { dx1 = 0; dy1 = -1; moveQ1 = true; }
-                    if (e.key.code == Keyboard::Down) { dx1 = 0; dy1 = 1; moveQ1 = true; }
-                }
-                // P2 boundary move
-                if (alive2 && G[py2][px2] == 1 && !moveQ2 && !freezeP2) {
-                    if (e.key.code == Keyboard::A) { dx2 = -1; dy2 = 0; moveQ2 = true; }
-                    if (e.key.code == Keyboard::D) { dx2 = 1; dy2 = 0; moveQ2 = true; }
-                    if (e.key.code == Keyboard::W) { dx2 = 0; dy2 = -1; moveQ2 = true; }
-                    if (e.key.code == Keyboard::S) { dx2 = 0; dy2 = 1; moveQ2 = true; }
-                }
-                // Freeze power‑ups
-                if (e.key.code == Keyboard::T && alive1 && tracker1.getPowerUps() > 0 && !freezeEnemies) {
-                    tracker1.UsePowerUp();
-                    freezeEnemies = true;
-                    freezeP2 = true;
-                    freezeC1.restart();
+                    }
+                    else if (act == PAUSE_LOAD) {
+                        if (loadGame(state, "save.dat") && sim.loadFrom(state)) {
+                            Clock c;
+                            while (c.getElapsedTime().asSeconds() < 3.f) {}
+                            while (c.getElapsedTime().asSeconds() < 3.f) {}
+                        }
+                    }
+                    else if (act == PAUSE_EXIT) {
+                        keyToScreen.print(stdout, "Key to screen latency");
+                        return sim.score();
+                    }
+                    sim.start();
+                    continue;
                 }
-                if (e.key.code == Keyboard::P && alive2 && tracker2.getPowerUps() > 0 && !freezeEnemies) {
-                    tracker2.UsePowerUp();
-                    freezeEnemies = true;
-                    freezeP1 = true;
-                    freezeC2.restart();
+
+                if (e.type == Event::KeyPressed) {
+                    SimInput in = { 0, 0, false, Profiler::now() };
+                    if (e.key.code == keys.left) in.dx = -1;
+                    else if (e.key.code == keys.right) in.dx = 1;
+                    else if (e.key.code == keys.up) in.dy = -1;
+                    else if (e.key.code == keys.down) in.dy = 1;
+                    else if (e.key.code == keys.freeze) in.freeze = true;
+                    if (in.dx || in.dy || in.freeze) inputs.tryEnqueue(in);
                 }
             }
         }
 
-        // Continuous sliding off boundary
-        if (alive1 && G[py1][px1] != 1 && !freezeP1) {
-            if (Keyboard::isKeyPressed(Keyboard::Left)) { dx1 = -1; dy1 = 0; }
-            if (Keyboard::isKeyPressed(Keyboard::Right)) { dx1 = 1; dy1 = 0; }
-            if (Keyboard::isKeyPressed(Keyboard::Up)) { dx1 = 0; dy1 = -1; }
-            if (Keyboard::isKeyPressed(Keyboard::Down)) { dx1 = 0; dy1 = 1; }
+        frames.fetch();
+        const Sim::Frame& f = frames.readSlot();
+        {
+            // enemies are drawn part of the way from their last position to the
+            // newest, by how much of a tick has passed since it was published
+            float a = (float)(Profiler::now() - f.publishedNs) / tickNs;
+            a = clamp(a, 0.f, 1.f);
+            for (int k = 0; k < f.enemyCount; k++) {
+                shown[k].x = f.prevX[k] + (int)((f.enemyX[k] - f.prevX[k]) * a);
+                shown[k].y = f.prevY[k] + (int)((f.enemyY[k] - f.prevY[k]) * a);
+            }
+        }
+        {
+            PROFILE_ZONE("draw board");
+            window.clear();
+            drawBoard(window, sTile, &f.grid[0][0], StockDims());
         }
-        if (alive2 && G[py2][px2] != 1 && !freezeP2) {
-            if (Keyboard::isKeyPressed(Keyboard::A)) { dx2 = -1; dy2 = 0; }
-            if (Keyboard::isKeyPressed(Keyboard::D)) { dx2 = 1; dy2 = 0; }
-            if (Keyboard::isKeyPressed(Keyboard::W)) { dx2 = 0; dy2 = -1; }
-            if (Keyboard::isKeyPressed(Keyboard::S)) { dx2 = 0; dy2 = 1; }
+        {
+            PROFILE_ZONE("draw sprites");
+            drawSprites(window, sTile, sEnemy, f.px, f.py, shown, f.enemyCount, f.firstHunter);
+        }
+        {
+            PROFILE_ZONE("hud text");
+            hud.draw(window, f.score, f.powerUps);
         }
+        if (!f.inGame) window.draw(over);
+        overlay.noteFrameAllocs(AllocTracker::count() - allocMark);
+        overlay.noteSimLateness(f.lateUs);
+        overlay.draw(window);
 
-        // Movement + drawing on grid
-        if (timer > delay) {
-            timer = 0.f;
+        {
+            PROFILE_ZONE("display");   // includes the wait for vsync / the frame limit
+            window.display();
+        }
+        if (f.turnSeq != shownTurnSeq) {
+            keyToScreen.add(Profiler::now() - f.turnStampNs);
+            shownTurnSeq = f.turnSeq;
+        }
+    }
+    sim.stop();
+    keyToScreen.print(stdout, "Key to screen latency");
+    return sim.score();
+}
 
-            // Player 1 step & trail
-            if (alive1 && !freezeP1) {
-                if (G[py1][px1] == 1 && moveQ1) {
-                    px1 = max(0, min(px1 + dx1, N - 1));
-                    py1 = max(0, min(py1 + dy1, M - 1));
-                    moveQ1 = false;
-                }
-                else if (G[py1][px1] != 1) {
-                    px1 = max(0, min(px1 + dx1, N - 1));
-                    py1 = max(0, min(py1 + dy1, M - 1));
-                }
-                int& c1 = G[py1][px1];
-                if (c1 == 0) { c1 = 2; draw1 = true; }
-                else if (c1 == 2 && draw1) alive1 = false;
-            }
 
-            // Player 2 step & trail
-            if (alive2 && !freezeP2) {
-                if (G[py2][px2] == 1 && moveQ2) {
-                    px2 = max(0, min(px2 + dx2, N - 1));
-                    py2 = max(0, min(py2 + dy2, M - 1));
-                    moveQ2 = false;
-                }
-                else if (G[py2][px2] != 1) {
-                    px2 = max(0, min(px2 + dx2, N - 1));
-                    py2 = max(0, min(py2 + dy2, M - 1));
-                }
-                int& c2 = G[py2][px2];
-                if (c2 == 0) { c2 = 3; draw2 = true; }
-                else if (c2 == 3 && draw2) alive2 = false;
-            }
+/////////////////////// EVENT MAP ////////////////////////
 
-            if (alive1 && G[py1][px1] == 3) {
-                alive1 = false;
-            }
-            // (2) P2 intercepts P1's trail?
-            if (alive2 && G[py2][px2] == 2) {
-                alive2 = false;
-            }
+// Event play on a map far bigger than the window (see BigMapWorld.h). The
+// camera follows the player over the stock board's area of the window, and
+// only the chunks it shows are drawn or simulated.
 
-            bool safe1 = (G[py1][px1] == 1);
-            bool safe2 = (G[py2][px2] == 1);
+const int EVENT_MAP_ROWS = 10000, EVENT_MAP_COLS = 10000;
+const int EVENT_MAP_CELLS_PER_ENEMY = 20000;
 
-            // (3) P1 drawing and steps onto P2 in safe zone
-            if (alive1 && draw1 && safe2 && px1 == px2 && py1 == py2) {
-                alive1 = false;
-            }
-            // (4) P2 drawing and steps onto P1 in safe zone
-            if (alive2 && draw2 && safe1 && px1 == px2 && py1 == py2) {
-                alive2 = false;
-            }
+// Wall and trail tiles of board rows r0..r1 x cols c0..c1; chunks that are all open are skipped whole.
+int drawBoardRegion(RenderTarget& target, Sprite& sTile, const ChunkedBoard& board, int r0, int c0, int r1, int c1) {
+    const int S = ChunkedBoard::SHIFT, W = ChunkedBoard::SIZE, K = ChunkedBoard::MASK;
+    int calls = 0;
+    for (int cr = r0 >> S; cr <= r1 >> S; ++cr)
+        for (int cc = c0 >> S; cc <= c1 >> S; ++cc)
+        {
+            if (board.fill(cr, cc) == ChunkedBoard::OPEN_FILL) continue;
+            const int8_t* cells = board.chunkCells(cr, cc);   // null: all wall
+            const int i0 = max(r0, cr << S), i1 = min(r1, (cr << S) + K);
+            const int j0 = max(c0, cc << S), j1 = min(c1, (cc << S) + K);
+            for (int i = i0; i <= i1; i++)
+                for (int j = j0; j <= j1; j++)
+                {
+                    int v = cells ? cells[(i & K) * W + (j & K)] : 1;
+                    if (v == 0) continue;
+                    sTile.setTextureRect(v == 1 ? gAtlas.tile(ThemeAtlas::WALL_X) : gAtlas.tile(ThemeAtlas::TRAIL_X));
+                    sTile.setPosition(j * ts, i * ts); target.draw(sTile);
+                    ++calls;
+                }
+        }
+    return calls;
+}
 
-            // Player 1 capture region
-            if (alive1 && G[py1][px1] == 1 && draw1) {
-                draw1 = false;
-                int trail = 0, before = 0;
-                for (int i = 0; i < M; ++i)
-                    for (int j = 0; j < N; ++j) {
-                        if (G[i][j] == 2) ++trail;
-                        else if (G[i][j] == 0) ++before;
-                    }
-                for (int k = 0; k < enemyCount; ++k)
-                    dropL(dropL, enemies[k].y / ts, enemies[k].x / ts);
-                for (int i = 0; i < M; ++i)
-                    for (int j = 0; j < N; ++j)
-                        G[i][j] = (G[i][j] == -1 ? 0 : 1);
-                int after = 0;
-                for (int i = 0; i < M; ++i)
-                    for (int j = 0; j < N; ++j)
-                        if (G[i][j] == 0) ++after;
-                tracker1.Pointscounter(trail + (before - after));
+int runEventMapMode(RenderWindow& window, Sprite& sTile, Sprite& sEnemy, Font& font, const KeyBindings& keys) {
+    static BigMapWorld world;   // static: its chunks are reused by the next event game
+    world.reset(EVENT_MAP_ROWS, EVENT_MAP_COLS, (int)((long long)EVENT_MAP_ROWS * EVENT_MAP_COLS / EVENT_MAP_CELLS_PER_ENEMY),
+        (uint32_t)time(0));
+    const int rows = world.board.rows(), cols = world.board.cols();
+    const float viewW = N * ts, viewH = M * ts;
+    View camera(FloatRect(0, 0, viewW, viewH));
+    camera.setViewport(FloatRect(0, 0, viewW / (viewW + 200), 1));
+
+    SideHud hud(font, viewW, viewH);
+    CachedText mapLabel("", font, 16);
+    mapLabel.setPosition(viewW + 20, 130);
+    Text over("Game Over\nEsc=Menu", font, 28);
+    over.setFillColor(Color::Red);
+    FloatRect overBounds = over.getLocalBounds();
+    over.setOrigin(overBounds.width / 2, overBounds.height / 2);
+    over.setPosition(viewW / 2, viewH / 2);
+    ProfilerOverlay overlay(font);
+
+    while (window.isOpen()) {
+        PROFILE_ZONE("frame");
+        const uint64_t allocMark = AllocTracker::count();
+        {
+            PROFILE_ZONE("input");
+            Event e; while (window.pollEvent(e)) {
+                if (e.type == Event::Closed) return world.points.score;
+                if (e.type != Event::KeyPressed) continue;
+                if (overlay.handleKey(e.key.code)) continue;
+                if (e.key.code == Keyboard::Escape) return world.points.score;   // no saves: the save format is the stock board's
+                if (e.key.code == keys.left) world.press(-1, 0, Profiler::now());
+                else if (e.key.code == keys.right) world.press(1, 0, Profiler::now());
+                else if (e.key.code == keys.up) world.press(0, -1, Profiler::now());
+                else if (e.key.code == keys.down) world.press(0, 1, Profiler::now());
+                else if (e.key.code == keys.freeze) world.freeze();
             }
+        }
 
-            // Player 2 capture region
-            if (alive2 && G[py2][px2] == 1 && draw2) {
-                draw2 = false;
-                int trail = 0, before = 0;
-                for (int i = 0; i < M; ++i)
-                    for (int j = 0; j < N; ++j) {
-                        if (G[i][j] == 3) ++trail;
-                        else if (G[i][j] == 0) ++before;
+        // the camera keeps the player centred, stopping at the map's edges
+        float cx = clamp(world.px * ts + ts / 2.f, viewW / 2, max(viewW / 2, cols * ts - viewW / 2));
+        float cy = clamp(world.py * ts + ts / 2.f, viewH / 2, max(viewH / 2, rows * ts - viewH / 2));
+        camera.setCenter(cx, cy);
+        const int r0 = max(0, (int)(cy - viewH / 2) / ts), r1 = min(rows - 1, (int)(cy + viewH / 2) / ts);
+        const int c0 = max(0, (int)(cx - viewW / 2) / ts), c1 = min(cols - 1, (int)(cx + viewW / 2) / ts);
+        world.setViewport(r0, c0, r1, c1);
+        {
+            PROFILE_ZONE("sim");
+            world.tick();
+        }
+
+        window.clear();
+        window.setView(camera);
+        {
+            PROFILE_ZONE("draw board");
+            drawBoardRegion(window, sTile, world.board, r0, c0, r1, c1);
+        }
+        {
+            PROFILE_ZONE("draw sprites");
+            sTile.setTextureRect(gAtlas.tile(ThemeAtlas::PLAYER_X));
+            sTile.setPosition(world.px * ts, world.py * ts); window.draw(sTile);
+            const int S = ChunkedBoard::SHIFT;
+            for (int cr = r0 >> S; cr <= r1 >> S; ++cr)
+                for (int cc = c0 >> S; cc <= c1 >> S; ++cc)
+                    for (int k = world.chunkHead[cr * world.board.chunkCols() + cc]; k >= 0; k = world.enemies[k].next)
+                    {
+                        sEnemy.rotate(2.f); sEnemy.setPosition(world.enemies[k].x, world.enemies[k].y);
+                        window.draw(sEnemy);
                     }
-                for (int k = 0; k < enemyCount; ++k)
-                    dropL(dropL, enemies[k].y / ts, enemies[k].x / ts);
-                for (int i = 0; i < M; ++i)
-                    for (int j = 0; j < N; ++j)
-                        G[i][j] = (G[i][j] == -1 ? 0 : 1);
-                int after = 0;
-                for (int i = 0; i < M; ++i)
-                    for (int j = 0; j < N; ++j)
-                        if (G[i][j] == 0) ++after;
-                tracker2.Pointscounter(trail + (before - after));
-            }
         }
+        window.setView(window.getDefaultView());
+        {
+            PROFILE_ZONE("hud text");
+            hud.draw(window, world.points.score, world.points.powerUps);
+            mapLabel.format("Map %dx%d\nChunks: %d\nMemory: %d KB\nLast capture: %d",
+                rows, cols, (int)world.board.chunksInUse(), (int)(world.board.bytesUsed() / 1024), world.lastCapture.filled);
+            window.draw(mapLabel);
+        }
+        if (!world.alive) window.draw(over);
+        overlay.noteFrameAllocs(AllocTracker::count() - allocMark);
+        overlay.draw(window);
 
-        // Enemies move if not frozen
-        if (!freezeEnemies) {
-            for (int k = 0; k < enemyCount; ++k) {
-                enemies[k].move(G, ts);
-                int gy = enemies[k].y / ts, gx = enemies[k].x / ts;
-                if (alive1 && gy > 0 && gy < M && gx>0 && gx < N && G[gy][gx] == 2) alive1 = false;
-                if (alive2 && gy > 0 && gy < M && gx>0 && gx < N && G[gy][gx] == 3) alive2 = false;
-            }
+        {
+            PROFILE_ZONE("display");
+            window.display();
         }
+    }
+    return world.points.score;
+}
+
+
+/////////////////////// MULTIPLAYER /////////////////////////
 
-        // Player‐player collision logic
-        bool safe1 = (G[py1][px1] == 1);
-        bool safe2 = (G[py2][px2] == 1);
-        bool cons1 = (!safe1 && draw1);
-        bool cons2 = (!safe2 && draw2);
 
-        if (px1 == px2 && py1 == py2) {
-            if (cons1 && cons2)         alive1 = alive2 = false;
-            else if (cons1 && !cons2)        alive1 = false;
-            else if (!cons1 && cons2)        alive2 = false;
-            // both safe → continue
+// Local keys, one set per seat at the keyboard: moves, then freeze.
+struct PadKeys { Keyboard::Key left, right, up, down, freeze; };
+const int LOCAL_PADS = 4;
+const PadKeys localPads[LOCAL_PADS] = {
+    { Keyboard::Left, Keyboard::Right, Keyboard::Up, Keyboard::Down, Keyboard::T },
+    { Keyboard::A, Keyboard::D, Keyboard::W, Keyboard::S, Keyboard::P },
+    { Keyboard::J, Keyboard::L, Keyboard::I, Keyboard::K, Keyboard::U },
+    { Keyboard::Numpad4, Keyboard::Numpad6, Keyboard::Numpad8, Keyboard::Numpad5, Keyboard::Numpad0 }
+};
+
+// Player colours; captured walls are drawn in a lighter shade of their owner's.
+const Color playerColors[RoomWorld::MAX_PLAYERS] = {
+    Color::Red, Color(0, 255, 255), Color(255, 220, 0), Color(200, 80, 255),
+    Color(60, 220, 60), Color(255, 140, 0), Color(80, 120, 255), Color(255, 105, 180)
+};
+
+// Draws one room world: walls tinted by owner, trails by the player drawing
+// them, players, enemies, the side panel and the result banner. Shared by the
+// local room client and the network client.
+class RoomView {
+    RectangleShape sidePanel;
+    Text hudTitle;
+    CachedText labels[RoomWorld::MAX_PLAYERS];
+    CachedText banner;
+    Color wallTint[RoomWorld::MAX_PLAYERS];
+    Font& font;
+
+public:
+    explicit RoomView(Font& f) : sidePanel(Vector2f(200.f, M * ts)), hudTitle("STATS", f, 24), banner("", f, 24), font(f) {
+        banner.setFillColor(Color::Yellow);
+        sidePanel.setFillColor(Color(50, 50, 50));
+        sidePanel.setPosition(N * ts, 0.f);
+        hudTitle.setFillColor(Color::Yellow);
+        hudTitle.setPosition(N * ts + 20.f, 20.f);
+        for (int p = 0; p < RoomWorld::MAX_PLAYERS; ++p) {
+            const Color& c = playerColors[p];
+            wallTint[p] = Color((c.r + 255) / 2, (c.g + 255) / 2, (c.b + 255) / 2);
+            labels[p].setFont(f);
+            labels[p].setCharacterSize(18);
+            labels[p].setFillColor(c);
         }
+    }
 
-        // --- RENDER ---
-        window.clear();
+    // endHint goes under the result ("Esc=Menu"); you marks the local player's label, -1 for none.
+    void draw(RenderWindow& window, Sprite& sTile, Sprite& sEnemySprite, const RoomWorld& view,
+        const char* endHint, int you = -1) {
+        const int playerCount = view.playerCount;
 
-        // draw grid
         for (int i = 0; i < M; ++i) {
             for (int j = 0; j < N; ++j) {
-                int v = G[i][j];
+                int v = view.G[i][j];
                 if (v == 0) continue;
                 sTile.setPosition(j * ts, i * ts);
-                sTile.setTextureRect(v == 1
-                    ? IntRect(0, 0, ts, ts)
-                    : IntRect(54, 0, ts, ts));
-                sTile.setColor(v == 3 ? Color(0, 255, 255) : Color::White);
+                if (v == 1) {
+                    int o = view.owner[i][j];
+                    sTile.setTextureRect(gAtlas.tile(ThemeAtlas::WALL_X));
+                    sTile.setColor(o < 0 ? Color::White : wallTint[o]);
+                }
+                else {
+                    int p = v - RoomWorld::TRAIL;
+                    sTile.setTextureRect(gAtlas.tile(ThemeAtlas::TRAIL_X));
+                    sTile.setColor(p == 0 ? Color::White : playerColors[p]);
+                }
                 window.draw(sTile);
             }
         }
-        sTile.setColor(Color::White);
 
         // draw players
-        if (alive1) {
-            sTile.setTextureRect(IntRect(36, 0, ts, ts));
-            sTile.setPosition(px1 * ts, py1 * ts);
-            sTile.setColor(Color::Red);
-            window.draw(sTile);
-        }
-        if (alive2) {
-            sTile.setTextureRect(IntRect(36, 0, ts, ts));
-            sTile.setPosition(px2 * ts, py2 * ts);
-            sTile.setColor(Color(0, 255, 255));
+        sTile.setTextureRect(gAtlas.tile(ThemeAtlas::PLAYER_X));
+        for (int p = 0; p < playerCount; ++p) {
+            const RoomWorld::Player& pl = view.players[p];
+            if (!pl.alive) continue;
+            sTile.setPosition(pl.x * ts, pl.y * ts);
+            sTile.setColor(playerColors[p]);
             window.draw(sTile);
         }
         sTile.setColor(Color::White);
 
         // draw enemies
-        for (int k = 0; k < enemyCount; ++k) {
+        for (int k = 0; k < RoomWorld::ENEMIES; ++k) {
             sEnemySprite.rotate(2.f);
-            sEnemySprite.setPosition(enemies[k].x, enemies[k].y);
+            sEnemySprite.setPosition(view.enemies[k].x, view.enemies[k].y);
             window.draw(sEnemySprite);
         }
 
         // HUD
         window.draw(sidePanel);
         window.draw(hudTitle);
-        p1Label.setString("P1: S=" + to_string(tracker1.getScore()) + " PU=" + to_string(tracker1.getPowerUps()));
-        p2Label.setString("P2: S=" + to_string(tracker2.getScore()) + " PU=" + to_string(tracker2.getPowerUps()));
-        window.draw(p1Label);
-        window.draw(p2Label);
+        const float rowHeight = playerCount > 6 ? 48.f : 60.f;
+        for (int p = 0; p < playerCount; ++p) {
+            const RoomWorld::Player& pl = view.players[p];
+            labels[p].setPosition(N * ts + 20.f, 60.f + rowHeight * p);
+            labels[p].format("P%d%s: S=%d PU=%d\n    Land=%d%s", p + 1, p == you ? " (you)" : "",
+                pl.points.score, pl.points.powerUps, view.territory[p], pl.alive ? "" : " (out)");
+            window.draw(labels[p]);
+        }
 
         // GAME OVER / RESULT
-        if (!alive1 || !alive2) {
-            Text over("", font, 24);
-            over.setFillColor(Color::Yellow);
-
-            if (!alive1 && !alive2) {
-                int s1 = tracker1.getScore();
-                int s2 = tracker2.getScore();
-                if (s1 > s2)       over.setString("P1 Wins by Score!\nEsc=Menu");
-                else if (s2 > s1)  over.setString("P2 Wins by Score!\nEsc=Menu");
-                else               over.setString("Tie Game!\nEsc=Menu");
+        int alive = view.aliveCount(), lastAlive = -1, best = 0;
+        for (int p = 0; p < playerCount; ++p) {
+            if (view.players[p].alive) lastAlive = p;
+            if (view.players[p].points.score > view.players[best].points.score) best = p;
+        }
+        if (alive <= 1) {
+            if (alive == 0) {
+                int ties = 0;
+                for (int p = 0; p < playerCount; ++p)
+                    ties += view.players[p].points.score == view.players[best].points.score;
+                if (ties > 1) banner.format("Tie Game!\n%s", endHint);
+                else          banner.format("P%d Wins by Score!\n%s", best + 1, endHint);
+            }
+            else banner.format("P%d Wins!\n%s", lastAlive + 1, endHint);
+
+            FloatRect b = banner.getLocalBounds();
+            banner.setOrigin(b.width / 2, b.height / 2);
+            banner.setPosition((N * ts) / 2.f, (M * ts) / 2.f);
+            window.draw(banner);
+        }
+    }
+};
+
+// Centred message for a couple of seconds, then back to the caller.
+void showNotice(RenderWindow& window, Font& font, const string& message) {
+    Text msg(message, font, 22);
+    msg.setFillColor(Color::Yellow);
+    FloatRect b = msg.getLocalBounds();
+    msg.setOrigin(b.width / 2, b.height / 2);
+    msg.setPosition((N * ts + 200) / 2.f, (M * ts) / 2.f);
+    Clock shown;
+    while (window.isOpen() && shown.getElapsedTime().asSeconds() < 2.f) {
+        Event e;
+        while (window.pollEvent(e))
+            if (e.type == Event::Closed) window.close();
+        window.clear();
+        window.draw(msg);
+        window.display();
+    }
+}
+
+// Direction held on a pad (checked in this order, last wins).
+void heldDirection(const PadKeys& k, int8_t& dx, int8_t& dy) {
+    dx = dy = 0;
+    if (Keyboard::isKeyPressed(k.left)) { dx = -1; dy = 0; }
+    if (Keyboard::isKeyPressed(k.right)) { dx = 1; dy = 0; }
+    if (Keyboard::isKeyPressed(k.up)) { dx = 0; dy = -1; }
+    if (Keyboard::isKeyPressed(k.down)) { dx = 0; dy = 1; }
+}
+
+// Direction a key-down on a pad means, (0,0) if none.
+void pressedDirection(const PadKeys& k, Keyboard::Key code, int8_t& dx, int8_t& dy) {
+    dx = dy = 0;
+    if (code == k.left) dx = -1;
+    else if (code == k.right) dx = 1;
+    else if (code == k.up) dy = -1;
+    else if (code == k.down) dy = 1;
+}
+
+// The match itself runs headless in a room on the room server; this loop is
+// just a client: it posts the local players' keys and draws the room's latest view.
+// The last bots seats are played by RoomBots of the given depth inside the room.
+void runMultiplayerMode(
+    RenderWindow& window,
+    Sprite& sTile,
+    Sprite& sEnemySprite,
+    Font& font,
+    RoomServer& server,
+    int playerCount = 2,
+    int bots = 0,
+    int botDepth = 4
+) {
+    if (playerCount < 2) playerCount = 2;
+    if (playerCount > RoomWorld::MAX_PLAYERS) playerCount = RoomWorld::MAX_PLAYERS;
+    bots = clamp(bots, 0, playerCount - 1);
+    const int humans = min(playerCount - bots, LOCAL_PADS);
+    bots = playerCount - humans;
+
+    uint32_t roomID = server.createRoom((uint32_t)rand() * 2654435761u + 1, playerCount, bots, botDepth);
+    RoomClient room = server.attach(roomID);
+    if (!room.valid()) {
+        // server is at capacity; say so briefly and go back to the menu
+        showNotice(window, font, "All game rooms are busy, try again shortly");
+        return;
+    }
+
+    RoomView roomView(font);
+    int8_t sentHeld[LOCAL_PADS][2] = {};
+    RoomWorld view;
+
+    while (window.isOpen()) {
+        room.read(view);
+
+        // Event handling
+        Event e;
+        while (window.pollEvent(e)) {
+            if (e.type == Event::Closed) { server.closeRoom(roomID); return; }
+            if (view.finished() &&
+                e.type == Event::KeyPressed && e.key.code == Keyboard::Escape)
+            {
+                server.closeRoom(roomID);
+                return; // back to menu
             }
-            else if (!alive1)   over.setString("P2 Wins!\nEsc=Menu");
-            else                over.setString("P1 Wins!\nEsc=Menu");
 
-            FloatRect b = over.getLocalBounds();
-            over.setOrigin(b.width / 2, b.height / 2);
-            over.setPosition((N * ts) / 2.f, (M * ts) / 2.f);
-            window.draw(over);
+            if (e.type == Event::KeyPressed) {
+                for (uint8_t p = 0; p < humans; ++p) {
+                    int8_t dx, dy;
+                    pressedDirection(localPads[p], e.key.code, dx, dy);
+                    if (dx || dy) room.post(RoomInput{ p, dx, dy, RoomInput::PRESS });
+                    if (e.key.code == localPads[p].freeze) room.post(RoomInput{ p, 0, 0, RoomInput::FREEZE });
+                }
+            }
+        }
+
+        // held directions, sent only when they change
+        for (uint8_t p = 0; p < humans; ++p) {
+            int8_t dx, dy;
+            heldDirection(localPads[p], dx, dy);
+            if (dx != sentHeld[p][0] || dy != sentHeld[p][1]) {
+                if (room.post(RoomInput{ p, dx, dy, RoomInput::HELD })) {
+                    sentHeld[p][0] = dx;
+                    sentHeld[p][1] = dy;
+                }
+            }
+        }
+
+        // --- RENDER ---
+        window.clear();
+        roomView.draw(window, sTile, sEnemySprite, view, "Esc=Menu");
+        window.display();
+    }
+    server.closeRoom(roomID);
+}
+
+
+/////////////////////// NETWORK GAME /////////////////////////
+
+// net.cfg holds "key value" lines:
+//   role host|join, address <dotted quad to join>, port, players (host only),
+//   netcode server|rollback (rollback is two players, peer to peer),
+//   loss_percent, latency_ms, jitter_ms (simulated on this machine's outgoing packets).
+// Missing file or keys keep the defaults: host a 2-player server game on port 47000.
+struct NetSettings {
+    bool host = true;
+    bool rollback = false;
+    string address = "127.0.0.1";
+    NetConfig net;
+};
+
+NetSettings loadNetSettings(const char* fname) {
+    NetSettings cfg;
+    ifstream in(fname);
+    string key, val;
+    while (in >> key >> val) {
+        if (key == "role") cfg.host = val != "join";
+        else if (key == "netcode") cfg.rollback = val == "rollback";
+        else if (key == "address") cfg.address = val;
+        else if (key == "port") { int v = atoi(val.c_str()); if (v > 0 && v < 65536) cfg.net.port = (uint16_t)v; }
+        else if (key == "players") { int v = atoi(val.c_str()); if (v >= 2 && v <= RoomWorld::MAX_PLAYERS) cfg.net.players = v; }
+        else if (key == "loss_percent") cfg.net.link.loss = clamp(atof(val.c_str()), 0.0, 100.0) / 100;
+        else if (key == "latency_ms") cfg.net.link.latency = clamp(atof(val.c_str()), 0.0, 2000.0) / 1000;
+        else if (key == "jitter_ms") cfg.net.link.jitter = clamp(atof(val.c_str()), 0.0, 2000.0) / 1000;
+    }
+    return cfg;
+}
+
+// Two-player peer-to-peer game with rollback (see Rollback.h). The host
+// plays seat 0 and the joiner seat 1, both on arrows + T.
+void runRollbackMode(RenderWindow& window, Sprite& sTile, Sprite& sEnemySprite, Font& font, const NetSettings& cfg) {
+    RollbackConfig rc;
+    rc.host = cfg.host;
+    rc.port = cfg.net.port;
+    rc.seed = cfg.net.seed;
+    rc.link = cfg.net.link;
+    NetAddress host;
+    if (!cfg.host && !NetAddress::parse(cfg.address.c_str(), cfg.net.port, host)) {
+        showNotice(window, font, "net.cfg: bad address " + cfg.address);
+        return;
+    }
+    unique_ptr<RollbackSession> session(new RollbackSession(rc));
+    if (!session->open(host)) {
+        showNotice(window, font, "Cannot open UDP port " + to_string(cfg.net.port));
+        return;
+    }
+    auto start = chrono::steady_clock::now();
+    RoomView roomView(font);
+    Text status("", font, 24);
+    status.setFillColor(Color::Yellow);
+    const PadKeys& pad = localPads[0];
+
+    while (window.isOpen()) {
+        Event e;
+        while (window.pollEvent(e)) {
+            if (e.type == Event::Closed) window.close();
+            if (e.type != Event::KeyPressed) continue;
+            if (e.key.code == Keyboard::Escape) return;
+            int8_t dx, dy;
+            pressedDirection(pad, e.key.code, dx, dy);
+            if (dx || dy) session->press(dx, dy);
+            if (e.key.code == pad.freeze) session->freeze();
         }
+        int8_t dx, dy;
+        heldDirection(pad, dx, dy);
+        session->setHeld(dx, dy);
+        session->update(chrono::duration<double>(chrono::steady_clock::now() - start).count());
 
+        window.clear();
+        if (session->getState() == RollbackSession::RUNNING) {
+            roomView.draw(window, sTile, sEnemySprite, session->view(), "Next round shortly, Esc=Menu", session->getSeat());
+        }
+        else {
+            status.setString(cfg.host ? "Waiting for a player on port " + to_string(session->port()) + "...\nEsc=Menu"
+                                      : "Connecting to " + cfg.address + ":" + to_string(cfg.net.port) + "...\nEsc=Menu");
+            FloatRect b = status.getLocalBounds();
+            status.setOrigin(b.width / 2, b.height / 2);
+            status.setPosition((N * ts + 200) / 2.f, (M * ts) / 2.f);
+            window.draw(status);
+        }
         window.display();
     }
 }
 
+// One seat of a UDP game. The host also runs the authoritative NetServer on
+// a background thread and joins it over loopback like everyone else. The
+// local player (arrows + T) is predicted; everyone else is drawn as of the
+// latest snapshot.
+void runNetworkMode(RenderWindow& window, Sprite& sTile, Sprite& sEnemySprite, Font& font) {
+    NetSettings cfg = loadNetSettings("net.cfg");
+    cfg.net.seed = (uint32_t)rand() * 2654435761u + 1;
+    if (cfg.rollback) {
+        runRollbackMode(window, sTile, sEnemySprite, font, cfg);
+        return;
+    }
+    auto start = chrono::steady_clock::now();
+    auto netNow = [start]() { return chrono::duration<double>(chrono::steady_clock::now() - start).count(); };
+
+    unique_ptr<NetServer> server;
+    thread serverThread;
+    atomic<bool> stopServer(false);
+    NetAddress addr;
+    if (cfg.host) {
+        server.reset(new NetServer(cfg.net));
+        if (!server->open()) {
+            showNotice(window, font, "Cannot open UDP port " + to_string(cfg.net.port));
+            return;
+        }
+        addr = NetAddress::loopback(server->port());
+        serverThread = thread([&]() {
+            while (!stopServer.load()) {
+                server->update(netNow());
+                this_thread::sleep_for(chrono::milliseconds(1));
+            }
+        });
+    }
+    else if (!NetAddress::parse(cfg.address.c_str(), cfg.net.port, addr)) {
+        showNotice(window, font, "net.cfg: bad address " + cfg.address);
+        return;
+    }
+
+    NetClient client(cfg.net);
+    if (client.connect(addr)) {
+        RoomView roomView(font);
+        Text status("", font, 24);
+        status.setFillColor(Color::Yellow);
+        const PadKeys& pad = localPads[0];
+        bool leave = false;
+
+        while (window.isOpen() && !leave) {
+            Event e;
+            while (window.pollEvent(e)) {
+                if (e.type == Event::Closed) window.close();
+                if (e.type != Event::KeyPressed) continue;
+                if (e.key.code == Keyboard::Escape) leave = true;
+                int8_t dx, dy;
+                pressedDirection(pad, e.key.code, dx, dy);
+                if (dx || dy) client.press(dx, dy);
+                if (e.key.code == pad.freeze) client.freeze();
+            }
+            int8_t dx, dy;
+            heldDirection(pad, dx, dy);
+            client.setHeld(dx, dy);
+            client.update(netNow());
+
+            window.clear();
+            if (client.getState() == NetClient::PLAYING) {
+                roomView.draw(window, sTile, sEnemySprite, client.view(), "Next round shortly, Esc=Menu", client.getSeat());
+            }
+            else {
+                if (client.getState() == NetClient::CONNECTING)
+                    status.setString("Connecting to " + cfg.address + ":" + to_string(addr.port) + "...\nEsc=Menu");
+                else
+                    status.setString("Waiting for players " + to_string(client.getSeatsTaken()) + "/" +
+                        to_string(client.getPlayers()) + "\nEsc=Menu");
+                FloatRect b = status.getLocalBounds();
+                status.setOrigin(b.width / 2, b.height / 2);
+                status.setPosition((N * ts + 200) / 2.f, (M * ts) / 2.f);
+                window.draw(status);
+            }
+            window.display();
+        }
+    }
+    else showNotice(window, font, "Cannot open a UDP socket");
+
+    stopServer = true;
+    if (serverThread.joinable()) serverThread.join();
+}
+
 
 
 
@@ -1465,7 +2536,7 @@ int showMainMenu(RenderWindow& w, Font& f) {
 
 
 int selectGameMode(RenderWindow& w, Font& f) {
-    const int opt = 2; const char* labels[opt] = { "Single Player","Multiplayer" };
+    const int opt = 5; const char* labels[opt] = { "Single Player","Multiplayer","Party (2-4 local)","Network (net.cfg)","Event Map" };
     Text m[opt]; int sel = 0;
     for (int i = 0; i < opt; i++) {
         m[i].setFont(f);
@@ -1493,118 +2564,433 @@ int selectGameMode(RenderWindow& w, Font& f) {
     return 0;
 }
 
+// Returns how many local players (2-4) join a party game.
+int selectPlayerCount(RenderWindow& w, Font& f) {
+    const int opt = LOCAL_PADS - 1;
+    const char* labels[opt] = { "2 Players", "3 Players (3rd: IJKL + U)", "4 Players (4th: Numpad 8456 + 0)" };
+    Text m[opt]; int sel = 0;
+    for (int i = 0; i < opt; i++) {
+        m[i].setFont(f);
+        m[i].setString(labels[i]); m[i].setCharacterSize(28);
+        FloatRect r = m[i].getLocalBounds(); m[i].setOrigin(r.width / 2, r.height / 2);
+        m[i].setPosition(w.getSize().x / 2, w.getSize().y / 2 + i * 50);
+    }
+    while (w.isOpen()) {
+        Event e; while (w.pollEvent(e)) {
+            if (e.type == Event::Closed) w.close();
+            if (e.type == Event::KeyPressed)
+            {
+                if (e.key.code == Keyboard::Up) sel = (sel - 1 + opt) % opt;
+                if (e.key.code == Keyboard::Down) sel = (sel + 1) % opt;
+                if (e.key.code == Keyboard::Enter) return sel + 2;
+            }
+        }
+        w.clear(Color::Black);
+        for (int i = 0; i < opt; i++)
+        {
+            m[i].setFillColor(i == sel ? Color::Yellow : Color::White); w.draw(m[i]);
+        }
+        w.display();
+    }
+    return 2;
+}
+
+// Offered when matchmaking finds nobody. Returns the bot's search depth, 0 to go back.
+int selectBotDifficulty(RenderWindow& w, Font& f) {
+    const int opt = 4;
+    const char* labels[opt] = { "Easy bot", "Normal bot", "Hard bot", "Back" };
+    const int depths[opt] = { 1, 3, 6, 0 };
+    Text title("No opponent found - play a bot?", f, 30);
+    FloatRect tr = title.getLocalBounds(); title.setOrigin(tr.width / 2, tr.height / 2);
+    title.setPosition(w.getSize().x / 2, w.getSize().y / 2 - 80);
+    Text m[opt]; int sel = 1;
+    for (int i = 0; i < opt; i++) {
+        m[i].setFont(f);
+        m[i].setString(labels[i]); m[i].setCharacterSize(28);
+        FloatRect r = m[i].getLocalBounds(); m[i].setOrigin(r.width / 2, r.height / 2);
+        m[i].setPosition(w.getSize().x / 2, w.getSize().y / 2 + i * 50);
+    }
+    while (w.isOpen()) {
+        Event e; while (w.pollEvent(e)) {
+            if (e.type == Event::Closed) w.close();
+            if (e.type == Event::KeyPressed)
+            {
+                if (e.key.code == Keyboard::Up) sel = (sel - 1 + opt) % opt;
+                if (e.key.code == Keyboard::Down) sel = (sel + 1) % opt;
+                if (e.key.code == Keyboard::Enter) return depths[sel];
+                if (e.key.code == Keyboard::Escape) return 0;
+            }
+        }
+        w.clear(Color::Black);
+        w.draw(title);
+        for (int i = 0; i < opt; i++)
+        {
+            m[i].setFillColor(i == sel ? Color::Yellow : Color::White); w.draw(m[i]);
+        }
+        w.display();
+    }
+    return 0;
+}
+
 ////////////////////////////// MATCH MAKING/ GAME ROOM //////////////////////////////////////
 
+// Owns the room server; matches found here are played in one of its rooms.
 class GameRoomManager {
+    RoomServer server;
+
+    static RoomServerConfig serverConfig() {
+        RoomServerConfig cfg;
+        unsigned hw = thread::hardware_concurrency();
+        cfg.workers = hw > 1 ? hw - 1 : 1;   // leave a core for the render loop
+        return cfg;
+    }
+
 public:
+    GameRoomManager() : server(serverConfig()) {}
+
     void attemptMatch(
         RenderWindow& window,
         Sprite& sTile,
         Sprite& sEnemy,
-        Font& font
+        Font& font,
+        const std::string& user
     ) {
-        auto match = runMatchmaking("leaderboard.txt");
-        const auto& p1 = match.first;
-        const auto& p2 = match.second;
-
-        if (p1.name.empty() || p2.name.empty()) {
+        MatchResult match;
+        if (!runMatchmaking(user, match)) {
+            // nobody to play: a bot takes the second seat. Practice only, so
+            // the leaderboard and the queue are left alone.
+            int depth = selectBotDifficulty(window, font);
+            if (depth > 0) runMultiplayerMode(window, sTile, sEnemy, font, server, 2, 1, depth);
             return;
         }
+        const auto& p1 = match.a;
+        const auto& p2 = match.b;
 
-        runMultiplayerMode(window, sTile, sEnemy, font);
+        runMultiplayerMode(window, sTile, sEnemy, font, server);
 
         gLeader.add(p1.name.c_str(), p1.score);
         gLeader.add(p2.name.c_str(), p2.score);
         gLeader.save("leaderboard.txt");
 
+        // both players are available again once the game is over
+        gMatchmaker.enqueue(p1.name, p1.score, matchNow());
+        gMatchmaker.enqueue(p2.name, p2.score, matchNow());
 
     }
+
+    // Local party game: every player sits at this keyboard, nobody is matched.
+    void hostParty(RenderWindow& window, Sprite& sTile, Sprite& sEnemy, Font& font, int players) {
+        runMultiplayerMode(window, sTile, sEnemy, font, server, players);
+    }
 };
 
-GameRoomManager roomMgr;
 
+/////////////////////// THEME PICKER ////////////////////////
+
+// Type to filter the catalog by name prefix, Up/Down to move, Enter to pick.
+// An empty query lists themes in ID order. The saved theme starts highlighted.
+Theme showThemeScreen(RenderWindow& w, Font& f, const ThemeCatalog& catalog, int preselectID) {
+    const int rows = 8;
+    Text title("Choose a Theme", f, 30);
+    title.setFillColor(Color::Yellow);
+    title.setPosition(200, 20);
+    Text search("", f, 22), hint("", f, 16), desc("", f, 18);
+    search.setPosition(200, 70);
+    hint.setFillColor(Color(150, 150, 150)); hint.setPosition(200, 100);
+    desc.setFillColor(Color::Cyan); desc.setPosition(200, 130 + rows * 30 + 10);
+    Text lines[rows];
+    for (int i = 0; i < rows; ++i) {
+        lines[i].setFont(f);
+        lines[i].setCharacterSize(22);
+        lines[i].setPosition(220, 130 + i * 30);
+    }
 
-Theme selectTheme(AVLNode* root) {
-    std::cout << "\nAvailable Themes:\n";
-    inorderPrint(root);  // List ID and name
+    string query;
+    vector<const Theme*> results;
+    size_t totalMatches = 0;
+    int sel = 0;
+    bool dirty = true;
+
+    const Theme* fallback = catalog.findByID(preselectID);
+    if (!fallback && !catalog.themes().empty()) fallback = &catalog.themes().begin()->second;
 
-    int choice = 0;
-    AVLNode* node = nullptr;
-    do {
-        std::cout << "Enter theme ID to select: ";
-        std::cin >> choice;
-        node = findByID(root, choice);
-        if (!node) {
-            std::cout << "Invalid ID. Please try again.\n";
+    while (w.isOpen()) {
+        Event e;
+        while (w.pollEvent(e)) {
+            if (e.type == Event::Closed) { w.close(); break; }
+            if (e.type == Event::TextEntered) {
+                char c = (char)e.text.unicode;
+                if (c >= 32 && c < 127) { query.push_back(c); dirty = true; }
+            }
+            else if (e.type == Event::KeyPressed) {
+                if (e.key.code == Keyboard::Backspace && !query.empty()) { query.pop_back(); dirty = true; }
+                else if (e.key.code == Keyboard::Up && !results.empty()) sel = (sel - 1 + (int)results.size()) % (int)results.size();
+                else if (e.key.code == Keyboard::Down && !results.empty()) sel = (sel + 1) % (int)results.size();
+                else if (e.key.code == Keyboard::Enter && !results.empty()) return *results[sel];
+            }
         }
-    } while (!node);
 
-    std::cout << "Selected Theme: "
-        << node->data.name << " ("
-        << node->data.description << ")\n\n";
-    return node->data;
+        if (dirty) {
+            dirty = false;
+            results.clear();
+            sel = 0;
+            if (query.empty()) {
+                for (const auto& kv : catalog.themes()) {
+                    if (&kv.second == fallback) sel = (int)results.size();
+                    results.push_back(&kv.second);
+                }
+                totalMatches = results.size();
+            }
+            else {
+                totalMatches = catalog.prefixSearch(query, 64, results);
+            }
+        }
+
+        // scroll so the highlighted row is visible
+        int first = sel < rows ? 0 : sel - rows + 1;
+        search.setString("Search: " + query + "_");
+        hint.setString(to_string(totalMatches) + " match(es)   Up/Down  Enter=select");
+        desc.setString(results.empty() ? "No theme starts with that name" : results[sel]->description);
+
+        w.clear(Color::Black);
+        w.draw(title); w.draw(search); w.draw(hint); w.draw(desc);
+        for (int i = 0; i < rows && first + i < (int)results.size(); ++i) {
+            const Theme* t = results[first + i];
+            lines[i].setString(to_string(t->id) + "  " + t->name);
+            lines[i].setFillColor(first + i == sel ? Color::Yellow : Color::White);
+            w.draw(lines[i]);
+        }
+        w.display();
+    }
+    return fallback ? *fallback : Theme();
 }
 
+/////////////////////// RENDER BENCH ////////////////////////
+
+// Xonix --render-bench [--frames F] [--rows R] [--cols C] [--enemies E] [--fill PCT] [--no-hud]
+//                     [--alloc-check] [--assets DIR]
+//
+// Draws scripted single-player frames with the game's own draw functions into
+// an offscreen RenderTexture, with no vsync or frame limit, and reports frames
+// per second and draw calls per frame. The script walls in the left fill% of
+// the board, grows a trail down the open part a cell every few frames, bounces
+// the enemies around the open part and bumps the score, so every frame changes
+// the way a played one does. The clock stops after a readback of the last
+// frame, so work still queued on the GPU is counted.
+// Without a GPU, run it on a software GL driver: Mesa's opengl32.dll
+// (llvmpipe) next to the exe on Windows, or LIBGL_ALWAYS_SOFTWARE=1 under
+// xvfb-run on Linux.
+// --alloc-check (debug builds, see AllocTracker.h) also counts the heap
+// allocations of every timed frame, prints the call stacks behind them and
+// exits with 3 if there were any, so a test can require a zero-allocation loop.
+// Art and font are looked up under --assets DIR (holding sprites/ and fonts/),
+// then the project's own folders relative to Xonix/, then the game's paths.
+int runRenderBench(int argc, char** argv) {
+    int frames = 2000, rows = M, cols = N, enemyCount = 4, fill = 30;
+    bool withHud = true, allocCheck = false;
+    vector<string> assetRoots;
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        if (a == "--no-hud") withHud = false;
+        else if (a == "--assets" && i + 1 < argc) assetRoots.push_back(argv[++i]);
+        else if (a == "--alloc-check") allocCheck = true;
+        else if (a == "--frames" && i + 1 < argc) frames = max(1, atoi(argv[++i]));
+        else if (a == "--rows" && i + 1 < argc) rows = clamp(atoi(argv[++i]), 3, 2000);
+        else if (a == "--cols" && i + 1 < argc) cols = clamp(atoi(argv[++i]), 3, 2000);
+        else if (a == "--enemies" && i + 1 < argc) enemyCount = clamp(atoi(argv[++i]), 0, 100000);
+        else if (a == "--fill" && i + 1 < argc) fill = clamp(atoi(argv[++i]), 0, 90);
+        else { cerr << "render bench: unknown option " << a << "\n"; return 2; }
+    }
+    if (allocCheck && !XONIX_ALLOC_TRACK) {
+        cerr << "render bench: --alloc-check needs a build with XONIX_ALLOC_TRACK=1 (any debug build)\n";
+        return 2;
+    }
+    const int width = cols * ts + (withHud ? 200 : 0), height = rows * ts;
+    if (width > (int)Texture::getMaximumSize() || height > (int)Texture::getMaximumSize()) {
+        cerr << "render bench: " << width << "x" << height << " is over this GPU's texture limit of "
+            << Texture::getMaximumSize() << "\n";
+        return 1;
+    }
+    RenderTexture target;
+    if (!target.create(width, height)) {
+        cerr << "render bench: cannot create a " << width << "x" << height << " offscreen target (no OpenGL?)\n";
+        return 1;
+    }
+
+    // the game's art when it is there, flat stand-ins when it is not; the draw calls are the same
+    assetRoots.push_back("..");
+    assetRoots.push_back("C:/Users/yahya/OneDrive/Desktop/Xonix DS project");
+    auto loadAsset = [&](auto& res, const char* rel) {
+        for (const string& root : assetRoots)
+            if (res.loadFromFile(root + "/" + rel)) return true;
+        return false;
+    };
+    Image tilesImg, enemyImg;
+    if (!loadAsset(tilesImg, "sprites/tiles.png"))
+        tilesImg.create(ThemeAtlas::TRAIL_X + ts, ts, Color(90, 90, 220));
+    if (!loadAsset(enemyImg, "sprites/enemy.png"))
+        enemyImg.create(40, 40, Color::White);
+    ThemeCatalog stockOnly;
+    if (!gAtlas.build(tilesImg, enemyImg, stockOnly, "atlas_cache")) {
+        cerr << "render bench: cannot upload the sprite atlas\n";
+        return 1;
+    }
+    Sprite sTile(gAtlas.getTexture()), sEnemy(gAtlas.getTexture());
+    sEnemy.setTextureRect(gAtlas.enemyRect()); sEnemy.setOrigin(20, 20);
+    Font font;
+    if (withHud && !loadAsset(font, "fonts/Roboto_Condensed-Bold.ttf") && !font.loadFromFile("Roboto_Condensed-Bold.ttf")) {
+        cerr << "render bench: font not found (try --assets DIR), the HUD cannot be measured\n";
+        return 1;
+    }
+    SideHud hud(font, cols * ts, rows * ts);
+
+    vector<int> cells(rows * cols);
+    const int wallCols = (cols - 2) * fill / 100;
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < cols; j++)
+            cells[i * cols + j] = (i == 0 || j == 0 || i == rows - 1 || j == cols - 1 || j <= wallCols) ? 1 : 0;
+    const int openLeft = (wallCols + 1) * ts, openRight = (cols - 1) * ts, openTop = ts, openBottom = (rows - 1) * ts;
+    mt19937 rng(7);
+    vector<Enemy> enemies(enemyCount);
+    for (Enemy& e : enemies) {
+        e.x = openLeft + ts / 2 + (int)(rng() % max(1, openRight - openLeft - ts));
+        e.y = openTop + ts / 2 + (int)(rng() % max(1, openBottom - openTop - ts));
+        e.dx = 1 + (int)(rng() % 4); e.dy = 1 + (int)(rng() % 4);
+        if (rng() & 1) e.dx = -e.dx;
+        if (rng() & 1) e.dy = -e.dy;
+    }
+    int trailCol = wallCols + 1, trailRow = 0, score = 0;
+
+    const int warmup = 60;
+    vector<float> frameMs;
+    frameMs.reserve(frames);
+    long long boardCalls = 0, spriteCalls = 0, hudCalls = 0;
+    int minCalls = INT_MAX, maxCalls = 0;
+    uint64_t allocs = 0, allocBytes = 0;
+    int allocFrames = 0;
+    Clock total, frameClock;
+    for (int f = -warmup; f < frames; ++f) {
+        if (f == 0) {
+            total.restart();
+            AllocTracker::clearSites();
+            AllocTracker::record(allocCheck);
+        }
+        frameClock.restart();
+        const uint64_t allocMark = AllocTracker::count(), byteMark = AllocTracker::bytes();
+
+        // script: the trail walks down one column, then clears and starts on the next
+        if ((f & 3) == 0) {
+            if (++trailRow >= rows - 1) {
+                for (int i = 1; i < rows - 1; i++) cells[i * cols + trailCol] = 0;
+                trailCol = trailCol + 1 < cols - 1 ? trailCol + 1 : wallCols + 1;
+                trailRow = 1;
+            }
+            if (trailCol < cols - 1) cells[trailRow * cols + trailCol] = 2;
+            score += 10;
+        }
+        for (Enemy& e : enemies) {
+            e.x += e.dx; if (e.x < openLeft || e.x >= openRight) { e.dx = -e.dx; e.x += 2 * e.dx; }
+            e.y += e.dy; if (e.y < openTop || e.y >= openBottom) { e.dy = -e.dy; e.y += 2 * e.dy; }
+        }
+
+        target.clear();
+        int b = withBoardDims(rows, cols, [&](auto dims) { return drawBoard(target, sTile, cells.data(), dims); });
+        int sp = drawSprites(target, sTile, sEnemy, trailCol, trailRow, enemies.data(), enemyCount, enemyCount);
+        int h = withHud ? hud.draw(target, score, 3) : 0;
+        target.display();
+        const uint64_t frameAllocs = AllocTracker::count() - allocMark;
+
+        if (f < 0) continue;
+        allocs += frameAllocs;
+        allocBytes += AllocTracker::bytes() - byteMark;
+        allocFrames += frameAllocs != 0;
+        frameMs.push_back(frameClock.getElapsedTime().asMicroseconds() / 1000.f);
+        boardCalls += b; spriteCalls += sp; hudCalls += h;
+        minCalls = min(minCalls, b + sp + h);
+        maxCalls = max(maxCalls, b + sp + h);
+    }
+    AllocTracker::record(false);
+    target.getTexture().copyToImage();   // waits for the GPU to finish the last frame
+    double seconds = total.getElapsedTime().asSeconds();
+
+    sort(frameMs.begin(), frameMs.end());
+    auto pct = [&](double q) { return frameMs[(size_t)(q * (frameMs.size() - 1))]; };
+    printf("render bench: %d frames, board %dx%d, %d enemies, fill %d%%, HUD %s, target %dx%d\n",
+        frames, rows, cols, enemyCount, fill, withHud ? "on" : "off", width, height);
+    printf("  fps          %.1f\n", frames / max(seconds, 1e-9));
+    printf("  frame ms     p50 %.3f  p99 %.3f  max %.3f  (CPU submit; fps includes the GPU)\n",
+        pct(0.5), pct(0.99), frameMs.back());
+    printf("  draw calls   avg %.1f  min %d  max %d  (board %.1f, sprites %.1f, hud %.1f)\n",
+        (boardCalls + spriteCalls + hudCalls) / (double)frames, minCalls, maxCalls,
+        boardCalls / (double)frames, spriteCalls / (double)frames, hudCalls / (double)frames);
+    if (!allocCheck) return 0;
+    printf("  heap allocs  %llu (%llu bytes) in %d of %d frames\n",
+        (unsigned long long)allocs, (unsigned long long)allocBytes, allocFrames, frames);
+    if (allocs == 0) return 0;
+    printf("top allocation sites:\n");
+    fflush(stdout);
+    AllocTracker::report(stdout, 8);
+    return 3;
+}
+
+
 /////////////////////// MAIN ////////////////////////////////
-int main() {
+// XONIX_NO_MAIN leaves main out so bench/xonix_bench.cpp can build this file in.
+#ifndef XONIX_NO_MAIN
+int main(int argc, char** argv) {
     srand(time(0));
+    if (argc > 1 && !strcmp(argv[1], "--render-bench")) return runRenderBench(argc - 1, argv + 1);
+    if (argc > 1 && !strcmp(argv[1], "--compile-levels")) return runLevelCompiler(argc - 1, argv + 1);
 
     // ── INVENTORY MODULE PRELOAD ──
-    AVLNode* themeRoot = nullptr;
-    // Hard‑coded themes (ID, name, description)
+    ThemeCatalog themeCatalog;
+    // Hard‑coded themes (ID, name, description), listed in ID order
+    // Palettes tint wall, player, trail, enemy (see ThemePalette).
     Theme themes[] = {
         Theme(1, "Classic Blue",   "Default blue color scheme"),
-        Theme(2, "Retro Green",    "Old‑school green look"),
-        Theme(3, "Neon Nights",    "Bright neon highlights"),
-        Theme(4, "Monochrome",     "Black & white minimal"),
-        Theme(5, "Solar Flare",    "Orange & yellow sunset"),
-        Theme(6, "Cyberpunk",      "Futuristic purple neon"),
-        Theme(7, "Forest Whisper", "Earthy green and brown")
+        Theme(2, "Retro Green",    "Old‑school green look",
+            ThemePalette(Color(40, 170, 60), Color(200, 255, 200), Color(120, 255, 120), Color(90, 220, 90))),
+        Theme(3, "Neon Nights",    "Bright neon highlights",
+            ThemePalette(Color(255, 40, 200), Color(255, 255, 60), Color(40, 255, 255), Color(255, 90, 255))),
+        Theme(4, "Monochrome",     "Black & white minimal",
+            ThemePalette(Color(170, 170, 170), Color(255, 255, 255), Color(230, 230, 230), Color(120, 120, 120))),
+        Theme(5, "Solar Flare",    "Orange & yellow sunset",
+            ThemePalette(Color(255, 120, 20), Color(255, 240, 120), Color(255, 200, 40), Color(255, 70, 30))),
+        Theme(6, "Cyberpunk",      "Futuristic purple neon",
+            ThemePalette(Color(140, 50, 255), Color(0, 255, 220), Color(255, 60, 200), Color(200, 120, 255))),
+        Theme(7, "Forest Whisper", "Earthy green and brown",
+            ThemePalette(Color(110, 80, 40), Color(220, 240, 160), Color(90, 160, 70), Color(150, 110, 60)))
     };
     const int themeCount = sizeof(themes) / sizeof(themes[0]);
-    for (int i = 0; i < themeCount; ++i) {
-        themeRoot = insert(themeRoot, themes[i]);
-    }
+    themeCatalog.assignSorted(themes, themes + themeCount);
 
     RenderWindow window(VideoMode(N * ts + 200, M * ts), "Xonix Game + Leaderboard");
     window.setFramerateLimit(60);
-    Texture t1, t2, t3;
-    t1.loadFromFile("C:/Users/yahya/OneDrive/Desktop/Xonix DS project/sprites/tiles.png");
+    Texture t2;
+    Image tilesImg, enemyImg;
+    tilesImg.loadFromFile("C:/Users/yahya/OneDrive/Desktop/Xonix DS project/sprites/tiles.png");
     t2.loadFromFile("C:/Users/yahya/OneDrive/Desktop/Xonix DS project/sprites/gameover.png");
-    t3.loadFromFile("C:/Users/yahya/OneDrive/Desktop/Xonix DS project/sprites/enemy.png");
-    Sprite sTile(t1), sGameover(t2), sEnemy(t3); sEnemy.setOrigin(20, 20);
+    enemyImg.loadFromFile("C:/Users/yahya/OneDrive/Desktop/Xonix DS project/sprites/enemy.png");
+    // bake every theme's sprites up front so picking one is just a rect offset
+    gAtlas.build(tilesImg, enemyImg, themeCatalog, "atlas_cache");
+    Sprite sTile(gAtlas.getTexture()), sGameover(t2), sEnemy(gAtlas.getTexture());
+    sEnemy.setTextureRect(gAtlas.enemyRect()); sEnemy.setOrigin(20, 20);
     Font font; font.loadFromFile("C:/Users/yahya/OneDrive/Desktop/Xonix DS project/fonts/Roboto_Condensed-Bold.ttf");
 
     string user;
     if (!showAuthScreen(window, font, user)) return 0;
     gLeader.load("leaderboard.txt");
+    seedMatchmaker("leaderboard.txt");
+    gPrefs.load("user_themes.txt");
+    loadLevels("levels.xlp");
+    KeyBindings keys = loadKeyBindings(user);
 
-    // Load any previously saved theme
+    // Let player pick a theme; the previously saved one starts highlighted
     int savedID = loadPlayerTheme(user);
-
-    // Let player choose a theme
-    Theme playerTheme = selectTheme(themeRoot);
-
-    //  Theme playerTheme;
-    if (savedID != 0) {
-        AVLNode* savedNode = findByID(themeRoot, savedID);
-        if (savedNode) {
-            playerTheme = savedNode->data;
-            std::cout << "Loaded saved theme: " << playerTheme.name << "\n";
-        }
-        else {
-            // Fallback if ID not found
-            playerTheme = selectTheme(themeRoot);
-        }
-    }
-    else {
-        // No saved theme; prompt user
-        playerTheme = selectTheme(themeRoot);
-    }
-    // Now save (or re‑save) their choice
-    // (You can now store or apply playerTheme as needed)
-
-    // ────────────────────────────────
+    Theme playerTheme = showThemeScreen(window, font, themeCatalog, savedID);
+    if (!window.isOpen()) return 0;
+    gAtlas.setTheme(playerTheme.id);
+    sEnemy.setTextureRect(gAtlas.enemyRect());
 
     // After theme selection
     savePlayerTheme(user, playerTheme.id);
@@ -1622,17 +3008,32 @@ int main() {
         case 0: {
             int mode = selectGameMode(window, font);
             if (mode == 0) {
-                int level = selectLevel(window, font); // 0 = Level 1, 1 = Level 2
-                int sc = runSinglePlayerMode(window, sTile, sEnemy, font, level);
-                lastScore = sc;
-                gLeader.add(user.c_str(), sc);
-                gLeader.save("leaderboard.txt");
+                int level = selectLevel(window, font, gLevels, gPrefs.getInt(user, "level", 0)); // index into the pack
+                LevelView view;
+                if (level >= 0 && gLevels.level(level, view)) {
+                    gPrefs.setInt(user, "level", level);
+                    int sc = runSinglePlayerMode(window, sTile, sEnemy, font, view, gLevels.info(level).name, keys);
+                    lastScore = sc;
+                    gLeader.add(user.c_str(), sc);
+                    gLeader.save("leaderboard.txt");
+                }
             }
 
-            else {
-                g_matchQueue.enqueue(new Player(user, lastScore));
+            else if (mode == 1) {
+                requestMatch(user, lastScore);
 
-                roomMgr.attemptMatch(window, sTile, sEnemy, font);
+                roomMgr.attemptMatch(window, sTile, sEnemy, font, user);
+            }
+            else if (mode == 2) {
+                int players = selectPlayerCount(window, font);
+                roomMgr.hostParty(window, sTile, sEnemy, font, players);
+            }
+            else if (mode == 3) runNetworkMode(window, sTile, sEnemy, font);
+            else {
+                int sc = runEventMapMode(window, sTile, sEnemy, font, keys);
+                lastScore = sc;
+                gLeader.add(user.c_str(), sc);
+                gLeader.save("leaderboard.txt");
             }
             break;
         }
@@ -1656,4 +3057,5 @@ int main() {
         }
     }
     return 0;
-}
\ No newline at end of file
+}
+#endif
@@ -0,0 +1,96 @@
+// AvlMap vs std::map microbenchmark.
+// Header-only, no SFML needed:  g++ -O2 -std=c++14 -I.. avl_bench.cpp -o avl_bench
+// Usage: avl_bench [n]   (default runs n = 1000, 100000, 1000000)
+
+#include "AvlMap.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <vector>
+
+static double nowMs() {
+    using namespace std::chrono;
+    return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+}
+
+static volatile long long gSink;   // keeps lookups from being optimised away
+
+struct Timings { double insert, find, iterate, erase, bulk; };
+
+template<typename Map, typename Insert, typename Find, typename Erase, typename Bulk>
+Timings runOps(const std::vector<int>& keys, const std::vector<int>& probes,
+    const std::vector<std::pair<int, int>>& sorted, Insert ins, Find fnd, Erase ers, Bulk bulk) {
+    Timings t;
+    Map m;
+    double t0 = nowMs();
+    for (int k : keys) ins(m, k);
+    t.insert = nowMs() - t0;
+
+    long long hits = 0;
+    t0 = nowMs();
+    for (int k : probes) hits += fnd(m, k);
+    t.find = nowMs() - t0;
+
+    long long sum = 0;
+    t0 = nowMs();
+    for (const auto& kv : m) sum += kv.second;
+    t.iterate = nowMs() - t0;
+
+    t0 = nowMs();
+    for (int k : keys) ers(m, k);
+    t.erase = nowMs() - t0;
+
+    Map b;
+    t0 = nowMs();
+    bulk(b, sorted);
+    t.bulk = nowMs() - t0;
+
+    gSink = hits + sum + (long long)b.size();
+    return t;
+}
+
+static void benchSize(int n) {
+    std::mt19937 rng(12345);
+    std::vector<int> keys(n);
+    for (int i = 0; i < n; ++i) keys[i] = i * 2;
+    std::shuffle(keys.begin(), keys.end(), rng);
+    std::vector<int> probes(n);
+    for (int i = 0; i < n; ++i) probes[i] = (int)(rng() % (unsigned)(2 * n));   // ~50% hits
+    std::vector<std::pair<int, int>> sorted(n);
+    for (int i = 0; i < n; ++i) sorted[i] = std::make_pair(i * 2, i);
+
+    typedef AvlMap<int, int> Avl;
+    typedef std::map<int, int> Std;
+
+    Timings a = runOps<Avl>(keys, probes, sorted,
+        [](Avl& m, int k) { m.insert(k, k); },
+        [](Avl& m, int k) { return m.contains(k) ? 1 : 0; },
+        [](Avl& m, int k) { m.erase(k); },
+        [](Avl& m, const std::vector<std::pair<int, int>>& s) { m.assignSorted(s.begin(), s.end()); });
+    Timings s = runOps<Std>(keys, probes, sorted,
+        [](Std& m, int k) { m.emplace(k, k); },
+        [](Std& m, int k) { return m.count(k) ? 1 : 0; },
+        [](Std& m, int k) { m.erase(k); },
+        [](Std& m, const std::vector<std::pair<int, int>>& v) { m.insert(v.begin(), v.end()); });
+
+    std::printf("n = %d\n", n);
+    std::printf("  %-10s %12s %12s %8s\n", "op", "AvlMap ms", "std::map ms", "ratio");
+    const char* names[] = { "insert", "find", "iterate", "erase", "bulk" };
+    double av[] = { a.insert, a.find, a.iterate, a.erase, a.bulk };
+    double sv[] = { s.insert, s.find, s.iterate, s.erase, s.bulk };
+    for (int i = 0; i < 5; ++i)
+        std::printf("  %-10s %12.3f %12.3f %8.2f\n", names[i], av[i], sv[i], av[i] > 0 ? sv[i] / av[i] : 0.0);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        benchSize(std::atoi(argv[1]));
+        return 0;
+    }
+    const int sizes[] = { 1000, 100000, 1000000 };
+    for (int n : sizes) benchSize(n);
+    return 0;
+}
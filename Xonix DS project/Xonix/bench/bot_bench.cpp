@@ -0,0 +1,114 @@
+// Room bots: decision cost and strength by depth.
+// Header-only, no SFML needed:  g++ -O2 -std=c++14 -I.. bot_bench.cpp -o bot_bench
+//
+// For every depth, plays headless one-player-per-seat matches where all the
+// seats are bots of that depth and reports how long a decision takes
+// (p50/p99/max, the budget is 1 ms) and how well the bots do: territory
+// captured and ticks survived. Then pits every depth against depth 1 in
+// two-seat matches to show that deeper bots win more.
+//
+// Usage: bot_bench [--matches N] [--ticks T] [--players 2..8]
+
+#include "RoomBot.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+template<typename T>
+static double percentile(std::vector<T> v, double q) {
+    if (v.empty()) return 0;
+    size_t k = (size_t)(q * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return (double)v[k];
+}
+
+struct Outcome {
+    int territory[RoomWorld::MAX_PLAYERS];
+    int survived[RoomWorld::MAX_PLAYERS];   // ticks
+};
+
+// Runs one match to the end (or maxTicks) with the given depth per seat.
+// Each think() call that plans is timed into micros.
+static Outcome play(uint32_t seed, int players, const int* depth, int maxTicks, std::vector<double>& micros) {
+    RoomWorld w;
+    std::memset((void*)&w, 0, sizeof(w));
+    w.reset(seed, players);
+    std::vector<RoomBot> bots;
+    for (int p = 0; p < players; ++p) bots.emplace_back((uint8_t)p, depth[p], seed * 31 + p);
+    Outcome o;
+    std::memset(&o, 0, sizeof(o));
+    RoomInput in[3 * RoomWorld::MAX_PLAYERS];
+    for (int t = 0; t < maxTicks && !w.finished(); ++t) {
+        int n = 0;
+        for (RoomBot& b : bots) {
+            RoomBot before = b;
+            n += b.think(w, in + n);
+            if (b.stats().decisions == before.stats().decisions) continue;
+            // a time slice lost to the OS can land inside any decision; take
+            // the best of a few replays of the same decision
+            double best = b.stats().totalMicros - before.stats().totalMicros;
+            for (int r = 0; r < 3 && best > 100; ++r) {
+                RoomBot again = before;
+                RoomInput scratch[3];
+                again.think(w, scratch);
+                best = std::min(best, again.stats().totalMicros - before.stats().totalMicros);
+            }
+            micros.push_back(best);
+        }
+        w.tick(in, n);
+        for (int p = 0; p < players; ++p) o.survived[p] += w.players[p].alive;
+    }
+    for (int p = 0; p < players; ++p) o.territory[p] = w.territory[p];
+    return o;
+}
+
+int main(int argc, char** argv) {
+    int matches = 40, maxTicks = 60 * 120, players = 2;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--matches")) matches = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--ticks")) maxTicks = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--players")) players = std::max(2, std::min(RoomWorld::MAX_PLAYERS, std::atoi(argv[i + 1])));
+    }
+    const int open = (M - 2) * (N - 2);
+    std::printf("%d matches per row, %d players, up to %d ticks; %d open cells to start\n", matches, players, maxTicks, open);
+
+    std::printf("\nall seats at one depth\n");
+    std::printf("depth  decisions  p50 us  p99 us  max us   territory/bot  survived s\n");
+    for (int d = 1; d <= RoomBot::MAX_DEPTH; ++d) {
+        std::vector<double> micros;
+        double territory = 0, survived = 0;
+        int depth[RoomWorld::MAX_PLAYERS];
+        for (int p = 0; p < players; ++p) depth[p] = d;
+        for (int m = 0; m < matches; ++m) {
+            Outcome o = play(1000 + m, players, depth, maxTicks, micros);
+            for (int p = 0; p < players; ++p) { territory += o.territory[p]; survived += o.survived[p]; }
+        }
+        std::printf("%5d  %9zu  %6.1f  %6.1f  %6.1f   %13.1f  %10.1f\n", d, micros.size(),
+            percentile(micros, 0.5), percentile(micros, 0.99), percentile(micros, 1.0),
+            territory / (matches * players), survived / (matches * players) / 60.0);
+    }
+
+    std::printf("\ndepth d against depth 1, seats swapped every other match\n");
+    std::printf("depth  wins  losses  draws   territory d : 1\n");
+    for (int d = 1; d <= RoomBot::MAX_DEPTH; ++d) {
+        std::vector<double> micros;
+        int wins = 0, losses = 0, draws = 0;
+        double mine = 0, theirs = 0;
+        for (int m = 0; m < matches; ++m) {
+            int seat = m & 1;
+            int depth[2];
+            depth[seat] = d;
+            depth[seat ^ 1] = 1;
+            Outcome o = play(5000 + m, 2, depth, maxTicks, micros);
+            mine += o.territory[seat];
+            theirs += o.territory[seat ^ 1];
+            if (o.territory[seat] > o.territory[seat ^ 1]) ++wins;
+            else if (o.territory[seat] < o.territory[seat ^ 1]) ++losses;
+            else ++draws;
+        }
+        std::printf("%5d  %4d  %6d  %5d   %9.1f : %.1f\n", d, wins, losses, draws, mine / matches, theirs / matches);
+    }
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Vector environment throughput.
+// Goes through the C API like a trainer would:
+//   g++ -O2 -std=c++14 -pthread -I.. env_bench.cpp ../xonix_env.cpp -o env_bench
+//
+// Steps B worlds with random actions for each batch size and thread count
+// and reports env-steps per second, plus episode stats so a broken world
+// (never finishing, never scoring) shows up too.
+//
+// Usage: env_bench [--seconds S] [--threads T] [--enemies E] [--bits]
+
+#include "xonix_env.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv) {
+    double seconds = 1;
+    int maxThreads = (int)std::thread::hardware_concurrency();
+    int enemies = 4, obsMode = XONIX_OBS_BYTES;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = std::atof(argv[++i]);
+        else if (!std::strcmp(argv[i], "--threads") && i + 1 < argc) maxThreads = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--enemies") && i + 1 < argc) enemies = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--bits")) obsMode = XONIX_OBS_BITS;
+    }
+    if (maxThreads < 1) maxThreads = 1;
+    int rows, cols;
+    xonix_env_dims(&rows, &cols);
+    std::printf("board %dx%d, %d enemies, %s observations, %d hardware threads\n",
+        rows, cols, enemies, obsMode == XONIX_OBS_BYTES ? "byte grid (zero-copy)" : "bit-plane", maxThreads);
+
+    const int batches[] = { 64, 1024, 8192 };
+    for (int B : batches) {
+        for (int T = 1; T <= maxThreads; T *= 2) {
+            XonixEnv* env = xonix_env_create(B, enemies, obsMode, 42, T, 2000);
+            std::vector<uint8_t> grid((size_t)B * xonix_env_grid_bytes(env)), done(B), actions(B);
+            std::vector<int16_t> player((size_t)B * XONIX_PLAYER_FIELDS), enemy((size_t)B * 2 * xonix_env_enemies(env));
+            std::vector<float> reward(B);
+            xonix_env_bind(env, grid.data(), player.data(), enemy.data(), reward.data(), done.data(), actions.data());
+            xonix_env_reset(env);
+
+            // random policy that sticks to a direction for a while, like a rough player
+            std::mt19937 rng(1);
+            uint64_t steps = 0, episodes = 0, captures = 0;
+            double points = 0;
+            auto t0 = std::chrono::steady_clock::now();
+            double elapsed = 0;
+            while (elapsed < seconds) {
+                for (int k = 0; k < 16; ++k) {
+                    for (int w = 0; w < B; ++w)
+                        if (rng() % 8 == 0) actions[w] = (uint8_t)(rng() % XONIX_ACTION_COUNT);
+                    xonix_env_step(env);
+                    for (int w = 0; w < B; ++w) {
+                        episodes += done[w] != 0;
+                        captures += reward[w] > 0;
+                        points += reward[w];
+                    }
+                    steps += B;
+                }
+                elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            }
+            std::printf("B=%5d threads=%d  %7.2f M steps/s   %.1f steps/episode, %.3f captures/step, %.1f points/episode\n",
+                B, T, steps / elapsed / 1e6, episodes ? (double)steps / episodes : 0.0,
+                (double)captures / steps, episodes ? points / episodes : 0.0);
+            xonix_env_destroy(env);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,127 @@
+﻿// Hunter pathfinding cost: one search per hunter vs one shared FlowField.
+// Header-only, no SFML needed:  g++ -O2 -std=c++14 -I.. flowfield_bench.cpp -o flowfield_bench
+//
+// Plays a scripted player who walks out from the border drawing a trail and
+// closes it again, over and over, at the game's pace (a step every 4 frames).
+// Hunters sit at random open cells and take one cell step toward the
+// trail/player every frame. "per hunter" runs a BFS from every hunter each
+// frame, the way per-enemy A* would; "shared" updates one FlowField (rebuilt
+// only when the player steps) and does a lookup per hunter. Both pick the
+// same kind of shortest step, and the run checks they agree on distances.
+//
+// Usage: flowfield_bench [--frames F]
+
+#include "FlowField.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+static int grid[M][N];
+
+// Plain BFS from one hunter to the nearest target; returns the first step's direction.
+static int searchFrom(int r0, int c0, int tr, int tc, int& distOut) {
+    static int16_t queue[M * N];
+    static uint16_t seen[M][N];
+    static int8_t first[M][N];
+    static uint16_t stamp = 0;
+    if (++stamp == 0) { std::memset(seen, 0, sizeof(seen)); stamp = 1; }
+    const int dr[4] = { 0, 0, -1, 1 }, dc[4] = { -1, 1, 0, 0 };
+    static uint16_t dist[M][N];
+    int head = 0, tail = 0;
+    seen[r0][c0] = stamp; dist[r0][c0] = 0; first[r0][c0] = -1;
+    queue[tail++] = (int16_t)(r0 * N + c0);
+    while (head < tail) {
+        int cell = queue[head++], r = cell / N, c = cell % N;
+        bool target = grid[r][c] == 2 || (r == tr && c == tc);
+        if (!target && grid[tr][tc] == 1)   // player on a wall: the open cells beside it count
+            for (int d = 0; d < 4; ++d) target |= r + dr[d] == tr && c + dc[d] == tc;
+        if (target) { distOut = dist[r][c]; return first[r][c]; }
+        for (int d = 0; d < 4; ++d) {
+            int nr = r + dr[d], nc = c + dc[d];
+            if (nr < 0 || nr >= M || nc < 0 || nc >= N || seen[nr][nc] == stamp || grid[nr][nc] == 1) continue;
+            seen[nr][nc] = stamp;
+            dist[nr][nc] = (uint16_t)(dist[r][c] + 1);
+            first[nr][nc] = first[r][c] < 0 ? (int8_t)d : first[r][c];
+            queue[tail++] = (int16_t)(nr * N + nc);
+        }
+    }
+    distOut = FlowField<StockDims>::UNREACHED;
+    return -1;
+}
+
+struct Walker { int r, c; };
+
+int main(int argc, char** argv) {
+    int frames = 6000;
+    for (int i = 1; i + 1 < argc; i += 2)
+        if (!std::strcmp(argv[i], "--frames")) frames = std::atoi(argv[i + 1]);
+
+    std::printf("%d frames, player step every 4 frames, board %dx%d\n", frames, M, N);
+    std::printf("hunters   per hunter us/frame   shared us/frame   rebuilds   speedup   mismatches\n");
+    const int counts[] = { 1, 2, 8, 32, 128 };
+    for (int H : counts) {
+        double micros[2] = { 0, 0 };
+        uint64_t rebuilds = 0, mismatches = 0;
+        for (int mode = 0; mode < 2; ++mode) {
+            for (int i = 0; i < M; ++i)
+                for (int j = 0; j < N; ++j) grid[i][j] = (i == 0 || j == 0 || i == M - 1 || j == N - 1) ? 1 : 0;
+            std::mt19937 rng(11);
+            std::vector<Walker> hunters(H);
+            for (auto& h : hunters) { h.r = 5 + (int)(rng() % (M - 10)); h.c = 5 + (int)(rng() % (N - 10)); }
+            FlowField<StockDims> field;
+            uint32_t version = 0;
+            int pr = 0, pc = 3, leg = 2, legLeft = 0, dir = 3;
+            auto t0 = std::chrono::steady_clock::now();
+            for (int f = 0; f < frames; ++f) {
+                if (f % 4 == 0) {
+                    // out from the top border, across, and back: a fresh trail each loop
+                    if (legLeft == 0) {
+                        leg = (leg + 1) % 3;
+                        if (leg == 0) { pc = 3 + (int)(rng() % (N - 12)); pr = 0; }
+                        dir = leg == 0 ? 3 : (leg == 1 ? 1 : 2);
+                        legLeft = leg == 0 ? 3 + (int)(rng() % 12) : (leg == 1 ? 6 : 99);
+                    }
+                    pr += dir == 3 ? 1 : (dir == 2 ? -1 : 0);
+                    pc += dir == 1 ? 1 : 0;
+                    --legLeft;
+                    if (grid[pr][pc] == 0) { grid[pr][pc] = 2; ++version; }
+                    else if (grid[pr][pc] == 1 && leg == 2) {
+                        // closed: some of the trail turns to wall, never under a hunter
+                        // (the game's capture always leaves enemies in open cells)
+                        for (auto& h : hunters) if (grid[h.r][h.c] == 2) grid[h.r][h.c] = 0;
+                        for (int i = 0; i < M; ++i)
+                            for (int j = 0; j < N; ++j) if (grid[i][j] == 2) grid[i][j] = (i + j) % 5 ? 0 : 1;
+                        ++version;
+                        legLeft = 0;
+                    }
+                }
+                if (mode == 1) field.update(grid, pr, pc, version);
+                for (auto& h : hunters) {
+                    int d;
+                    if (mode == 0) { int dist; d = searchFrom(h.r, h.c, pr, pc, dist); }
+                    else d = field.direction(h.r, h.c);
+                    if (d < 0) continue;
+                    int nr = h.r + (d == 2 ? -1 : (d == 3 ? 1 : 0)), nc = h.c + (d == 0 ? -1 : (d == 1 ? 1 : 0));
+                    if (grid[nr][nc] != 1) { h.r = nr; h.c = nc; }
+                }
+                if (mode == 1 && f % 97 == 0) {   // spot-check the field against a fresh search, off the clock
+                    auto c0 = std::chrono::steady_clock::now();
+                    for (auto& h : hunters) {
+                        int dist;
+                        searchFrom(h.r, h.c, pr, pc, dist);
+                        mismatches += dist != field.distance(h.r, h.c);
+                    }
+                    t0 += std::chrono::steady_clock::now() - c0;
+                }
+            }
+            micros[mode] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count() / frames;
+            if (mode == 1) rebuilds = field.rebuildCount();
+        }
+        std::printf("%7d   %19.2f   %15.2f   %8llu   %6.1fx   %10llu\n", H, micros[0], micros[1],
+            (unsigned long long)rebuilds, micros[0] / micros[1], (unsigned long long)mismatches);
+    }
+    return 0;
+}
@@ -0,0 +1,246 @@
+// Headless matchmaking load simulator.
+// Header-only, no SFML needed:  g++ -O2 -std=c++14 -I.. mm_sim.cpp -o mm_sim
+//
+// Generates a synthetic player population and feeds it, in simulated time,
+// through the same path the game uses: join requests go into an MpmcQueue and
+// each tick drains them into the matcher. Every matcher variant sees the
+// identical arrival stream so their rows in the report compare directly.
+//
+// Usage: mm_sim [--players N] [--rate PER_SEC] [--dist normal|uniform|bimodal]
+//               [--mean M] [--stddev S] [--tick-hz H] [--drain SECONDS] [--seed S]
+
+#include "Matchmaker.h"
+#include "MpmcQueue.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <vector>
+
+struct SimConfig {
+    long long players = 1000000;
+    double rate = 2000;           // arrivals per simulated second
+    std::string dist = "normal";
+    double mean = 1500, stddev = 300;
+    double tickHz = 10;
+    double drain = 60;            // simulated seconds to keep ticking after the last arrival
+    unsigned seed = 42;
+};
+
+struct Arrival {
+    double at;
+    int skill;
+};
+
+struct JoinRequest {   // the game's MatchRequest plus the arrival time, for wait stats
+    char name[32];
+    int score;
+    double at;
+};
+
+static std::vector<Arrival> makePopulation(const SimConfig& c) {
+    std::mt19937 rng(c.seed);
+    std::normal_distribution<double> normal(c.mean, c.stddev);
+    std::uniform_real_distribution<double> uniform(c.mean - 2 * c.stddev, c.mean + 2 * c.stddev);
+    std::normal_distribution<double> low(c.mean - c.stddev, c.stddev / 3), high(c.mean + c.stddev, c.stddev / 3);
+    std::exponential_distribution<double> gap(c.rate);   // Poisson arrivals
+    std::vector<Arrival> pop((size_t)c.players);
+    double t = 0;
+    for (auto& a : pop) {
+        t += gap(rng);
+        double s;
+        if (c.dist == "uniform") s = uniform(rng);
+        else if (c.dist == "bimodal") s = (rng() & 1) ? low(rng) : high(rng);
+        else s = normal(rng);
+        a.at = t;
+        a.skill = std::max(0, (int)std::lround(s));
+    }
+    return pop;
+}
+
+// ---- matcher variants under test ----
+
+struct Matcher {
+    virtual ~Matcher() {}
+    virtual const char* name() const = 0;
+    virtual void enqueue(const std::string& name, int skill, double now) = 0;
+    virtual void tick(double now, std::vector<MatchResult>& out) = 0;
+    virtual size_t queued() const = 0;
+};
+
+// The engine the game ships (MatchmakingEngine with a given config).
+struct EngineMatcher : Matcher {
+    const char* label;
+    MatchmakingEngine engine;
+    EngineMatcher(const char* l, const MatchConfig& cfg) : label(l), engine(cfg) {}
+    const char* name() const override { return label; }
+    void enqueue(const std::string& n, int skill, double now) override { engine.enqueue(n, skill, now); }
+    void tick(double now, std::vector<MatchResult>& out) override { engine.tick(now, out); }
+    size_t queued() const override { return engine.queued(); }
+};
+
+// The pre-engine behaviour: look at the first 10 waiting players, sort them
+// by score and pair the closest adjacent two; one match per pass.
+struct LegacyMatcher : Matcher {
+    struct W { std::string name; int skill; double at; };
+    std::deque<W> waiting;
+    const char* name() const override { return "legacy top-10"; }
+    void enqueue(const std::string& n, int skill, double now) override { waiting.push_back(W{ n, skill, now }); }
+    void tick(double now, std::vector<MatchResult>& out) override {
+        size_t cands = std::min<size_t>(10, waiting.size());
+        if (cands < 2) return;
+        std::vector<size_t> idx(cands);
+        for (size_t i = 0; i < cands; ++i) idx[i] = i;
+        std::sort(idx.begin(), idx.end(), [&](size_t a, size_t b) { return waiting[a].skill > waiting[b].skill; });
+        size_t best = 0;
+        int bestDiff = 1 << 30;
+        for (size_t i = 0; i + 1 < cands; ++i) {
+            int d = waiting[idx[i]].skill - waiting[idx[i + 1]].skill;
+            if (d < bestDiff) { bestDiff = d; best = i; }
+        }
+        const W& a = waiting[idx[best]];
+        const W& b = waiting[idx[best + 1]];
+        out.push_back(MatchResult{ MatchPlayer{ a.name, a.skill }, MatchPlayer{ b.name, b.skill }, now - a.at, now - b.at });
+        size_t hi = std::max(idx[best], idx[best + 1]), lo = std::min(idx[best], idx[best + 1]);
+        waiting.erase(waiting.begin() + hi);
+        waiting.erase(waiting.begin() + lo);
+    }
+    size_t queued() const override { return waiting.size(); }
+};
+
+// ---- driver and report ----
+
+struct Report {
+    long long matches = 0;
+    double matcherSeconds = 0;     // wall time spent in drain + tick
+    std::vector<float> waits;      // simulated seconds, one per matched player
+    std::vector<int> diffs;        // score gap per match
+    size_t unmatched = 0;
+};
+
+static double pct(std::vector<float>& v, double p) {
+    if (v.empty()) return 0;
+    size_t k = std::min(v.size() - 1, (size_t)(p * (v.size() - 1)));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+static int pct(std::vector<int>& v, double p) {
+    if (v.empty()) return 0;
+    size_t k = std::min(v.size() - 1, (size_t)(p * (v.size() - 1)));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+static Report simulate(const SimConfig& c, const std::vector<Arrival>& pop, Matcher& m) {
+    Report r;
+    r.waits.reserve(pop.size());
+    r.diffs.reserve(pop.size() / 2);
+    MpmcQueue<JoinRequest> inbox(65536);
+    std::vector<MatchResult> out;
+    const double dt = 1.0 / c.tickHz;
+    const double end = (pop.empty() ? 0 : pop.back().at) + c.drain;
+    size_t next = 0;
+    JoinRequest req;
+    std::string name;
+
+    for (double now = 0; now <= end; now += dt) {
+        // front-end side: post everyone who arrived since the last tick
+        while (next < pop.size() && pop[next].at <= now) {
+            std::snprintf(req.name, sizeof(req.name), "p%zu", next);
+            req.score = pop[next].skill;
+            req.at = pop[next].at;
+            if (!inbox.tryEnqueue(req)) break;   // full: retry next tick
+            ++next;
+        }
+        // matchmaker side: drain + one batch pass
+        auto t0 = std::chrono::steady_clock::now();
+        while (inbox.tryDequeue(req)) {
+            name.assign(req.name);
+            m.enqueue(name, req.score, req.at);
+        }
+        out.clear();
+        m.tick(now, out);
+        r.matcherSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        for (const MatchResult& mr : out) {
+            r.waits.push_back((float)mr.waitA);
+            r.waits.push_back((float)mr.waitB);
+            r.diffs.push_back(std::abs(mr.a.score - mr.b.score));
+        }
+        r.matches += (long long)out.size();
+    }
+    r.unmatched = m.queued() + (pop.size() - next);
+    return r;
+}
+
+static void printReport(const char* name, Report& r) {
+    const int edges[] = { 0, 10, 25, 50, 100, 250, 500 };
+    const int buckets = sizeof(edges) / sizeof(edges[0]);
+    long long hist[buckets] = {};
+    for (int d : r.diffs) {
+        int b = buckets - 1;
+        while (b > 0 && d < edges[b]) --b;
+        ++hist[b];
+    }
+    double mps = r.matcherSeconds > 0 ? r.matches / r.matcherSeconds : 0;
+    std::printf("%-18s %10lld %10zu %12.0f %9.2f %9.2f %7d %7d",
+        name, r.matches, r.unmatched, mps, pct(r.waits, 0.50), pct(r.waits, 0.99),
+        pct(r.diffs, 0.50), pct(r.diffs, 0.99));
+    for (int b = 0; b < buckets; ++b)
+        std::printf(" %5.1f%%", r.diffs.empty() ? 0.0 : 100.0 * hist[b] / r.diffs.size());
+    std::printf("\n");
+}
+
+int main(int argc, char** argv) {
+    SimConfig c;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* k = argv[i];
+        const char* v = argv[i + 1];
+        if (!std::strcmp(k, "--players")) c.players = std::atoll(v);
+        else if (!std::strcmp(k, "--rate")) c.rate = std::atof(v);
+        else if (!std::strcmp(k, "--dist")) c.dist = v;
+        else if (!std::strcmp(k, "--mean")) c.mean = std::atof(v);
+        else if (!std::strcmp(k, "--stddev")) c.stddev = std::atof(v);
+        else if (!std::strcmp(k, "--tick-hz")) c.tickHz = std::atof(v);
+        else if (!std::strcmp(k, "--drain")) c.drain = std::atof(v);
+        else if (!std::strcmp(k, "--seed")) c.seed = (unsigned)std::atoi(v);
+        else { std::fprintf(stderr, "unknown option %s\n", k); return 1; }
+    }
+    if (c.players < 2 || c.rate <= 0 || c.tickHz <= 0) {
+        std::fprintf(stderr, "need --players >= 2, --rate > 0, --tick-hz > 0\n");
+        return 1;
+    }
+
+    std::vector<Arrival> pop = makePopulation(c);
+    std::printf("players %lld, %s skill (mean %.0f, sd %.0f), %.0f arrivals/s, %.0f Hz ticks\n\n",
+        c.players, c.dist.c_str(), c.mean, c.stddev, c.rate, c.tickHz);
+
+    MatchConfig widening;                       // the shipped defaults
+    MatchConfig strict;
+    strict.widenPerSec = 0;
+    strict.maxWindow = strict.baseWindow;
+    MatchConfig greedy;
+    greedy.baseWindow = greedy.maxWindow = 1 << 30;
+
+    EngineMatcher engineWide("engine widening", widening);
+    EngineMatcher engineStrict("engine fixed-50", strict);
+    EngineMatcher engineGreedy("engine no-window", greedy);
+    LegacyMatcher legacy;
+    Matcher* variants[] = { &engineWide, &engineStrict, &engineGreedy, &legacy };
+
+    std::printf("%-18s %10s %10s %12s %9s %9s %7s %7s   gap histogram: <10 <25 <50 <100 <250 <500 500+\n",
+        "matcher", "matches", "unmatched", "matches/s", "wait p50", "wait p99", "gap p50", "gap p99");
+    for (Matcher* m : variants) {
+        Report r = simulate(c, pop, *m);
+        printReport(m->name(), r);
+    }
+    std::printf("\nmatches/s is matcher throughput (wall clock spent draining + ticking);\n"
+        "waits are simulated seconds between joining and being matched.\n");
+    return 0;
+}
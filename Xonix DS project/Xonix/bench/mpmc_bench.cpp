@@ -0,0 +1,104 @@
+// MpmcQueue throughput with 1..32 threads, against a mutex + std::deque baseline.
+// Header-only, no SFML needed:  g++ -O2 -std=c++14 -pthread -I.. mpmc_bench.cpp -o mpmc_bench
+// Usage: mpmc_bench [itemsPerRun]   (default 4,000,000)
+// With T threads, half produce and half consume (T = 1 alternates on one thread).
+
+#include "MpmcQueue.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Item {           // same shape as a matchmaking join request
+    char name[32];
+    int score;
+};
+
+class LockedQueue {
+    std::deque<Item> q;
+    std::mutex m;
+    size_t cap;
+public:
+    explicit LockedQueue(size_t c) : cap(c) {}
+    bool tryEnqueue(const Item& v) {
+        std::lock_guard<std::mutex> l(m);
+        if (q.size() >= cap) return false;
+        q.push_back(v);
+        return true;
+    }
+    bool tryDequeue(Item& out) {
+        std::lock_guard<std::mutex> l(m);
+        if (q.empty()) return false;
+        out = q.front();
+        q.pop_front();
+        return true;
+    }
+};
+
+// Returns millions of items moved through the queue per second.
+template<typename Q>
+double run(Q& q, int threads, long long items) {
+    using clock = std::chrono::steady_clock;
+    Item it = {};
+    if (threads == 1) {
+        auto t0 = clock::now();
+        for (long long i = 0; i < items; ++i) {
+            it.score = (int)i;
+            q.tryEnqueue(it);
+            q.tryDequeue(it);
+        }
+        double s = std::chrono::duration<double>(clock::now() - t0).count();
+        return items / s / 1e6;
+    }
+
+    int producers = threads / 2, consumers = threads - producers;
+    long long perProducer = items / producers;
+    long long total = perProducer * producers;
+    std::atomic<long long> consumed(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> pool;
+    for (int p = 0; p < producers; ++p)
+        pool.emplace_back([&] {
+            Item v = {};
+            while (!go.load()) {}
+            for (long long i = 0; i < perProducer; ++i) {
+                v.score = (int)i;
+                while (!q.tryEnqueue(v)) std::this_thread::yield();
+            }
+        });
+    for (int c = 0; c < consumers; ++c)
+        pool.emplace_back([&] {
+            Item v;
+            while (!go.load()) {}
+            while (consumed.load(std::memory_order_relaxed) < total) {
+                if (q.tryDequeue(v)) consumed.fetch_add(1, std::memory_order_relaxed);
+                else std::this_thread::yield();
+            }
+        });
+    auto t0 = clock::now();
+    go = true;
+    for (auto& t : pool) t.join();
+    double s = std::chrono::duration<double>(clock::now() - t0).count();
+    return total / s / 1e6;
+}
+
+int main(int argc, char** argv) {
+    long long items = argc > 1 ? std::atoll(argv[1]) : 4000000;
+    const size_t capacity = 4096;
+    std::printf("hardware threads: %u, items per run: %lld, capacity: %zu\n",
+        std::thread::hardware_concurrency(), items, capacity);
+    std::printf("%8s %16s %16s\n", "threads", "MpmcQueue Mops", "mutex Mops");
+    const int counts[] = { 1, 2, 4, 8, 16, 32 };
+    for (int t : counts) {
+        MpmcQueue<Item> lf(capacity);
+        LockedQueue lk(capacity);
+        double a = run(lf, t, items);
+        double b = run(lk, t, items);
+        std::printf("%8d %16.2f %16.2f\n", t, a, b);
+    }
+    return 0;
+}
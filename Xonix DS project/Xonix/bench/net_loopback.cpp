@@ -0,0 +1,111 @@
+// Networked room mode over 127.0.0.1.
+// Header-only, no SFML needed:  g++ -O2 -std=c++14 -I.. net_loopback.cpp -o net_loopback
+//
+// Runs a NetServer and one NetClient per seat in a single loop, every client
+// played by a random bot, with the simulated link applied in both directions.
+// Reports snapshot and input bytes per tick, how many snapshots had to fall
+// back to a full (baseline) delta, and the input latency each client saw: the
+// time from an input frame being created to the first snapshot that includes it.
+// Also counts prediction corrections (own predicted position changed when a
+// snapshot arrived).
+//
+// Usage: net_loopback [--loss 0..1] [--latency-ms MS] [--jitter-ms MS] [--seconds S]
+//                     [--players 2..8] [--port P]
+
+#include "NetGame.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+static double percentile(std::vector<float> v, double q) {
+    if (v.empty()) return 0;
+    size_t k = (size_t)(q * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+int main(int argc, char** argv) {
+    NetConfig cfg;
+    cfg.port = 0;
+    cfg.link.loss = 0.05;
+    cfg.link.latency = 0.030;
+    cfg.link.jitter = 0.005;
+    double seconds = 10;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--loss")) cfg.link.loss = std::atof(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--latency-ms")) cfg.link.latency = std::atof(argv[i + 1]) / 1000;
+        else if (!std::strcmp(argv[i], "--jitter-ms")) cfg.link.jitter = std::atof(argv[i + 1]) / 1000;
+        else if (!std::strcmp(argv[i], "--seconds")) seconds = std::atof(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--players")) cfg.players = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--port")) cfg.port = (uint16_t)std::atoi(argv[i + 1]);
+    }
+    if (cfg.players < 2) cfg.players = 2;
+    if (cfg.players > RoomWorld::MAX_PLAYERS) cfg.players = RoomWorld::MAX_PLAYERS;
+
+    NetServer server(cfg);
+    if (!server.open()) { std::printf("cannot bind UDP port %u\n", cfg.port); return 1; }
+    std::vector<std::unique_ptr<NetClient>> clients;
+    for (int p = 0; p < cfg.players; ++p) {
+        NetConfig c = cfg;
+        c.seed = cfg.seed + 100 + p;
+        clients.emplace_back(new NetClient(c));
+        if (!clients.back()->connect(NetAddress::loopback(server.port()))) { std::printf("cannot open client socket\n"); return 1; }
+    }
+
+    std::printf("loopback port %u, %d players, loss %.1f%%, latency %.0f ms +-%.0f ms each way, %.0f s\n",
+        server.port(), cfg.players, cfg.link.loss * 100, cfg.link.latency * 1000, cfg.link.jitter * 1000, seconds);
+
+    std::mt19937 rng(7);
+    const int8_t dirs[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+    std::vector<double> nextTurn(cfg.players, 0);
+    auto t0 = std::chrono::steady_clock::now();
+    auto clock = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count(); };
+    double startedAt = -1;
+    for (double now = clock(); startedAt < 0 || now - startedAt < seconds; now = clock()) {
+        if (startedAt < 0 && server.isStarted()) startedAt = now;
+        if (now > 5 && startedAt < 0) { std::printf("match never started\n"); return 1; }
+        for (int p = 0; p < cfg.players; ++p) {
+            NetClient& c = *clients[p];
+            if (c.getState() == NetClient::PLAYING && now >= nextTurn[p]) {
+                const int8_t* d = dirs[rng() % 4];
+                c.setHeld(d[0], d[1]);
+                c.press(d[0], d[1]);
+                if (rng() % 64 == 0) c.freeze();
+                nextTurn[p] = now + 0.1 + (rng() % 300) / 1000.0;
+            }
+            c.update(now);
+        }
+        server.update(now);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const NetServerStats& ss = server.stats();
+    double perClientTicks = (double)ss.ticks * cfg.players;
+    std::vector<float> latency;
+    uint64_t corrections = 0, frames = 0, inputBytes = 0, undecodable = 0, received = 0;
+    for (auto& c : clients) {
+        const NetClientStats& cs = c->stats();
+        latency.insert(latency.end(), cs.inputLatency.begin(), cs.inputLatency.end());
+        corrections += cs.corrections;
+        frames += cs.framesSent;
+        inputBytes += cs.inputBytes;
+        undecodable += cs.undecodable;
+        received += cs.snapshots;
+    }
+    std::printf("server ticks          %llu (%.1f Hz)\n", (unsigned long long)ss.ticks, ss.ticks / seconds);
+    std::printf("snapshot bytes/tick   %.1f per client (raw world %zu), %.2f%% full, %llu received, %llu undecodable\n",
+        ss.snapshotBytes / perClientTicks, sizeof(RoomWorld), 100.0 * ss.fullSnapshots / ss.snapshots,
+        (unsigned long long)received, (unsigned long long)undecodable);
+    std::printf("input bytes/tick      %.1f per client (%llu frames)\n",
+        frames ? (double)inputBytes / frames : 0.0, (unsigned long long)frames);
+    std::printf("input latency         p50 %.1f ms  p99 %.1f ms  max %.1f ms  (%zu frames confirmed)\n",
+        percentile(latency, 0.5) * 1000, percentile(latency, 0.99) * 1000, percentile(latency, 1.0) * 1000, latency.size());
+    std::printf("corrections           %.2f per client-second\n", corrections / (seconds * cfg.players));
+    return 0;
+}
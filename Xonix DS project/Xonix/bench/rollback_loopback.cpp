@@ -0,0 +1,126 @@
+// Rollback two-player mode over 127.0.0.1.
+// Header-only, no SFML needed:  g++ -O2 -std=c++14 -I.. rollback_loopback.cpp -o rollback_loopback
+//
+// First times the pieces a rollback is made of: a state save/restore and
+// re-simulating 8 and 16 ticks in a row. Then plays a host and a joiner
+// session against each other in one loop, each driven by a random bot, with
+// the simulated link delaying (and optionally dropping) both directions.
+// Reports rollbacks, how deep they went and what they cost per frame, and
+// checks that both peers end on the same world byte for byte once every input
+// has been confirmed.
+//
+// Usage: rollback_loopback [--delay-ms MS] [--jitter-ms MS] [--loss 0..1] [--seconds S]
+//                          [--max-prediction F] [--port P]
+
+#include "Rollback.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+template<typename T>
+static double percentile(std::vector<T> v, double q) {
+    if (v.empty()) return 0;
+    size_t k = (size_t)(q * (v.size() - 1));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return (double)v[k];
+}
+
+// Cost of restoring a saved state and re-simulating depth ticks with random inputs.
+static double resimMicros(int depth) {
+    std::mt19937 rng(3);
+    RollbackState saved, cur;
+    std::memset((void*)&saved, 0, sizeof(saved));
+    saved.world.reset(99, 2);
+    const int reps = 20000;
+    static volatile int sink;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < reps; ++i) {
+        std::memcpy((void*)&cur, &saved, sizeof(cur));
+        for (int t = 0; t < depth; ++t) {
+            RoomInput in[2] = {
+                { 0, (int8_t)((int)(rng() % 3) - 1), 0, RoomInput::HELD },
+                { 1, 0, (int8_t)((int)(rng() % 3) - 1), RoomInput::HELD } };
+            cur.world.tick(in, 2);
+        }
+        sink += cur.world.players[0].x + cur.world.enemies[0].y;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(t1 - t0).count() / reps;
+}
+
+int main(int argc, char** argv) {
+    RollbackConfig host, join;
+    host.port = 0;
+    host.seed = 12345;
+    LinkConditions link;
+    link.latency = 0.050;
+    link.jitter = 0.010;
+    double seconds = 10;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!std::strcmp(argv[i], "--delay-ms")) link.latency = std::atof(argv[i + 1]) / 1000;
+        else if (!std::strcmp(argv[i], "--jitter-ms")) link.jitter = std::atof(argv[i + 1]) / 1000;
+        else if (!std::strcmp(argv[i], "--loss")) link.loss = std::atof(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--seconds")) seconds = std::atof(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--max-prediction")) host.maxPrediction = std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "--port")) host.port = (uint16_t)std::atoi(argv[i + 1]);
+    }
+    host.link = link;
+    join = host;
+    join.host = false;
+
+    std::printf("state size %zu bytes\n", sizeof(RollbackState));
+    std::printf("restore + resim  1 tick %.2f us,  8 ticks %.2f us,  16 ticks %.2f us  (frame budget 16667 us)\n",
+        resimMicros(1), resimMicros(8), resimMicros(16));
+
+    RollbackSession a(host), b(join);
+    if (!a.open(NetAddress()) || !b.open(NetAddress::loopback(a.port()))) { std::printf("cannot open UDP sockets\n"); return 1; }
+    const uint32_t limit = (uint32_t)(seconds * host.tickHz);
+    a.setFrameLimit(limit);
+    b.setFrameLimit(limit);
+    std::printf("loopback port %u, delay %.0f ms +-%.0f ms each way, loss %.1f%%, %u frames\n",
+        a.port(), link.latency * 1000, link.jitter * 1000, link.loss * 100, limit);
+
+    std::mt19937 rng(7);
+    const int8_t dirs[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+    RollbackSession* peers[2] = { &a, &b };
+    double nextTurn[2] = { 0, 0 };
+    auto t0 = std::chrono::steady_clock::now();
+    auto clock = [&]() { return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count(); };
+    for (double now = clock(); !(a.settled() && b.settled()); now = clock()) {
+        if (now > seconds * 3 + 5) { std::printf("peers never settled (frames %u/%u confirmed %u/%u)\n",
+            a.currentFrame(), b.currentFrame(), a.confirmedFrame(), b.confirmedFrame()); return 1; }
+        for (int p = 0; p < 2; ++p) {
+            RollbackSession& s = *peers[p];
+            if (s.getState() == RollbackSession::RUNNING && now >= nextTurn[p]) {
+                const int8_t* d = dirs[rng() % 4];
+                s.setHeld(d[0], d[1]);
+                s.press(d[0], d[1]);
+                if (rng() % 64 == 0) s.freeze();
+                nextTurn[p] = now + 0.1 + (rng() % 300) / 1000.0;
+            }
+            s.update(now);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    bool same = std::memcmp(&a.current(), &b.current(), sizeof(RollbackState)) == 0;
+    for (int p = 0; p < 2; ++p) {
+        const RollbackStats& st = peers[p]->stats();
+        std::printf("%s  frames %llu  rollbacks %llu (%.1f%% of frames)  resim ticks %llu  stalls %llu prediction / %llu sync\n",
+            p ? "joiner" : "host  ", (unsigned long long)st.frames, (unsigned long long)st.rollbacks,
+            100.0 * st.rollbacks / st.frames, (unsigned long long)st.resimTicks,
+            (unsigned long long)st.predictionStalls, (unsigned long long)st.syncStalls);
+        std::printf("        depth p50 %.0f p99 %.0f max %.0f ticks   resim cost p50 %.1f us p99 %.1f us max %.1f us per frame\n",
+            percentile(st.resimDepth, 0.5), percentile(st.resimDepth, 0.99), percentile(st.resimDepth, 1.0),
+            percentile(st.resimMicros, 0.5), percentile(st.resimMicros, 0.99), percentile(st.resimMicros, 1.0));
+        std::printf("        sent %llu packets, %.1f bytes/frame\n",
+            (unsigned long long)st.packetsSent, (double)st.bytesSent / st.frames);
+    }
+    std::printf("final state after frame %u: %s\n", limit, same ? "identical on both peers" : "DESYNC");
+    return same ? 0 : 2;
+}
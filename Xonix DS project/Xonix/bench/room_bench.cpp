@@ -0,0 +1,192 @@
+// Multi-room server capacity benchmark.
+// Header-only, no SFML needed:  g++ -O2 -std=c++14 -pthread -I.. room_bench.cpp -o room_bench
+//
+// Ramps the number of rooms on a RoomServer (doubling each step), with a
+// client attached to every room and a feeder thread playing random inputs and
+// replacing finished matches. For each step it reports the tick rate each
+// room actually achieved, worker utilisation, cost per tick and tick jitter
+// (tick start minus due time). The largest step that holds the target rate
+// with p99 jitter within one tick period of the OS timer's own p99 wake-up
+// error (measured first) gives rooms per core.
+// It then offers four times that many rooms with and without admission control to
+// show what overload does to jitter.
+//
+// Usage: room_bench [--workers W] [--hz HZ] [--seconds S] [--start ROOMS] [--max-rooms ROOMS]
+//                   [--players 2..8] [--bots B] [--bot-depth 1..8]
+//
+// --bots gives each room B bot seats (the last ones), played on the workers
+// inside the room's tick, so the cost per tick includes their thinking.
+
+#include "RoomServer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <thread>
+#include <vector>
+
+struct BenchConfig {
+    unsigned workers = std::thread::hardware_concurrency() ? std::thread::hardware_concurrency() : 1;
+    double hz = 60;
+    double seconds = 3;
+    size_t start = 250;
+    size_t maxRooms = 256000;
+    int players = 2;
+    int bots = 0, botDepth = 4;
+};
+
+struct Row {
+    size_t offered, admitted;
+    double ratePerRoom;
+    RoomServerStats st;
+};
+
+// Plays random inputs into every room and swaps finished matches for new ones
+// until stop is set.
+static void feed(RoomServer& server, std::vector<uint32_t>& ids, std::vector<RoomClient>& clients,
+    const std::atomic<bool>& stop, unsigned seed, int players, int bots, int botDepth) {
+    std::mt19937 rng(seed);
+    const int8_t dirs[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+    RoomWorld view;
+    const double passSeconds = 0.25;   // every room gets an input and a check four times a second
+    while (!stop.load()) {
+        auto passStart = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < ids.size() && !stop.load(); ++i) {
+            if (!clients[i].valid()) continue;
+            clients[i].read(view);
+            if (view.finished()) {
+                server.closeRoom(ids[i]);
+                clients[i] = RoomClient();
+                uint32_t id = server.createRoom(rng(), players, bots, botDepth);
+                if (id) { ids[i] = id; clients[i] = server.attach(id); }
+                continue;
+            }
+            for (uint8_t p = 0; p < players - bots; ++p) {
+                const int8_t* d = dirs[rng() % 4];
+                const RoomWorld::Player& pl = view.players[p];
+                uint8_t flags = view.G[pl.y][pl.x] == 1 ? RoomInput::PRESS : RoomInput::HELD;
+                clients[i].post(RoomInput{ p, d[0], d[1], flags });
+            }
+        }
+        std::this_thread::sleep_until(passStart + std::chrono::duration<double>(passSeconds));
+    }
+}
+
+// p99 lateness of a bare sleep_until at the tick rate: the floor any scheduler here sits on.
+static double timerFloorMicros(double hz) {
+    typedef std::chrono::steady_clock Clock;
+    std::vector<double> late;
+    auto due = Clock::now();
+    for (int i = 0; i < (int)(hz * 2); ++i) {
+        due += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / hz));
+        std::this_thread::sleep_until(due);
+        late.push_back(std::chrono::duration<double, std::micro>(Clock::now() - due).count());
+    }
+    std::sort(late.begin(), late.end());
+    return late[late.size() * 99 / 100];
+}
+
+static Row runStep(const BenchConfig& c, size_t rooms, double maxLoad) {
+    RoomServerConfig sc;
+    sc.workers = c.workers;
+    sc.tickHz = c.hz;
+    sc.maxLoad = maxLoad;
+    RoomServer server(sc);
+
+    std::vector<uint32_t> ids;
+    std::vector<RoomClient> clients;
+    ids.reserve(rooms);
+    clients.reserve(rooms);
+    // add rooms over the first half second so admission control has a cost estimate to go on
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < rooms; ++i) {
+        uint32_t id = server.createRoom((uint32_t)(i * 2654435761u + 1), c.players, c.bots, c.botDepth);
+        if (id) { ids.push_back(id); clients.push_back(server.attach(id)); }
+        if ((i & 255) == 255)
+            std::this_thread::sleep_until(t0 + std::chrono::duration<double>(0.5 * (i + 1) / rooms));
+    }
+
+    std::atomic<bool> stop(false);
+    std::thread feeder(feed, std::ref(server), std::ref(ids), std::ref(clients), std::cref(stop), 7u, c.players, c.bots, c.botDepth);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1000));   // warm-up
+    server.resetStats();
+    std::this_thread::sleep_for(std::chrono::duration<double>(c.seconds));
+    Row row;
+    row.st = server.stats();
+    stop = true;
+    feeder.join();
+
+    row.offered = rooms;
+    row.admitted = ids.size();
+    row.ratePerRoom = row.admitted ? row.st.ticks / (c.seconds * row.admitted) : 0;
+    return row;
+}
+
+static void printHeader() {
+    std::printf("%8s %8s %9s %6s %8s %9s %9s %9s %9s %8s %8s\n",
+        "offered", "rooms", "ticks/s", "util", "tick us", "jit p50", "jit p99", "jit max", "skipped", "steals", "refused");
+}
+
+static void printRow(const Row& r) {
+    std::printf("%8zu %8zu %9.2f %5.0f%% %8.2f %7.2fms %7.2fms %7.2fms %9llu %8llu %8llu\n",
+        r.offered, r.admitted, r.ratePerRoom, 100 * r.st.utilisation, r.st.avgTickMicros,
+        r.st.jitterP50 / 1000, r.st.jitterP99 / 1000, r.st.jitterMax / 1000,
+        (unsigned long long)r.st.skipped, (unsigned long long)r.st.steals, (unsigned long long)r.st.rejected);
+}
+
+int main(int argc, char** argv) {
+    BenchConfig c;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const char* k = argv[i];
+        const char* v = argv[i + 1];
+        if (!std::strcmp(k, "--workers")) c.workers = (unsigned)std::atoi(v);
+        else if (!std::strcmp(k, "--hz")) c.hz = std::atof(v);
+        else if (!std::strcmp(k, "--seconds")) c.seconds = std::atof(v);
+        else if (!std::strcmp(k, "--start")) c.start = (size_t)std::atoll(v);
+        else if (!std::strcmp(k, "--max-rooms")) c.maxRooms = (size_t)std::atoll(v);
+        else if (!std::strcmp(k, "--players")) c.players = std::atoi(v);
+        else if (!std::strcmp(k, "--bots")) c.bots = std::atoi(v);
+        else if (!std::strcmp(k, "--bot-depth")) c.botDepth = std::atoi(v);
+        else { std::fprintf(stderr, "unknown option %s\n", k); return 1; }
+    }
+    if (c.workers == 0 || c.hz <= 0 || c.seconds <= 0 || c.start == 0) {
+        std::fprintf(stderr, "need --workers > 0, --hz > 0, --seconds > 0, --start > 0\n");
+        return 1;
+    }
+    unsigned hw = std::thread::hardware_concurrency();
+    unsigned cores = hw ? std::min(c.workers, hw) : c.workers;
+    const double periodUs = 1e6 / c.hz;
+    const double floorUs = timerFloorMicros(c.hz);
+    std::printf("%u workers on %u usable cores, %d players (%d bots) per room, %.0f Hz (period %.2f ms), sizeof(RoomWorld) %zu bytes\n",
+        c.workers, cores, c.players, c.bots, c.hz, periodUs / 1000, sizeof(RoomWorld));
+    std::printf("OS timer floor: bare sleep_until wakes up to %.2f ms late (p99)\n\n", floorUs / 1000);
+
+    std::printf("ramp, admission off:\n");
+    printHeader();
+    size_t best = 0;
+    for (size_t rooms = c.start; rooms <= c.maxRooms; rooms *= 2) {
+        Row r = runStep(c, rooms, 0);
+        printRow(r);
+        if (r.ratePerRoom < 0.99 * c.hz || r.st.jitterP99 > floorUs + periodUs) break;
+        best = rooms;
+    }
+    if (!best) {
+        std::printf("\nno step held %.0f Hz; try a smaller --start\n", c.hz);
+        return 0;
+    }
+    std::printf("\nheld %.0f Hz with p99 jitter within one period of the floor up to %zu rooms: %.0f rooms per core\n\n",
+        c.hz, best, (double)best / cores);
+
+    std::printf("overload, %zu rooms offered:\n", best * 4);
+    printHeader();
+    Row open = runStep(c, best * 4, 0);
+    printRow(open);
+    Row guarded = runStep(c, best * 4, 0.85);
+    printRow(guarded);
+    std::printf("(first row admission off, second row maxLoad 0.85)\n");
+    return 0;
+}
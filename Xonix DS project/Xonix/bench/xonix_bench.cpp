@@ -0,0 +1,489 @@
+﻿// Microbenchmarks for the game's hot kernels, measured on the game's own code.
+// This file builds Xonix.cpp in (without its main), so there is nothing to
+// keep in sync. Build the XonixBench project in Xonix.sln, or elsewhere:
+//   gcc -O2 -c ../vendor/scrypt/scrypt.c -o scrypt.o
+//   g++ -O2 -std=c++14 -pthread -I<SFML>/include xonix_bench.cpp scrypt.o
+//       -L<SFML>/lib -lsfml-graphics -lsfml-window -lsfml-system -o xonix_bench
+// Needs no window, network or account: every input is generated, and any
+// file it writes (bench_*) is removed afterwards.
+//
+// Each benchmark is calibrated to run for about --min-time / 5 per sample and
+// sampled 5 times; the median ns per operation is reported, with the fastest
+// sample as a noise floor.
+//
+// Usage: xonix_bench [--filter SUBSTR] [--min-time S] [--json FILE]
+//                    [--baseline FILE] [--threshold PCT]
+// --json writes the results for a later --baseline. With --baseline, any
+// benchmark whose fastest sample is more than PCT percent (default 10) slower
+// than the baseline's is reported, and the exit code is 1. The fastest sample
+// is compared rather than the median because a busy machine only ever adds time.
+
+#define XONIX_NO_MAIN
+#include "../Xonix.cpp"
+#include <iomanip>
+
+struct BenchResult {
+    string name;
+    double nsPerOp, minNs;
+    uint64_t iterations;   // per sample
+};
+
+class BenchSuite {
+    double minTime;
+    string filter;
+    vector<BenchResult> results;
+
+    template<typename Op>
+    static double timeBatch(Op& op, uint64_t iters) {
+        auto t0 = chrono::steady_clock::now();
+        op(iters);
+        return chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+    }
+
+public:
+    BenchSuite(double minSeconds, const string& only) : minTime(minSeconds), filter(only) {}
+
+    bool wants(const string& name) const { return filter.empty() || name.find(filter) != string::npos; }
+
+    // op(n) performs the measured operation n times.
+    template<typename Op>
+    void run(const string& name, Op op) {
+        if (!wants(name)) return;
+        const double target = minTime / 5;
+        uint64_t iters = 1;
+        for (;;) {
+            double t = timeBatch(op, iters);
+            if (t >= target || iters >= (1ull << 32)) break;
+            double scale = t > 0 ? target / t * 1.2 : 16;
+            iters = (uint64_t)(iters * min(max(scale, 2.0), 16.0));
+        }
+        vector<double> ns;
+        for (int s = 0; s < 5; ++s) ns.push_back(timeBatch(op, iters) * 1e9 / iters);
+        sort(ns.begin(), ns.end());
+        BenchResult r{ name, ns[2], ns[0], iters };
+        results.push_back(r);
+        printf("%-28s %14.1f ns/op   (min %.1f, %llu iterations x 5)\n", name.c_str(), r.nsPerOp, r.minNs,
+            (unsigned long long)iters);
+        fflush(stdout);
+    }
+
+    const vector<BenchResult>& all() const { return results; }
+
+    bool writeJson(const char* path) const {
+        ofstream out(path, ios::trunc);
+        if (!out) return false;
+        out << fixed << setprecision(3) << "{\"suite\":\"xonix_bench\",\"results\":[\n";
+        for (size_t i = 0; i < results.size(); ++i)
+            out << "  {\"name\":\"" << results[i].name << "\",\"ns_per_op\":" << results[i].nsPerOp
+                << ",\"min_ns\":" << results[i].minNs << ",\"iterations\":" << results[i].iterations << "}"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        out << "]}\n";
+        return (bool)out;
+    }
+};
+
+// Reads name -> min_ns back from a file written by writeJson.
+static unordered_map<string, double> readBaseline(const char* path) {
+    unordered_map<string, double> base;
+    ifstream in(path);
+    string text((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    const string nameKey = "\"name\":\"", nsKey = "\"min_ns\":";
+    for (size_t pos = text.find(nameKey); pos != string::npos; pos = text.find(nameKey, pos)) {
+        pos += nameKey.size();
+        size_t end = text.find('"', pos);
+        size_t ns = text.find(nsKey, end);
+        if (end == string::npos || ns == string::npos) break;
+        base[text.substr(pos, end - pos)] = atof(text.c_str() + ns + nsKey.size());
+    }
+    return base;
+}
+
+// ---- fixtures ---------------------------------------------------------------
+
+// Border plus the leftmost fillPercent of the interior columns walled in, the
+// way captured territory grows from the edges.
+static void fillBoard(int (&g)[M][N], int fillPercent) {
+    int wallCols = (N - 2) * fillPercent / 100;
+    for (int i = 0; i < M; i++)
+        for (int j = 0; j < N; j++)
+            g[i][j] = (i == 0 || j == 0 || i == M - 1 || j == N - 1 || j <= wallCols) ? 1 : 0;
+}
+
+// A trail from the top border down through the open area and back up, as a capture closes it.
+static void addTrail(int (&g)[M][N]) {
+    int c = N - 8;
+    for (int i = 1; i < M / 2; i++) g[i][c] = 2;
+    for (int j = c; j < N - 3; j++) g[M / 2][j] = 2;
+    for (int i = 1; i <= M / 2; i++) g[i][N - 3] = 2;
+}
+
+// The board the kernels below run on, a global as the game's grid once was.
+static int grid[M][N];
+
+// The recursive flood and the capture step the game used before GridKernels.h:
+// count, flood from the enemies, fill, count again. Kept as the reference the
+// kernels are checked and timed against.
+static void drop(int r, int c) {
+    if (grid[r][c] == 0) grid[r][c] = -1;
+    if (grid[r - 1][c] == 0) drop(r - 1, c);
+    if (grid[r + 1][c] == 0) drop(r + 1, c);
+    if (grid[r][c - 1] == 0) drop(r, c - 1);
+    if (grid[r][c + 1] == 0) drop(r, c + 1);
+}
+
+static int captureLegacy(const Enemy* enemies, int enemyCount) {
+    int trail = 0, before = 0;
+    for (int i = 0; i < M; i++) for (int j = 0; j < N; j++)
+    {
+        if (grid[i][j] == 2) trail++; else if (grid[i][j] == 0) before++;
+    }
+    for (int k = 0; k < enemyCount; k++) drop(enemies[k].y / ts, enemies[k].x / ts);
+    for (int i = 0; i < M; i++)
+        for (int j = 0; j < N; j++) grid[i][j] = (grid[i][j] == -1 ? 0 : 1);
+    int after = 0;
+    for (int i = 0; i < M; i++)
+        for (int j = 0; j < N; j++)
+            if (grid[i][j] == 0) after++;
+    return trail + (before - after);
+}
+
+static volatile long long gBenchSink;
+
+int main(int argc, char** argv) {
+    double minTime = 1.0, threshold = 10;
+    string filter;
+    const char* jsonPath = nullptr;
+    const char* baselinePath = nullptr;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "--filter")) filter = argv[i + 1];
+        else if (!strcmp(argv[i], "--min-time")) minTime = atof(argv[i + 1]);
+        else if (!strcmp(argv[i], "--json")) jsonPath = argv[i + 1];
+        else if (!strcmp(argv[i], "--baseline")) baselinePath = argv[i + 1];
+        else if (!strcmp(argv[i], "--threshold")) threshold = atof(argv[i + 1]);
+        else { fprintf(stderr, "unknown option %s\n", argv[i]); return 2; }
+    }
+    srand(1);
+    BenchSuite suite(minTime, filter);
+
+    // capture: the old drop() alone, the old capture step, and captureBoard() on
+    // the stock board as the game runs it (fixed dims) and through the
+    // runtime-sized path, by how much of the board is already wall
+    static int board[M][N];
+    static int stack[M * N + 1];
+    const int fills[] = { 0, 25, 50, 75 };
+    for (int fill : fills) {
+        fillBoard(board, fill);
+        addTrail(board);
+        Enemy enemies[4];
+        for (int k = 0; k < 4; k++) { enemies[k].x = (N - 5 - 2 * k) * ts + ts / 2; enemies[k].y = (M - 3 - k) * ts + ts / 2; }
+        if (fill == 0)
+            suite.run("grid_reset", [&](uint64_t n) {   // the board copy both rows below include
+                for (uint64_t i = 0; i < n; ++i) { memcpy(grid, board, sizeof(grid)); gBenchSink += grid[1][1]; }
+            });
+        suite.run("drop/fill" + to_string(fill), [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                memcpy(grid, board, sizeof(grid));
+                for (int k = 0; k < 4; k++) drop(enemies[k].y / ts, enemies[k].x / ts);
+                gBenchSink += grid[M / 2][N / 2];
+            }
+        });
+        memcpy(grid, board, sizeof(grid));
+        int expected = captureLegacy(enemies, 4), legacy[M][N];
+        memcpy(legacy, grid, sizeof(grid));
+        memcpy(grid, board, sizeof(grid));
+        if (captureBoard(&grid[0][0], RuntimeDims{ M, N }, enemies, 4, stack) != expected || memcmp(grid, legacy, sizeof(grid))) {
+            fprintf(stderr, "captureBoard disagrees with the old capture at fill %d\n", fill);
+            return 2;
+        }
+        suite.run("capture_legacy/fill" + to_string(fill), [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                memcpy(grid, board, sizeof(grid));
+                gBenchSink += captureLegacy(enemies, 4);
+            }
+        });
+        suite.run("capture/fill" + to_string(fill), [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                memcpy(grid, board, sizeof(grid));
+                gBenchSink += captureBoard(&grid[0][0], StockDims(), enemies, 4, stack);
+            }
+        });
+        suite.run("capture_runtime/fill" + to_string(fill), [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                memcpy(grid, board, sizeof(grid));
+                gBenchSink += captureBoard(&grid[0][0], RuntimeDims{ M, N }, enemies, 4, stack);
+            }
+        });
+    }
+
+    // Enemy::move: one frame of every enemy bouncing around a quarter-filled board
+    fillBoard(board, 25);
+    const int enemyCounts[] = { 4, 16, 64, 256 };
+    for (int count : enemyCounts) {
+        memcpy(grid, board, sizeof(grid));
+        srand(count);   // same enemies whatever --filter skipped
+        const vector<Enemy> start(count);
+        vector<Enemy> enemies;
+        suite.run("enemy_move/" + to_string(count), [&](uint64_t n) {
+            enemies = start;   // every batch replays the same frames
+            for (uint64_t i = 0; i < n; ++i)
+                for (Enemy& e : enemies) e.move(&grid[0][0], StockDims());
+            gBenchSink += enemies[0].x;
+        });
+        suite.run("enemy_move_runtime/" + to_string(count), [&](uint64_t n) {
+            enemies = start;
+            const RuntimeDims dims{ M, N };
+            for (uint64_t i = 0; i < n; ++i)
+                for (Enemy& e : enemies) bounceEnemy(&grid[0][0], dims, e);
+            gBenchSink += enemies[0].x;
+        });
+    }
+
+    // Leaderboard: add with a pool of returning names, save to a scratch file
+    {
+        Leaderboard lb;
+        char names[64][MAX_NAME_LEN];
+        for (int i = 0; i < 64; ++i) snprintf(names[i], MAX_NAME_LEN, "player%02d", i);
+        mt19937 rng(5);
+        suite.run("leaderboard/add", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) lb.add(names[rng() & 63], (int)(rng() % 5000));
+        });
+        suite.run("leaderboard/save", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) lb.save("bench_leaderboard.txt");
+        });
+        remove("bench_leaderboard.txt");
+    }
+
+    // UserManager::loginUser: the last account of a generated users file. Records
+    // use a cheap scrypt cost so the file handling shows; one row uses the real cost.
+    {
+        AuthConfig cheap;
+        cheap.log2N = 4; cheap.r = 1; cheap.p = 1;
+        const int sizes[] = { 100, 1000, 10000 };
+        for (int users : sizes) {
+            string file = "bench_users_" + to_string(users) + ".txt";
+            {
+                ofstream out(file, ios::trunc);
+                string record = hashPassword("secret", cheap);
+                for (int u = 0; u < users; ++u) out << "user" << u << " " << record << "\n";
+            }
+            UserManager um(file, cheap);
+            string last = "user" + to_string(users - 1);
+            suite.run("login/users" + to_string(users), [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i) gBenchSink += um.loginUser(last, "secret");
+            });
+            remove(file.c_str());
+        }
+        AuthConfig real;
+        string file = "bench_users_real.txt";
+        {
+            ofstream out(file, ios::trunc);
+            out << "someone " << hashPassword("secret", real) << "\n";
+        }
+        UserManager um(file, real);
+        suite.run("login/scrypt_default_cost", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) gBenchSink += um.loginUser("someone", "secret");
+        });
+        remove(file.c_str());
+    }
+
+    // AVL theme catalog: insert (per theme, building a fresh catalog), findByID, findByName
+    {
+        const int sizes[] = { 1000, 100000 };
+        for (int count : sizes) {
+            vector<Theme> themes;
+            for (int i = 0; i < count; ++i) {
+                char name[32];
+                snprintf(name, sizeof(name), "Theme %06d", i);
+                themes.emplace_back(i + 1, name, "generated");
+            }
+            mt19937 rng(9);
+            shuffle(themes.begin(), themes.end(), rng);
+            suite.run("avl/insert" + to_string(count), [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; i += count) {
+                    ThemeCatalog catalog;
+                    for (int k = 0; k < count && i + k < n; ++k) catalog.insert(themes[k]);
+                    gBenchSink += (long long)catalog.size();
+                }
+            });
+            ThemeCatalog catalog;
+            for (const Theme& t : themes) catalog.insert(t);
+            suite.run("avl/findByID" + to_string(count), [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i) gBenchSink += catalog.findByID(1 + (int)(rng() % count))->id;
+            });
+            vector<string> probes;
+            for (int i = 0; i < 1024; ++i) probes.push_back(themes[rng() % count].name);
+            suite.run("avl/findByName" + to_string(count), [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i) gBenchSink += catalog.findByName(probes[i & 1023])->id;
+            });
+        }
+    }
+
+    // the single-player sim's hand-off to the render thread: write a frame, publish, fetch
+    {
+        static TripleBuffer<SinglePlayerFrame<StockDims>> frames;
+        fillBoard(grid, 50);
+        suite.run("frame_handoff", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                SinglePlayerFrame<StockDims>& f = frames.writeSlot();
+                memcpy(f.grid, grid, sizeof(f.grid));
+                f.score = (int)i;
+                frames.publish();
+                frames.fetch();
+                gBenchSink += frames.readSlot().score;
+            }
+        });
+    }
+
+    // event map: one tick and a pocket capture on a 10000 x 10000 board, which
+    // should cost what they cost on a small one
+    if (suite.wants("bigmap/tick") || suite.wants("bigmap/capture_pocket")) {
+        static BigMapWorld world;
+        const int P = 20;   // the pocket is rows/cols 1..P, closed by a trail along row and column P + 1
+        for (uint32_t seed = 1;; ++seed) {
+            world.reset(EVENT_MAP_ROWS, EVENT_MAP_COLS, (int)((long long)EVENT_MAP_ROWS * EVENT_MAP_COLS / EVENT_MAP_CELLS_PER_ENEMY), seed);
+            bool clear = true;
+            for (const BigMapWorld::Enemy& e : world.enemies)
+                if (e.y / ts <= P + 1 && e.x / ts <= P + 1) clear = false;
+            if (clear) break;
+        }
+        world.setViewport(0, 0, M - 1, N - 1);
+        suite.run("bigmap/tick", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                world.alive = true;
+                world.tick();
+            }
+            gBenchSink += world.enemies[0].x;
+        });
+        suite.run("bigmap/capture_pocket", [&](uint64_t n) {   // includes redrawing the pocket and trail
+            for (uint64_t i = 0; i < n; ++i) {
+                for (int r = 1; r <= P; ++r)
+                    for (int c = 1; c <= P; ++c) world.board.set(r, c, 0);
+                world.trail.clear();
+                for (int r = 1; r <= P + 1; ++r) { world.board.set(r, P + 1, BigMapWorld::TRAIL); world.trail.push_back({ r, P + 1 }); }
+                for (int c = P; c >= 1; --c) { world.board.set(P + 1, c, BigMapWorld::TRAIL); world.trail.push_back({ P + 1, c }); }
+                world.px = 0; world.py = P + 1;
+                world.alive = world.drawing = true;
+                world.stepTimer = 0;
+                world.tick();
+                gBenchSink += world.lastCapture.filled;
+            }
+        });
+        printf("  bigmap %dx%d: %d chunks in use, %d KB\n", world.board.rows(), world.board.cols(),
+            (int)world.board.chunksInUse(), (int)(world.board.bytesUsed() / 1024));
+    }
+
+    // timer wheels: one tick of a room's wheel with 12 effects pending (across
+    // 4096 rooms, each fired effect rescheduled), and scheduling then
+    // cancelling an effect
+    {
+        static TimerWheel<RoomWorld::TIMERS> wheels[4096];
+        mt19937 rng(11);
+        for (auto& w : wheels) {
+            w.reset(0);
+            for (int k = 0; k < 12; ++k) w.schedule(1 + rng() % 20000, RoomWorld::THAW);
+        }
+        uint32_t now = 0;
+        suite.run("timers/room_tick", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; i += 4096) {
+                ++now;
+                for (auto& w : wheels)
+                    w.advance(now, [&](uint8_t kind, uint8_t) { w.schedule(now + 1 + rng() % 20000, kind); });
+            }
+            gBenchSink += wheels[0].size();
+        });
+        suite.run("timers/schedule_cancel", [&](uint64_t n) {
+            TimerWheel<RoomWorld::TIMERS>& w = wheels[0];
+            for (uint64_t i = 0; i < n; ++i) gBenchSink += w.cancel(w.schedule(now + 1 + (uint32_t)(i * 97 % 20000), RoomWorld::THAW));
+        });
+    }
+
+    // level packs: mapping a 1000-level pack and reading its index (what the
+    // select screen needs), starting a level from it, and, for scale, what
+    // parsing the same levels from source would cost per level
+    if (suite.wants("levels/")) {
+        const int LEVELS = 1000;
+        mt19937 rng(5);
+        string source;
+        for (int i = 0; i < LEVELS; ++i) {
+            char line[64];
+            snprintf(line, sizeof(line), "level Bench %04d\n", i);
+            source += line;
+            for (int k = 0; k < 6; ++k) {
+                int r = 2 + rng() % (M - 8), c = 2 + rng() % (N - 8);
+                snprintf(line, sizeof(line), "wall %d %d %d %d\n", r, c, r + 2, c + 4);
+                source += line;
+            }
+            for (int k = 0; k < 6; ++k) source += k < 5 ? "bouncer 1 1\n" : "hunter 23 38\n";
+            source += "powerup 20\n";
+        }
+        vector<uint8_t> pack;
+        string err;
+        if (!compileLevels(source, pack, err)) { fprintf(stderr, "level bench: %s\n", err.c_str()); return 2; }
+        {
+            ofstream out("bench_levels.xlp", ios::binary);
+            out.write((const char*)pack.data(), (streamsize)pack.size());
+        }
+        suite.run("levels/open_index", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                LevelPack p;
+                p.open("bench_levels.xlp");
+                for (int k = 0; k < p.size(); ++k) gBenchSink += p.info(k).name[6] + p.info(k).hunters;
+            }
+        });
+        {
+            LevelPack mapped;   // closed before the file is removed
+            mapped.open("bench_levels.xlp");
+            int board[M * N];
+            suite.run("levels/start", [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i) {
+                    LevelView v;
+                    int top = 0, left;
+                    if (mapped.level((int)(i % LEVELS), v)) v.place(board, M, N, top, left);
+                    gBenchSink += board[M * N / 2] + top;
+                }
+            });
+        }
+        const string one = source.substr(0, source.find("level", 1));
+        suite.run("levels/parse_source", [&](uint64_t n) {
+            vector<uint8_t> out;
+            for (uint64_t i = 0; i < n; ++i) gBenchSink += compileLevels(one, out, err);
+        });
+        printf("  %d levels, %d KB pack\n", LEVELS, (int)(pack.size() / 1024));
+        remove("bench_levels.xlp");
+    }
+
+    // saveGame / loadGame of a mid-game state
+    {
+        GameState s;
+        memset((void*)&s, 0, sizeof(s));
+        fillBoard(s.grid, 50);
+        suite.run("savegame", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) gBenchSink += saveGame(s, "bench_save.dat");
+        });
+        suite.run("loadgame", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) gBenchSink += loadGame(s, "bench_save.dat");
+        });
+        remove("bench_save.dat");
+    }
+
+    if (jsonPath && !suite.writeJson(jsonPath)) { fprintf(stderr, "cannot write %s\n", jsonPath); return 2; }
+
+    if (baselinePath) {
+        unordered_map<string, double> base = readBaseline(baselinePath);
+        if (base.empty()) { fprintf(stderr, "no results in %s\n", baselinePath); return 2; }
+        int regressions = 0;
+        printf("\nagainst %s (threshold +%.0f%%):\n", baselinePath, threshold);
+        for (const BenchResult& r : suite.all()) {
+            auto it = base.find(r.name);
+            if (it == base.end() || it->second <= 0) continue;
+            double change = (r.minNs - it->second) / it->second * 100;
+            bool bad = change > threshold;
+            regressions += bad;
+            printf("%-28s %12.1f -> %12.1f ns  %+7.1f%%%s\n", r.name.c_str(), it->second, r.minNs, change,
+                bad ? "  REGRESSION" : "");
+        }
+        printf("%d regression%s\n", regressions, regressions == 1 ? "" : "s");
+        return regressions ? 1 : 0;
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+"""Thin ctypes wrapper over the Xonix vector environment (xonix_env.h).
+
+    env = XonixVecEnv(num_envs=1024, threads=4)
+    obs = env.reset()
+    env.actions[:] = policy(obs)          # or env.step(actions)
+    obs, reward, done = env.step()
+
+All arrays are numpy views of the buffers the library writes into; nothing is
+copied per step. They are overwritten by the next step(), so copy what you keep.
+In "bytes" mode obs["grid"] is the live board (0 open, 1 wall, 2 trail) and
+must not be written to.
+
+The library is looked for next to this file (XonixEnv.dll from the XonixEnv
+project, or libxonix_env.so built as in xonix_env.h); pass lib_path otherwise.
+"""
+import ctypes
+import os
+import sys
+
+import numpy as np
+
+NOOP, LEFT, RIGHT, UP, DOWN, FREEZE = range(6)
+PLAYER_FIELDS = 6
+
+
+def _load(path=None):
+    if path is None:
+        here = os.path.dirname(os.path.abspath(__file__))
+        name = {"win32": "XonixEnv.dll", "darwin": "libxonix_env.dylib"}.get(sys.platform, "libxonix_env.so")
+        path = os.path.join(here, name)
+    lib = ctypes.CDLL(path)
+    p = ctypes.c_void_p
+    lib.xonix_env_create.restype = p
+    lib.xonix_env_create.argtypes = [ctypes.c_int, ctypes.c_int, ctypes.c_int, ctypes.c_uint32, ctypes.c_int, ctypes.c_int]
+    lib.xonix_env_destroy.argtypes = [p]
+    lib.xonix_env_dims.argtypes = [ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
+    lib.xonix_env_grid_bytes.argtypes = [p]
+    lib.xonix_env_enemies.argtypes = [p]
+    lib.xonix_env_bind.argtypes = [p] + [p] * 6
+    lib.xonix_env_reset.argtypes = [p]
+    lib.xonix_env_step.argtypes = [p]
+    return lib
+
+
+class XonixVecEnv:
+    def __init__(self, num_envs, enemies=4, obs="bytes", seed=1, threads=1, max_steps=2000, lib_path=None):
+        self._lib = _load(lib_path)
+        mode = {"bytes": 0, "bits": 1}[obs]
+        self._env = self._lib.xonix_env_create(num_envs, enemies, mode, seed, threads, max_steps)
+        if not self._env:
+            raise RuntimeError("xonix_env_create failed")
+        rows, cols = ctypes.c_int(), ctypes.c_int()
+        self._lib.xonix_env_dims(ctypes.byref(rows), ctypes.byref(cols))
+        self.rows, self.cols = rows.value, cols.value
+        self.num_envs = num_envs
+        self.enemies = self._lib.xonix_env_enemies(self._env)
+        grid_bytes = self._lib.xonix_env_grid_bytes(self._env)
+        if mode == 0:
+            self.grid = np.zeros((num_envs, self.rows, self.cols), np.uint8)
+        else:
+            self.grid = np.zeros((num_envs, 2, grid_bytes // 2), np.uint8)   # wall plane, trail plane
+        self.player = np.zeros((num_envs, PLAYER_FIELDS), np.int16)
+        self.enemy_pos = np.zeros((num_envs, self.enemies, 2), np.int16)
+        self.reward = np.zeros(num_envs, np.float32)
+        self.done = np.zeros(num_envs, np.uint8)
+        self.actions = np.zeros(num_envs, np.uint8)
+        arrays = (self.grid, self.player, self.enemy_pos, self.reward, self.done, self.actions)
+        if self._lib.xonix_env_bind(self._env, *[a.ctypes.data for a in arrays]) != 0:
+            raise RuntimeError("xonix_env_bind failed")
+
+    def _obs(self):
+        return {"grid": self.grid, "player": self.player, "enemies": self.enemy_pos}
+
+    def reset(self):
+        self._lib.xonix_env_reset(self._env)
+        return self._obs()
+
+    def step(self, actions=None):
+        if actions is not None:
+            np.copyto(self.actions, actions, casting="unsafe")
+        self._lib.xonix_env_step(self._env)
+        return self._obs(), self.reward, self.done
+
+    def close(self):
+        if self._env:
+            self._lib.xonix_env_destroy(self._env)
+            self._env = None
+
+    def __del__(self):
+        self.close()
@@ -0,0 +1,50 @@
+#ifndef XONIX_ENV_EXPORTS
+#define XONIX_ENV_EXPORTS
+#endif
+#include "xonix_env.h"
+#include <new>
+#include "VecEnv.h"
+
+
+////////////////////////////////  XONIX ENV C API /////////////////////////////////////
+
+static_assert((int)XONIX_PLAYER_FIELDS == (int)VecEnv::PLAYER_FIELDS, "player layout");
+static_assert((int)XONIX_ACTION_COUNT == (int)VecEnv::ACTION_COUNT, "action numbering");
+
+struct XonixEnv : VecEnv {
+    XonixEnv(size_t count, int enemies, ObsMode mode, uint32_t seed, unsigned threads, uint32_t maxSteps)
+        : VecEnv(count, enemies, mode, seed, threads, maxSteps) {}
+};
+
+// Nothing may throw across the C boundary.
+extern "C" XonixEnv* xonix_env_create(int num_envs, int enemies, int obs_mode, uint32_t seed, int threads, int max_steps) {
+    if (num_envs < 1 || (obs_mode != XONIX_OBS_BYTES && obs_mode != XONIX_OBS_BITS)) return nullptr;
+    try {
+        return new XonixEnv((size_t)num_envs, enemies, (VecEnv::ObsMode)obs_mode, seed,
+            threads > 1 ? (unsigned)threads : 1u, max_steps > 0 ? (uint32_t)max_steps : 0u);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+extern "C" void xonix_env_destroy(XonixEnv* env) { delete env; }
+
+extern "C" void xonix_env_dims(int* rows, int* cols) {
+    if (rows) *rows = M;
+    if (cols) *cols = N;
+}
+
+extern "C" int xonix_env_grid_bytes(const XonixEnv* env) { return env ? (int)env->gridBytes() : 0; }
+extern "C" int xonix_env_enemies(const XonixEnv* env) { return env ? env->enemyCount() : 0; }
+
+extern "C" int xonix_env_bind(XonixEnv* env, uint8_t* grid, int16_t* player, int16_t* enemies,
+    float* reward, uint8_t* done, const uint8_t* actions) {
+    if (!env || !grid || !player || !enemies || !reward || !done || !actions) return -1;
+    VecEnv::Buffers b = { grid, player, enemies, reward, done, actions };
+    env->bind(b);
+    return 0;
+}
+
+extern "C" void xonix_env_reset(XonixEnv* env) { if (env) env->reset(); }
+extern "C" void xonix_env_step(XonixEnv* env) { if (env) env->step(); }
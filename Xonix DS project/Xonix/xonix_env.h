@@ -0,0 +1,60 @@
+#pragma once
+#include <stdint.h>
+
+/* C API over VecEnv (see VecEnv.h) for training bots from other languages.
+ * Build as XonixEnv.dll with the XonixEnv project, or elsewhere with
+ *   g++ -O2 -std=c++14 -shared -fPIC -pthread xonix_env.cpp -o libxonix_env.so
+ * python/xonix_env.py loads it with ctypes and binds numpy arrays.
+ *
+ * Usage: create, bind caller-owned buffers once, reset, then fill actions and
+ * call step as often as you like. All buffers are contiguous, world-major:
+ *   grid     num_envs * xonix_env_grid_bytes(env)    uint8
+ *   player   num_envs * XONIX_PLAYER_FIELDS           int16 (x, y, dx, dy, power-ups, freeze steps left)
+ *   enemies  num_envs * 2 * enemies                   int16 (x, y in pixels)
+ *   reward   num_envs                                 float
+ *   done     num_envs                                 uint8 (0 running, 1 terminated, 2 truncated)
+ *   actions  num_envs                                 uint8 (XONIX_ACTION_*)
+ * A world reporting done has already been reset; its observation is the
+ * first of the next episode. */
+
+#if defined(_WIN32)
+#if defined(XONIX_ENV_EXPORTS)
+#define XONIX_ENV_API __declspec(dllexport)
+#else
+#define XONIX_ENV_API __declspec(dllimport)
+#endif
+#else
+#define XONIX_ENV_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct XonixEnv XonixEnv;
+
+enum { XONIX_OBS_BYTES = 0, XONIX_OBS_BITS = 1 };
+enum {
+    XONIX_ACTION_NOOP = 0, XONIX_ACTION_LEFT, XONIX_ACTION_RIGHT, XONIX_ACTION_UP, XONIX_ACTION_DOWN,
+    XONIX_ACTION_FREEZE, XONIX_ACTION_COUNT
+};
+enum { XONIX_PLAYER_FIELDS = 6 };
+
+/* threads includes the calling thread; max_steps 0 never truncates. NULL on failure. */
+XONIX_ENV_API XonixEnv* xonix_env_create(int num_envs, int enemies, int obs_mode, uint32_t seed, int threads, int max_steps);
+XONIX_ENV_API void xonix_env_destroy(XonixEnv* env);
+
+/* Board size in cells and per-world buffer sizes. */
+XONIX_ENV_API void xonix_env_dims(int* rows, int* cols);
+XONIX_ENV_API int xonix_env_grid_bytes(const XonixEnv* env);
+XONIX_ENV_API int xonix_env_enemies(const XonixEnv* env);
+
+/* In XONIX_OBS_BYTES mode grid becomes the board itself: read it, never write it. 0 on success. */
+XONIX_ENV_API int xonix_env_bind(XonixEnv* env, uint8_t* grid, int16_t* player, int16_t* enemies,
+    float* reward, uint8_t* done, const uint8_t* actions);
+XONIX_ENV_API void xonix_env_reset(XonixEnv* env);
+XONIX_ENV_API void xonix_env_step(XonixEnv* env);
+
+#ifdef __cplusplus
+}
+#endif